@@ -0,0 +1,227 @@
+#include "CompressedLog.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zstd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+// End of the last whole frame in path, which is size bytes long; frames from
+// the last indexed one on are checked, since a crash can leave the final one
+// without its end. size itself if the file isn't compressed.
+uint64_t wholeFramesEnd(const std::string& path, uint64_t size)
+{
+    uint64_t start = 0;
+    for (const uint64_t offset : CompressedLog::readIndex(path)) {
+        if (offset < size)
+            start = offset;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(static_cast<std::streamoff>(start));
+    const std::string tail((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!CompressedLog::isCompressed(tail))
+        return size;
+
+    size_t pos = 0;
+    while (pos < tail.size()) {
+        const size_t frame = ZSTD_findFrameCompressedSize(tail.data() + pos, tail.size() - pos);
+        if (ZSTD_isError(frame))
+            break;
+        pos += frame;
+    }
+    return start + pos;
+}
+
+}  // namespace
+
+std::vector<uint64_t> CompressedLog::readIndex(const std::string& path)
+{
+    std::ifstream file(path + INDEX_SUFFIX, std::ios::binary);
+    if (!file.is_open())
+        return {};
+
+    std::vector<uint64_t> offsets;
+    uint64_t offset;
+    while (file.read(reinterpret_cast<char*>(&offset), sizeof(offset))) {
+        // anything out of order is left from before a crash; the later entry wins
+        while (!offsets.empty() && offsets.back() >= offset)
+            offsets.pop_back();
+        offsets.push_back(offset);
+    }
+    return offsets;
+}
+
+bool CompressedLog::isCompressed(std::string_view data)
+{
+    uint32_t magic;
+    if (data.size() < sizeof(magic))
+        return false;
+    std::memcpy(&magic, data.data(), sizeof(magic));
+    return magic == ZSTD_MAGICNUMBER;
+}
+
+////////////////////////////////////////////
+//            BlockCompressor             //
+////////////////////////////////////////////
+
+BlockCompressor::BlockCompressor(size_t blockBytes, int level)
+    : m_ctx(ZSTD_createCCtx())
+    , m_blockBytes(blockBytes)
+{
+    ZSTD_CCtx_setParameter(m_ctx, ZSTD_c_compressionLevel, level);
+    // so a frame damaged on disk fails to decompress instead of misreading
+    ZSTD_CCtx_setParameter(m_ctx, ZSTD_c_checksumFlag, 1);
+}
+
+BlockCompressor::~BlockCompressor()
+{
+    closeIndex();
+    ZSTD_freeCCtx(m_ctx);
+}
+
+void BlockCompressor::closeIndex()
+{
+    if (m_indexFd >= 0)
+        ::close(m_indexFd);
+    m_indexFd = -1;
+}
+
+void BlockCompressor::open(const std::string& path, bool truncate)
+{
+    // reopening the current file just carries on
+    if (path == m_path && !truncate)
+        return;
+
+    closeIndex();
+    m_path = path;
+    ZSTD_CCtx_reset(m_ctx, ZSTD_reset_session_only);
+    m_frameBytes = 0;
+
+    struct stat st;
+    m_offset = !truncate && ::stat(path.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+
+    // frames appended after one left unfinished by a crash can't be read, so
+    // cut the file back to its last whole frame first
+    bool dropFrames = false;
+    if (m_offset > 0) {
+        const uint64_t end = wholeFramesEnd(path, m_offset);
+        if (end < m_offset) {
+            LOG_WARN("Dropping unfinished frame at the end of " << path << " (offset " << end << ")");
+            if (::truncate(path.c_str(), static_cast<off_t>(end)) == 0) {
+                m_offset = end;
+                dropFrames = true;
+            } else {
+                LOG_ERROR("Failed to truncate " << path << ": " << std::strerror(errno));
+            }
+        }
+    }
+
+    const auto dir = std::filesystem::path(path).parent_path();
+    if (!dir.empty())
+        std::filesystem::create_directories(dir);
+
+    const std::string indexPath = path + CompressedLog::INDEX_SUFFIX;
+    const auto frames = dropFrames ? CompressedLog::readIndex(path) : std::vector<uint64_t>();
+    m_indexFd = ::open(indexPath.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (truncate || dropFrames ? O_TRUNC : O_APPEND), 0644);
+    if (m_indexFd < 0) {
+        LOG_ERROR("Failed to open " << indexPath << ": " << std::strerror(errno));
+        return;
+    }
+
+    // the index keeps only the frames left
+    for (const uint64_t offset : frames) {
+        if (offset < m_offset && ::write(m_indexFd, &offset, sizeof(offset)) != sizeof(offset))
+            LOG_ERROR("Failed to index " << m_path << ": " << std::strerror(errno));
+    }
+}
+
+void BlockCompressor::compress(std::string_view data, std::string& out)
+{
+    if (data.empty())
+        return;
+
+    // the index doesn't need to be durable: without it, readers start from the top
+    if (m_frameBytes == 0 && m_indexFd >= 0 && ::write(m_indexFd, &m_offset, sizeof(m_offset)) != sizeof(m_offset))
+        LOG_ERROR("Failed to index " << m_path << ": " << std::strerror(errno));
+
+    m_frameBytes += data.size();
+    stream(data, out, m_frameBytes >= m_blockBytes);
+}
+
+void BlockCompressor::finish(std::string& out)
+{
+    if (m_frameBytes > 0)
+        stream({}, out, true);
+}
+
+void BlockCompressor::stream(std::string_view data, std::string& out, bool endFrame)
+{
+    const size_t start = out.size();
+    ZSTD_inBuffer in{data.data(), data.size(), 0};
+    for (;;) {
+        const size_t used = out.size();
+        out.resize(used + ZSTD_CStreamOutSize());
+
+        ZSTD_outBuffer buffer{out.data() + used, ZSTD_CStreamOutSize(), 0};
+        const size_t remaining = ZSTD_compressStream2(m_ctx, &buffer, &in, endFrame ? ZSTD_e_end : ZSTD_e_flush);
+        out.resize(used + buffer.pos);
+
+        if (ZSTD_isError(remaining)) {
+            // what was flushed so far still makes a readable, if unfinished, frame
+            LOG_ERROR("Failed to compress " << m_path << ": " << ZSTD_getErrorName(remaining));
+            ZSTD_CCtx_reset(m_ctx, ZSTD_reset_session_only);
+            endFrame = true;
+            break;
+        }
+        if (remaining == 0)
+            break;
+    }
+
+    m_offset += out.size() - start;
+    if (endFrame)
+        m_frameBytes = 0;
+}
+
+////////////////////////////////////////////
+//           BlockDecompressor            //
+////////////////////////////////////////////
+
+BlockDecompressor::BlockDecompressor()
+    : m_ctx(ZSTD_createDCtx())
+{}
+
+BlockDecompressor::~BlockDecompressor()
+{
+    ZSTD_freeDCtx(m_ctx);
+}
+
+bool BlockDecompressor::decompress(std::string_view data, std::string& out)
+{
+    ZSTD_inBuffer in{data.data(), data.size(), 0};
+    for (;;) {
+        const size_t used = out.size();
+        out.resize(used + ZSTD_DStreamOutSize());
+
+        ZSTD_outBuffer buffer{out.data() + used, ZSTD_DStreamOutSize(), 0};
+        const size_t ret = ZSTD_decompressStream(m_ctx, &buffer, &in);
+        out.resize(used + buffer.pos);
+        if (ZSTD_isError(ret))
+            return false;
+        // a full output buffer may have more behind it
+        if (in.pos == in.size && buffer.pos < buffer.size)
+            return true;
+    }
+}
+
+void BlockDecompressor::reset()
+{
+    ZSTD_DCtx_reset(m_ctx, ZSTD_reset_session_only);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Log.h"
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+// A block-compressed file is a run of independent zstd frames, so zstdcat and
+// friends read it as is. Frames only end between writes, so each one starts on
+// a record or line boundary, and <file>.idx lists the offset of every frame as
+// a native uint64 so readers can start at any of them without decompressing
+// what comes before.
+struct CompressedLog
+{
+    static constexpr const char* INDEX_SUFFIX = ".idx";
+
+    // Offsets of the frames in path, ascending; entries past the end of the
+    // file belong to writes that haven't landed yet. Empty without an index.
+    static std::vector<uint64_t> readIndex(const std::string& path);
+
+    // whether data starts with a zstd frame
+    static bool isCompressed(std::string_view data);
+};
+
+// Compresses a file's writes into frames of about blockBytes each, keeping its
+// index up to date. Every compress() is flushed, so nothing written sits in the
+// compressor waiting for more; frames end at the first write boundary past blockBytes.
+class BlockCompressor
+{
+public:
+    explicit BlockCompressor(size_t blockBytes, int level = 1);
+    ~BlockCompressor();
+
+    BlockCompressor(const BlockCompressor&) = delete;
+    BlockCompressor& operator=(const BlockCompressor&) = delete;
+
+    // Subsequent output goes to the end of path, or to the start of it if it's
+    // being truncated, which truncates its index too. finish() the frame first.
+    void open(const std::string& path, bool truncate);
+
+    bool isOpen() const
+    {
+        return !m_path.empty();
+    }
+
+    // appends data, compressed, to out
+    void compress(std::string_view data, std::string& out);
+
+    // ends the current frame, if any, appending its last bytes to out
+    void finish(std::string& out);
+
+private:
+    void stream(std::string_view data, std::string& out, bool endFrame);
+    void closeIndex();
+
+    ZSTD_CCtx_s* m_ctx;
+    size_t m_blockBytes;
+
+    std::string m_path;
+    int m_indexFd = -1;
+    // compressed bytes in the file so far, and uncompressed bytes in the current frame
+    uint64_t m_offset = 0;
+    size_t m_frameBytes = 0;
+
+    CREATE_LOGGER("BlockCompressor");
+};
+
+// Streaming decompression of block-compressed data; frames may be fed in pieces.
+class BlockDecompressor
+{
+public:
+    BlockDecompressor();
+    ~BlockDecompressor();
+
+    BlockDecompressor(const BlockDecompressor&) = delete;
+    BlockDecompressor& operator=(const BlockDecompressor&) = delete;
+
+    // Appends what data decompresses to onto out. data continues whatever was
+    // fed before; false if it's corrupt, after which reset() before feeding more.
+    bool decompress(std::string_view data, std::string& out);
+
+    // forgets any partly fed frame, to start again at a frame boundary
+    void reset();
+
+private:
+    ZSTD_DCtx_s* m_ctx;
+};
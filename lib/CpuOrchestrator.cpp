@@ -22,6 +22,16 @@ static const char* roleToString(ThreadRole role)
     return "unknown";
 }
 
+static std::string formatCpuList(const std::vector<int>& cores)
+{
+    std::ostringstream oss;
+    for (size_t i = 0; i < cores.size(); ++i) {
+        if (i > 0) oss << ',';
+        oss << cores[i];
+    }
+    return oss.str();
+}
+
 std::vector<int> CpuOrchestrator::parseCpuList(const std::string& list)
 {
     std::vector<int> result;
@@ -51,6 +61,15 @@ std::vector<int> CpuOrchestrator::parseCpuList(const std::string& list)
     return result;
 }
 
+std::vector<int> CpuOrchestrator::detectIsolatedCores()
+{
+    // cores taken off the scheduler's hands with isolcpus= (empty if none)
+    std::ifstream f("/sys/devices/system/cpu/isolated");
+    std::string cpulist;
+    std::getline(f, cpulist);
+    return parseCpuList(cpulist);
+}
+
 std::vector<int> CpuOrchestrator::detectPhysicalCores()
 {
     std::vector<int> physical;
@@ -148,11 +167,20 @@ int CpuOrchestrator::detectBestNumaNode(const std::vector<int>& physicalCores)
     return bestNode;
 }
 
-void CpuOrchestrator::initialize(const std::string& cpuCores, bool avoidHT, int numaNode)
+void CpuOrchestrator::initialize(const std::string& cpuCores, bool avoidHT, int numaNode, const std::string& spinCores, bool busyPolling)
 {
+    s_spinPool = spinCores.empty() ? detectIsolatedCores() : parseCpuList(spinCores);
+    if (!s_spinPool.empty()) {
+        LOG_INFO("Spin cores for busy-polling threads: [" << formatCpuList(s_spinPool) << "]");
+    } else if (busyPolling) {
+        LOG_WARN("Busy polling is enabled but no spin cores are set (CpuSpinCores) or isolated, busy-polling threads will share cores");
+    }
+
     // explicit core list takes precedence
     if (!cpuCores.empty()) {
         s_corePool = parseCpuList(cpuCores);
+        // spin cores are only handed to spinning threads
+        std::erase_if(s_corePool, [](int core) { return std::find(s_spinPool.begin(), s_spinPool.end(), core) != s_spinPool.end(); });
         if (!s_corePool.empty()) {
             s_enabled = true;
             std::ostringstream oss;
@@ -206,6 +234,7 @@ void CpuOrchestrator::initialize(const std::string& cpuCores, bool avoidHT, int
     }
 
     s_corePool = std::move(physicalCores);
+    std::erase_if(s_corePool, [](int core) { return std::find(s_spinPool.begin(), s_spinPool.end(), core) != s_spinPool.end(); });
     s_enabled = true;
 
     std::ostringstream oss;
@@ -216,8 +245,17 @@ void CpuOrchestrator::initialize(const std::string& cpuCores, bool avoidHT, int
     LOG_INFO("CPU affinity enabled (auto): cores=[" << oss.str() << "]");
 }
 
-int CpuOrchestrator::bind(ThreadRole role)
+int CpuOrchestrator::bind(ThreadRole role, bool spinning)
 {
+    if (spinning) {
+        const size_t idx = s_nextSpinCore.fetch_add(1, std::memory_order_relaxed);
+        if (idx < s_spinPool.size())
+            return bindCore(role, s_spinPool[idx]);
+        // with none at all, initialize() has warned already
+        if (!s_spinPool.empty())
+            LOG_WARN("No spin core left for busy-polling " << roleToString(role) << " thread, it will share a core");
+    }
+
     if (!s_enabled || s_corePool.empty())
         return -1;
 
@@ -227,8 +265,11 @@ int CpuOrchestrator::bind(ThreadRole role)
         return -1;
     }
 
-    const int core = s_corePool[idx];
+    return bindCore(role, s_corePool[idx]);
+}
 
+int CpuOrchestrator::bindCore(ThreadRole role, int core)
+{
     cpu_set_t cpuset;
     CPU_ZERO(&cpuset);
     CPU_SET(core, &cpuset);
@@ -23,20 +23,27 @@ public:
     /// @param cpuCores   explicit core list (e.g. "2,3,4,5"), or empty for auto-detect
     /// @param avoidHT    if true and cpuCores is empty, auto-detect physical cores (skip HT siblings)
     /// @param numaNode   NUMA node to pin to (-1 = auto-detect best node)
-    static void initialize(const std::string& cpuCores, bool avoidHT, int numaNode);
+    /// @param spinCores  cores kept for busy-polling threads, or empty for the kernel's isolated cores
+    /// @param busyPolling whether any thread is set to busy-poll, to warn when there are no spin cores
+    static void initialize(const std::string& cpuCores, bool avoidHT, int numaNode, const std::string& spinCores = "", bool busyPolling = false);
 
     /// Bind the calling thread to the next available core for the given role.
+    /// Spinning threads take a spin core of their own while any are left.
     /// Returns the core ID bound to, or -1 if binding is disabled or cores are exhausted.
-    static int bind(ThreadRole role);
+    static int bind(ThreadRole role, bool spinning = false);
 
 private:
+    static int bindCore(ThreadRole role, int core);
     static std::vector<int> parseCpuList(const std::string& list);
+    static std::vector<int> detectIsolatedCores();
     static std::vector<int> detectPhysicalCores();
     static std::vector<int> getCoresForNumaNode(int node);
     static int detectBestNumaNode(const std::vector<int>& physicalCores);
 
     static inline std::vector<int> s_corePool;
     static inline std::atomic<size_t> s_nextCore{0};
+    static inline std::vector<int> s_spinPool;
+    static inline std::atomic<size_t> s_nextSpinCore{0};
     static inline bool s_enabled = false;
 
     CREATE_LOGGER("CpuOrchestrator");
@@ -1,26 +1,216 @@
 #include "FileUtils.h"
 
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <utility>
 
 #include "CpuOrchestrator.h"
 
 #include "Utils.h"
 
+namespace {
+
+constexpr unsigned RING_ENTRIES = 256;
+constexpr size_t FIXED_BUFFER_SIZE = 64 * 1024;
+constexpr int FIXED_BUFFER_COUNT = 16;
+
+// YYYYMMDD-HHMMSS-mmm
+constexpr size_t STAMP_LENGTH = 19;
+
+std::string rotationStamp(std::chrono::system_clock::time_point time)
+{
+    const time_t seconds = std::chrono::system_clock::to_time_t(time);
+    tm utc;
+    gmtime_r(&seconds, &utc);
+
+    char buf[STAMP_LENGTH + 1];
+    const size_t n = std::strftime(buf, sizeof(buf), "%Y%m%d-%H%M%S", &utc);
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count() % 1000;
+    std::snprintf(buf + n, sizeof(buf) - n, "-%03d", static_cast<int>(ms));
+    return buf;
+}
+
+bool isRotationStamp(std::string_view name)
+{
+    if (name.size() < STAMP_LENGTH || name[8] != '-' || name[15] != '-')
+        return false;
+    for (size_t i = 0; i < STAMP_LENGTH; ++i) {
+        if (i != 8 && i != 15 && (name[i] < '0' || name[i] > '9'))
+            return false;
+    }
+    return true;
+}
+
+// first time after from that falls dailyAt seconds into a UTC day
+std::chrono::system_clock::time_point nextDailyRotation(std::chrono::system_clock::time_point from, int64_t dailyAt)
+{
+    using namespace std::chrono;
+    const auto day = floor<days>(from);
+    const auto at = day + seconds(dailyAt);
+    return at > from ? at : at + days(1);
+}
+
+// where data can be cut without splitting a line or message record; 0 if nowhere yet
+size_t recordBoundary(std::string_view data, MessageFormat format)
+{
+    if (format != MessageFormat::BINARY) {
+        const size_t eol = data.rfind('\n');
+        return eol == std::string_view::npos ? 0 : eol + 1;
+    }
+
+    size_t pos = 0;
+    MessageLog::Record record;
+    size_t size;
+    while (MessageLog::readBinary(data.substr(pos), record, size) == MessageLog::ReadResult::OK)
+        pos += size;
+    return pos;
+}
+
+// Compresses a rotated file into path.zst (indexed like a live compressed
+// file), then deletes it. False, leaving it be, if that doesn't work out.
+bool compressRotated(const std::string& path, size_t blockBytes, MessageFormat format)
+{
+    const std::string target = path + ".zst";
+    const std::string tmp = target + ".tmp";
+
+    bool ok;
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        BlockCompressor compressor(blockBytes);
+        compressor.open(tmp, true);
+
+        std::string buffer;
+        std::string compressed;
+        std::vector<char> chunk(std::max<size_t>(blockBytes, 64 * 1024));
+        while (in.read(chunk.data(), static_cast<std::streamsize>(chunk.size())) || in.gcount() > 0) {
+            buffer.append(chunk.data(), static_cast<size_t>(in.gcount()));
+            if (buffer.size() < blockBytes)
+                continue;
+
+            // frames start on a line or record, like those of a live compressed file
+            const size_t cut = recordBoundary(buffer, format);
+            if (cut == 0)
+                continue;
+            compressor.compress(std::string_view(buffer).substr(0, cut), compressed);
+            compressor.finish(compressed);
+            buffer.erase(0, cut);
+
+            out.write(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+            compressed.clear();
+        }
+        compressor.compress(buffer, compressed);
+        compressor.finish(compressed);
+        out.write(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+
+        ok = in.eof() && out.flush().good();
+    }
+
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tmp + CompressedLog::INDEX_SUFFIX, target + CompressedLog::INDEX_SUFFIX, ec);
+        if (!ec)
+            std::filesystem::rename(tmp, target, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::filesystem::remove(tmp, ec);
+        std::filesystem::remove(tmp + CompressedLog::INDEX_SUFFIX, ec);
+        return false;
+    }
+
+    std::filesystem::remove(path, ec);
+    return true;
+}
+
+// Prunes and compresses the files rotated out of path. Safe to repeat: a
+// rotated file that's compressed already is skipped.
+void sweepRotated(const std::string& path, const RotationPolicy& rotation, MessageFormat format)
+{
+    namespace fs = std::filesystem;
+    const fs::path file(path);
+    const fs::path dir = file.has_parent_path() ? file.parent_path() : fs::path(".");
+    const std::string prefix = file.filename().string() + ".";
+
+    // rotated files by stamp, each with any index or compressed copy of it
+    std::map<std::string, std::vector<fs::path>> rotated;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        const std::string name = entry.path().filename().string();
+        if (!name.starts_with(prefix) || !isRotationStamp(std::string_view(name).substr(prefix.size())))
+            continue;
+        const std::string_view rest = std::string_view(name).substr(prefix.size());
+        rotated[std::string(rest.substr(0, rest.find('.')))].push_back(entry.path());
+    }
+
+    while (rotation.m_retain > 0 && rotated.size() > rotation.m_retain) {
+        for (const auto& old : rotated.begin()->second) {
+            LOG_INFO(FileWriter, "Removing rotated file " << old.string());
+            fs::remove(old, ec);
+        }
+        rotated.erase(rotated.begin());
+    }
+
+    if (rotation.m_compressBlockBytes == 0)
+        return;
+    for (const auto& [stamp, files] : rotated) {
+        const fs::path plain = dir / (prefix + stamp);
+        if (std::find(files.begin(), files.end(), plain) == files.end())
+            continue;
+
+        // compressed already, by the writer or an earlier sweep
+        char magic[4] = {};
+        std::ifstream(plain, std::ios::binary).read(magic, sizeof(magic));
+        if (CompressedLog::isCompressed({magic, sizeof(magic)}))
+            continue;
+
+        if (!compressRotated(plain.string(), rotation.m_compressBlockBytes, format))
+            LOG_ERROR(FileWriter, "Failed to compress rotated file " << plain.string());
+    }
+}
+
+}  // namespace
+
 FileWriter::FileWriter()
-    : m_enabled(false)
-{}
+    : m_wakeFd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    , m_enabled(false)
+{
+    if (m_wakeFd < 0)
+        LOG_ERROR("Unable to create writer eventfd: " << std::strerror(errno));
+}
 
 FileWriter::~FileWriter()
 {
     stop();
+    if (m_wakeFd >= 0)
+        ::close(m_wakeFd);
 }
 
-void FileWriter::start()
+void FileWriter::start(bool ioUring)
 {
+    m_async = ioUring && initRing();
+
+    // set before the thread exists so an immediate stop() still joins it
+    m_enabled.store(true, std::memory_order_release);
+    for (auto& [_, instance] : m_instances)
+        instance->m_writerRunning.store(true, std::memory_order_release);
+
     m_thread = std::thread([&]() {
         CpuOrchestrator::bind(ThreadRole::FILE_WRITER);
-        m_enabled.store(true, std::memory_order_release);
         process();
     });
 }
@@ -29,145 +219,978 @@ void FileWriter::stop()
 {
     if (m_enabled.load(std::memory_order_acquire)) {
         m_enabled.store(false, std::memory_order_release);
+        wake();
         m_thread.join();
 
+        // whatever is left goes out through blocking writes
+        if (m_async) {
+            drainRing();
+            m_async = false;
+        }
+        m_ring.close();
+
         // final flush for any remaining dirty data
+        std::vector<std::function<void()>> tasks;
+        {
+            std::lock_guard lock(m_taskMutex);
+            tasks.swap(m_tasks);
+            m_hasTasks.store(false, std::memory_order_release);
+        }
         flushInstances();
+        runTasks(tasks);
 
-        // close open files
-        for (auto& [_, instance] : m_instances)
-            instance->m_stream.close();
+        // compressed files end on a whole frame
+        for (auto& [_, instance] : m_instances) {
+            if (!instance->m_compressor)
+                continue;
+            instance->m_compressor->finish(instance->m_buffer);
+            writeBuffer(*instance, 0, instance->m_buffer.size());
+            instance->m_buffer.clear();
+        }
+        syncInstances(true);
+
+        // rotated files it doesn't get to are picked up on the next start
+        if (m_archiver) {
+            m_archiver->stop();
+            m_archiver.reset();
+        }
+
+        // close open files and release anyone still waiting on a sync that won't come
+        for (auto& [_, instance] : m_instances) {
+            closeInstance(*instance);
+
+            std::lock_guard lock(instance->m_syncMutex);
+            instance->m_writerRunning.store(false, std::memory_order_release);
+            if (!instance->m_syncCallbacks.empty()) {
+                LOG_WARN("Dropping " << instance->m_syncCallbacks.size() << " sync callbacks for unwritten data in " << instance->m_path);
+                instance->m_syncCallbacks.clear();
+            }
+            instance->m_syncCV.notify_all();
+        }
     }
 }
 
-std::unique_ptr<WriterInstance>& FileWriter::createInstance(const std::string& fileName, bool formatFIXMessages)
+std::unique_ptr<WriterInstance>& FileWriter::createInstance(const std::string& fileName, MessageFormat messageFormat, std::string session)
 {
     auto it = m_instances.find(fileName);
     if (it != m_instances.end())
         return it->second;
 
-    it = m_instances.emplace(fileName, std::make_unique<WriterInstance>(fileName, formatFIXMessages)).first;
+    it = m_instances.emplace(fileName, std::make_unique<WriterInstance>(fileName, messageFormat, std::move(session))).first;
+    it->second->m_owner = this;
+    it->second->m_writerRunning.store(m_enabled.load(std::memory_order_acquire), std::memory_order_release);
     return it->second;
 }
 
-void FileWriter::flushInstances()
+void FileWriter::markDirty(WriterInstance& instance)
 {
-    for (auto& [_, instancePtr] : m_instances) {
+    // an instance is linked in at most once between writer passes, so the
+    // writer can take the whole list with one exchange
+    WriterInstance* head = m_dirtyHead.load(std::memory_order_relaxed);
+    do {
+        instance.m_nextDirty = head;
+    } while (!m_dirtyHead.compare_exchange_weak(head, &instance, std::memory_order_seq_cst, std::memory_order_relaxed));
+
+    if (m_sleeping.load(std::memory_order_seq_cst))
+        wake();
+}
+
+void FileWriter::wake()
+{
+    const uint64_t one = 1;
+    if (m_wakeFd >= 0)
+        [[maybe_unused]] const auto ret = ::write(m_wakeFd, &one, sizeof(one));
+}
+
+bool FileWriter::flushInstances()
+{
+    for (WriterInstance* it = m_dirtyHead.exchange(nullptr, std::memory_order_acquire); it;) {
+        WriterInstance* next = it->m_nextDirty;
+        m_pending.push_back(it);
+        it = next;
+    }
+
+    bool flushed = false;
+    auto pending = m_pending.begin();
+    for (WriterInstance* instancePtr : m_pending) {
         auto& instance = *instancePtr;
 
-        if (!instance.m_dirty.load(std::memory_order_acquire))
+        // picked up again once the write in flight completes
+        if (instance.m_writeInFlight) {
+            *pending++ = instancePtr;
             continue;
+        }
+        flushed = true;
 
-        // swap buffers
-        {
-            std::lock_guard<std::mutex> lock(instance.m_mutex);
-            instance.m_dirty.store(false, std::memory_order_release);
+        // an RMW, so it sees every push from a producer that found the flag already set
+        instance.m_dirty.exchange(false, std::memory_order_acq_rel);
 
-            if (instance.m_shouldReset.load(std::memory_order_acquire)) {
-                instance.m_shouldReset.store(false, std::memory_order_release);
+        // set up a pass after the rotation that called for it, so its writes went first
+        if (instance.m_prepareNext) {
+            instance.m_prepareNext = false;
+            preallocateFile(instance, instance.m_streamPath + ".next");
+        }
 
-                instance.m_queue.clear();
-                instance.m_buffer.clear();
-                instance.m_logEntryQueue.clear();
-                instance.m_logEntryBuffer.clear();
+        // anything still in m_buffer is left over from a failed open
+        size_t carried = instance.m_buffer.size();
 
-                // re-open the file with truncation option to wipe
-                instance.m_stream.close();
-                instance.m_stream.open(instance.m_path, std::ofstream::out | std::ofstream::trunc);
-                instance.m_stream.close();
-                continue;
+        using Type = WriterInstance::Item::Type;
+        WriterInstance::Item item;
+        uint64_t position;
+        while (instance.m_queue.pop(item, position)) {
+            switch (item.m_type) {
+                case Type::DATA:
+                    instance.m_buffer += item.m_data;
+                    break;
+                case Type::MESSAGE: {
+                    // any formatting happens here, off the hot path
+                    const MessageLog::Record record{item.m_epochUs, item.m_inbound, instance.m_session, item.m_data};
+                    if (instance.m_messageFormat == MessageFormat::BINARY)
+                        MessageLog::appendBinary(instance.m_buffer, record);
+                    else
+                        MessageLog::appendText(instance.m_buffer, record, instance.m_messageFormat == MessageFormat::TEXT);
+                    break;
+                }
+                case Type::OPEN:
+                case Type::REMOVE:
+                case Type::PREALLOCATE: {
+                    using OpType = WriterInstance::FileOp::Type;
+                    const OpType opType = item.m_type == Type::OPEN     ? OpType::OPEN
+                                        : item.m_type == Type::REMOVE   ? OpType::REMOVE
+                                                                        : OpType::PREALLOCATE;
+                    instance.m_opsBuffer.push_back({opType, instance.m_buffer.size(), std::move(item.m_data), item.m_truncate});
+                    break;
+                }
+                case Type::RESET:
+                    // drop what was queued before it; ops queued so far still apply
+                    instance.m_buffer.resize(carried);
+                    for (auto& op : instance.m_opsBuffer)
+                        op.m_offset = std::min(op.m_offset, carried);
+                    instance.m_opsBuffer.push_back({WriterInstance::FileOp::Type::OPEN, carried, std::move(item.m_data), true});
+                    break;
             }
+            instance.m_swappedTicket = position;
+        }
+
+        // rotation waits for a pass without ops, which may be switching files anyway
+        if (instance.m_rotation.enabled() && instance.m_opsBuffer.empty() && instance.m_buffer.size() > carried
+            && rotationDue(instance, instance.m_buffer.size() - carried)) {
+            rotateInstance(instance, carried);
+            carried = 0;
+        }
 
-            if (!instance.m_queue.empty())
-                instance.m_queue.swap(instance.m_buffer);
+        if (instance.m_compressor)
+            compressBuffer(instance, carried);
 
-            if (!instance.m_logEntryQueue.empty())
-                instance.m_logEntryQueue.swap(instance.m_logEntryBuffer);
+        if (instance.m_buffer.empty() && instance.m_opsBuffer.empty()) {
+            instance.m_writtenTicket = instance.m_swappedTicket;
+            continue;
         }
 
-        // format deferred log entries (timestamp formatting happens here, off the hot path)
-        for (const auto& entry : instance.m_logEntryBuffer) {
-            const auto ts = Utils::formatTimestampMicros(entry.epoch_us);
-            instance.m_buffer += ts;
-            instance.m_buffer += entry.inbound ? " RECV: " : " SENT: ";
-            instance.m_buffer += entry.msg;
-            instance.m_buffer += '\n';
+        // plain appends go into this pass's batch; a failed open is retried next pass
+        if (m_async && instance.m_opsBuffer.empty()) {
+            if (!openInstance(instance) || submitWrite(instance))
+                continue;
         }
-        instance.m_logEntryBuffer.clear();
 
-        if (instance.m_buffer.empty())
-            continue;
+        // ops split the buffer into runs, each written to the file current at the time
+        size_t pos = 0;
+        const bool hadOps = !instance.m_opsBuffer.empty();
+        for (const auto& op : instance.m_opsBuffer) {
+            writeBuffer(instance, pos, op.m_offset);
+            applyOp(instance, op);
+            pos = op.m_offset;
+        }
+        instance.m_opsBuffer.clear();
+
+        // a plain write that failed to open is retried on the next pass; once
+        // files have switched underneath it there's nowhere sensible to retry to
+        if (writeBuffer(instance, pos, instance.m_buffer.size()) || hadOps) {
+            instance.m_buffer.clear();
+            instance.m_writtenTicket = instance.m_swappedTicket;
+        }
+    }
+    m_pending.erase(pending, m_pending.end());
+    return flushed;
+}
+
+void FileWriter::compressBuffer(WriterInstance& instance, size_t begin)
+{
+    auto& compressor = *instance.m_compressor;
+    if (!compressor.isOpen())
+        compressor.open(instance.m_streamPath, false);
+
+    // anything before begin was compressed on an earlier pass
+    const std::string_view buffer(instance.m_buffer);
+    std::string& out = instance.m_compressBuffer;
+    out.assign(buffer.substr(0, begin));
 
-        if (instance.m_formatFIXMessages)
-            std::replace(instance.m_buffer.begin(), instance.m_buffer.end(), '\x01', '|');
+    size_t pos = begin;
+    for (auto& op : instance.m_opsBuffer) {
+        compressor.compress(buffer.substr(pos, op.m_offset - pos), out);
+        pos = op.m_offset;
 
-        // write
-        if (!instance.m_stream.is_open() || !instance.m_stream.good()) {
-            if (instance.m_stream.is_open())
-                instance.m_stream.close();  // close the stream if it's in an error state
+        // the old file gets a whole last frame, the new one starts afresh
+        if (op.m_type == WriterInstance::FileOp::Type::OPEN) {
+            compressor.finish(out);
+            compressor.open(op.m_path, op.m_truncate);
+        }
+        op.m_offset = out.size();
+    }
+    compressor.compress(buffer.substr(pos), out);
+
+    instance.m_buffer.swap(out);
+    out.clear();
+}
+
+bool FileWriter::openInstance(WriterInstance& instance)
+{
+    if (instance.m_fd >= 0)
+        return true;
 
-            const auto dir_it = instance.m_path.rfind(std::filesystem::path::preferred_separator);
-            std::filesystem::create_directories(instance.m_path.substr(0, dir_it));
+    const auto dir_it = instance.m_streamPath.rfind(std::filesystem::path::preferred_separator);
+    std::filesystem::create_directories(instance.m_streamPath.substr(0, dir_it));
 
-            LOG_DEBUG("Opening for writing: " << instance.m_path);
-            instance.m_stream.open(instance.m_path, std::ofstream::out | std::ofstream::app);
-            if (!instance.m_stream.good()) {
-                LOG_ERROR("Failed to open file for writing: " << instance.m_path);
+    LOG_DEBUG("Opening for writing: " << instance.m_streamPath);
+    instance.m_fd = ::open(instance.m_streamPath.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (instance.m_fd < 0 && errno == ENOENT) {
+        instance.m_fd = ::open(instance.m_streamPath.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        instance.m_createdFile = instance.m_fd >= 0;
+    }
+    if (instance.m_fd < 0) {
+        LOG_ERROR("Failed to open file for writing: " << instance.m_streamPath << ": " << std::strerror(errno));
+        return false;
+    }
+
+    struct stat st{};
+    instance.m_fileSize = ::fstat(instance.m_fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+    if (instance.m_preallocateBytes > 0)
+        reserve(instance, instance.m_fd, instance.m_streamPath);
+
+    if (instance.m_rotation.enabled() && instance.m_nextRotation == std::chrono::system_clock::time_point::min()) {
+        instance.m_nextRotation = std::chrono::system_clock::time_point::max();
+        if (instance.m_rotation.m_dailyAt >= 0) {
+            // a file last written before a rotation time rotates on its next write
+            const auto written = instance.m_fileSize > 0 ? std::chrono::system_clock::from_time_t(st.st_mtime) : std::chrono::system_clock::now();
+            instance.m_nextRotation = nextDailyRotation(written, instance.m_rotation.m_dailyAt);
+        }
+        instance.m_prepareNext = instance.m_preallocateBytes > 0;
+
+        // finishes whatever a sweep cut short by a restart left undone
+        archive(instance);
+    }
+    return true;
+}
+
+void FileWriter::reserve(WriterInstance& instance, int fd, const std::string& path)
+{
+    // keeps the file's size, so readers and appends don't see the reservation
+    if (::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(instance.m_preallocateBytes)) != 0)
+        LOG_DEBUG("Unable to preallocate " << path << ": " << std::strerror(errno));
+}
+
+void FileWriter::preallocateFile(WriterInstance& instance, const std::string& path)
+{
+    if (instance.m_preallocateBytes == 0 || path == instance.m_streamPath)
+        return;
+
+    const auto dir = std::filesystem::path(path).parent_path();
+    if (!dir.empty())
+        std::filesystem::create_directories(dir);
+
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_WARN("Unable to create " << path << " ahead of time: " << std::strerror(errno));
+        return;
+    }
+    reserve(instance, fd, path);
+    ::close(fd);
+    instance.m_createdFile = true;
+}
+
+void FileWriter::releaseReservation(WriterInstance& instance)
+{
+    if (instance.m_preallocateBytes == 0)
+        return;
+
+    const int fd = instance.m_fd >= 0 ? instance.m_fd : ::open(instance.m_streamPath.c_str(), O_WRONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd >= 0 && ::fstat(fd, &st) == 0) {
+        // truncating to its own size frees whatever is allocated past the end,
+        // which punching a hole there doesn't on every filesystem
+        if (::ftruncate(fd, st.st_size) != 0)
+            LOG_DEBUG("Unable to release what's left of " << instance.m_streamPath << ": " << std::strerror(errno));
+    }
+    if (fd >= 0 && fd != instance.m_fd)
+        ::close(fd);
+}
+
+bool FileWriter::rotationDue(WriterInstance& instance, size_t pending)
+{
+    if (!openInstance(instance) || instance.m_fileSize == 0)
+        return false;
+
+    const auto& rotation = instance.m_rotation;
+    if (rotation.m_maxBytes > 0 && instance.m_fileSize + pending > rotation.m_maxBytes)
+        return true;
+    return std::chrono::system_clock::now() >= instance.m_nextRotation;
+}
+
+void FileWriter::rotateInstance(WriterInstance& instance, size_t carried)
+{
+    // the old file gets what was left over for it, and the end of its last frame
+    std::string tail = instance.m_buffer.substr(0, carried);
+    if (instance.m_compressor)
+        instance.m_compressor->finish(tail);
+    if (!tail.empty())
+        writeAll(instance, tail.data(), tail.size());
+    instance.m_buffer.erase(0, carried);
+
+    // stamps sort in rotation order, so two rotations in the same millisecond
+    // push the second one's along, past any compressed copy of the first too
+    const auto now = std::chrono::system_clock::now();
+    auto stamp = now;
+    std::string rotated = instance.m_streamPath + "." + rotationStamp(stamp);
+    while (std::filesystem::exists(rotated) || std::filesystem::exists(rotated + ".zst")) {
+        stamp += std::chrono::milliseconds(1);
+        rotated = instance.m_streamPath + "." + rotationStamp(stamp);
+    }
+
+    releaseReservation(instance);
+    closeInstance(instance);
+
+    std::error_code ec;
+    std::filesystem::rename(instance.m_streamPath, rotated, ec);
+    if (ec) {
+        LOG_ERROR("Failed to rotate " << instance.m_streamPath << ": " << ec.message());
+        return;
+    }
+    if (instance.m_compressor)
+        std::filesystem::rename(instance.m_streamPath + CompressedLog::INDEX_SUFFIX, rotated + CompressedLog::INDEX_SUFFIX, ec);
+    LOG_INFO("Rotated " << instance.m_streamPath << " to " << rotated);
+
+    // the file set up ahead of time takes over, reservation and all
+    std::filesystem::rename(instance.m_streamPath + ".next", instance.m_streamPath, ec);
+    instance.m_createdFile = true;
+    if (instance.m_compressor)
+        instance.m_compressor->open(instance.m_streamPath, true);
+
+    if (instance.m_rotation.m_dailyAt >= 0)
+        instance.m_nextRotation = nextDailyRotation(now, instance.m_rotation.m_dailyAt);
+    instance.m_prepareNext = instance.m_preallocateBytes > 0;
+    archive(instance);
+}
+
+void FileWriter::archive(WriterInstance& instance)
+{
+    if (!m_archiver)
+        m_archiver = std::make_unique<Dispatcher>();
+
+    m_archiver->dispatch([path = instance.m_streamPath, rotation = instance.m_rotation, format = instance.m_messageFormat] {
+        try {
+            sweepRotated(path, rotation, format);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Failed to sweep files rotated from " << path << ": " << e.what());
+        }
+    });
+}
+
+void FileWriter::writeAll(WriterInstance& instance, const char* data, size_t length)
+{
+    while (length > 0) {
+        const ssize_t n = ::write(instance.m_fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR)
                 continue;
-            }
+
+            // the rest of the run is lost; the next write reopens the file
+            LOG_ERROR("Failed to write " << length << " bytes to " << instance.m_streamPath << ": " << std::strerror(errno));
+            closeInstance(instance);
+            return;
+        }
+        data += n;
+        length -= static_cast<size_t>(n);
+        instance.m_fileSize += static_cast<uint64_t>(n);
+        instance.m_fdDirty = true;
+    }
+}
+
+bool FileWriter::writeBuffer(WriterInstance& instance, size_t begin, size_t end)
+{
+    if (begin >= end)
+        return true;
+    if (!openInstance(instance))
+        return false;
+
+    writeAll(instance, instance.m_buffer.data() + begin, end - begin);
+    return true;
+}
+
+void FileWriter::applyOp(WriterInstance& instance, const WriterInstance::FileOp& op)
+{
+    using Type = WriterInstance::FileOp::Type;
+
+    if (op.m_type == Type::REMOVE) {
+        std::error_code ec;
+        std::filesystem::remove(op.m_path, ec);
+        if (ec)
+            LOG_WARN("Failed to remove " << op.m_path << ": " << ec.message());
+        return;
+    }
+    if (op.m_type == Type::PREALLOCATE) {
+        preallocateFile(instance, op.m_path);
+        return;
+    }
+
+    if (op.m_path != instance.m_streamPath) {
+        releaseReservation(instance);
+        instance.m_nextRotation = std::chrono::system_clock::time_point::min();
+    }
+    closeInstance(instance);
+    instance.m_streamPath = op.m_path;
+
+    // an empty file was most likely preallocated, and truncating it would give the space back
+    struct stat st;
+    if (op.m_truncate && (::stat(instance.m_streamPath.c_str(), &st) != 0 || st.st_size > 0)) {
+        const auto dir_it = instance.m_streamPath.rfind(std::filesystem::path::preferred_separator);
+        std::filesystem::create_directories(instance.m_streamPath.substr(0, dir_it));
+
+        const int fd = ::open(instance.m_streamPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd >= 0) {
+            ::close(fd);
+            instance.m_createdFile = true;
+        } else {
+            LOG_ERROR("Failed to truncate " << instance.m_streamPath << ": " << std::strerror(errno));
+        }
+    }
+}
+
+void FileWriter::closeInstance(WriterInstance& instance)
+{
+    if (instance.m_fd < 0)
+        return;
+
+    // data written through this descriptor would otherwise go unsynced once it's gone
+    if (instance.m_fdDirty && instance.m_durability != Durability::NONE)
+        ::fdatasync(instance.m_fd);
+    instance.m_fdDirty = false;
+
+    ::close(instance.m_fd);
+    instance.m_fd = -1;
+}
+
+std::chrono::steady_clock::time_point FileWriter::syncInstances(bool force)
+{
+    const auto now = std::chrono::steady_clock::now();
+    auto nextDue = std::chrono::steady_clock::time_point::max();
+    for (auto& [_, instancePtr] : m_instances) {
+        auto& instance = *instancePtr;
+        if (instance.m_writtenTicket > instance.m_visibleTicket.load(std::memory_order_relaxed)) {
+            std::lock_guard lock(instance.m_syncMutex);
+            instance.m_visibleTicket.store(instance.m_writtenTicket, std::memory_order_release);
+            instance.m_syncCV.notify_all();
+        }
+
+        if (instance.m_syncInFlight || instance.m_writtenTicket <= instance.m_syncedTicket.load(std::memory_order_relaxed))
+            continue;
+
+        if (instance.m_durability == Durability::PERIODIC && !force && now - instance.m_lastSync < instance.m_syncInterval) {
+            nextDue = std::min(nextDue, instance.m_lastSync + instance.m_syncInterval);
+            continue;
         }
+        instance.m_lastSync = now;
+
+        if (instance.m_durability == Durability::NONE || syncInstance(instance))
+            completeSync(instance, instance.m_writtenTicket);
+    }
+    return nextDue;
+}
+
+bool FileWriter::syncInstance(WriterInstance& instance)
+{
+    if (instance.m_beforeSync)
+        instance.m_beforeSync();
+
+    // a new file isn't durable until its directory entry is
+    if (instance.m_createdFile) {
+        instance.m_createdFile = false;
+
+        const auto dir = std::filesystem::path(instance.m_streamPath).parent_path();
+        const int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+
+    // earlier files were synced as they were closed
+    if (instance.m_fd < 0 || !instance.m_fdDirty)
+        return true;
+
+    if (m_async && submitSync(instance))
+        return false;
+
+    if (::fdatasync(instance.m_fd) != 0)
+        LOG_ERROR("Failed to sync " << instance.m_streamPath << ": " << std::strerror(errno));
+    instance.m_fdDirty = false;
+    return true;
+}
+
+void FileWriter::completeSync(WriterInstance& instance, uint64_t ticket)
+{
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard lock(instance.m_syncMutex);
+        instance.m_syncedTicket.store(ticket, std::memory_order_release);
+
+        auto& callbacks = instance.m_syncCallbacks;
+        auto it = std::partition(callbacks.begin(), callbacks.end(), [&](const auto& callback) { return callback.first > ticket; });
+        for (auto ready_it = it; ready_it != callbacks.end(); ++ready_it)
+            ready.push_back(std::move(ready_it->second));
+        callbacks.erase(it, callbacks.end());
+    }
+    instance.m_syncCV.notify_all();
+
+    for (auto& fn : ready)
+        fn();
+}
+
+bool FileWriter::initRing()
+{
+    if (!m_ring.init(RING_ENTRIES))
+        return false;
+
+    m_fixedBuffers = std::make_unique<char[]>(FIXED_BUFFER_SIZE * FIXED_BUFFER_COUNT);
+    std::vector<iovec> iovecs(FIXED_BUFFER_COUNT);
+    for (int i = 0; i < FIXED_BUFFER_COUNT; ++i)
+        iovecs[i] = {m_fixedBuffers.get() + i * FIXED_BUFFER_SIZE, FIXED_BUFFER_SIZE};
+
+    m_freeSlots.clear();
+    if (m_ring.registerBuffers(iovecs.data(), FIXED_BUFFER_COUNT)) {
+        for (int i = FIXED_BUFFER_COUNT - 1; i >= 0; --i)
+            m_freeSlots.push_back(i);
+    } else {
+        m_fixedBuffers.reset();
+    }
+
+    // completions wake the writer like new writes do
+    m_ringEventFd = m_wakeFd >= 0 && m_ring.registerEventFd(m_wakeFd);
+
+    LOG_INFO("Writing files through io_uring" << (m_freeSlots.empty() ? "" : " with registered buffers"));
+    return true;
+}
+
+io_uring_sqe* FileWriter::nextSqe()
+{
+    // completions have to fit the CQ ring, or they'd be dropped on older kernels
+    if (m_inFlight >= m_ring.getCqEntries())
+        return nullptr;
+
+    auto* sqe = m_ring.getSqe();
+    if (!sqe) {
+        m_ring.submit();
+        sqe = m_ring.getSqe();
+    }
+    return sqe;
+}
 
-        instance.m_stream << instance.m_buffer;
-        instance.m_stream.flush();
+uint64_t FileWriter::addSubmission(const Submission& submission)
+{
+    ++m_inFlight;
+    if (m_freeSubmissions.empty()) {
+        m_submissions.push_back(submission);
+        return m_submissions.size() - 1;
+    }
+
+    const uint32_t index = m_freeSubmissions.back();
+    m_freeSubmissions.pop_back();
+    m_submissions[index] = submission;
+    return index;
+}
+
+bool FileWriter::submitWrite(WriterInstance& instance)
+{
+    const size_t length = instance.m_buffer.size();
+    if (length > std::numeric_limits<uint32_t>::max())
+        return false;
+
+    auto* sqe = nextSqe();
+    if (!sqe)
+        return false;
+
+    int slot = -1;
+    if (length <= FIXED_BUFFER_SIZE && !m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+
+        char* buffer = m_fixedBuffers.get() + slot * FIXED_BUFFER_SIZE;
+        std::memcpy(buffer, instance.m_buffer.data(), length);
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->addr = reinterpret_cast<uint64_t>(buffer);
+        sqe->buf_index = static_cast<uint16_t>(slot);
+    } else {
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->addr = reinterpret_cast<uint64_t>(instance.m_buffer.data());
+    }
+
+    // the file is opened O_APPEND, so this appends like write() would
+    sqe->fd = instance.m_fd;
+    sqe->off = static_cast<uint64_t>(-1);
+    sqe->len = static_cast<uint32_t>(length);
+    sqe->user_data = addSubmission({Submission::WRITE, &instance, instance.m_swappedTicket, length, slot});
 
-        // clear the buffer
+    // a copied buffer is free for the next swap; the instance still waits for
+    // this write to complete so its appends stay in order
+    if (slot >= 0)
         instance.m_buffer.clear();
+    instance.m_writeInFlight = true;
+    return true;
+}
+
+bool FileWriter::submitSync(WriterInstance& instance)
+{
+    auto* sqe = nextSqe();
+    if (!sqe)
+        return false;
+
+    sqe->opcode = IORING_OP_FSYNC;
+    sqe->fd = instance.m_fd;
+    sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+    sqe->user_data = addSubmission({Submission::SYNC, &instance, instance.m_writtenTicket, 0, -1});
+
+    instance.m_fdDirty = false;
+    instance.m_syncInFlight = true;
+    return true;
+}
+
+size_t FileWriter::reapCompletions()
+{
+    return m_ring.reap([&](const io_uring_cqe& cqe) { completeSubmission(cqe); });
+}
+
+void FileWriter::completeSubmission(const io_uring_cqe& cqe)
+{
+    const uint32_t index = static_cast<uint32_t>(cqe.user_data);
+    const Submission submission = m_submissions[index];
+    m_freeSubmissions.push_back(index);
+    --m_inFlight;
+
+    auto& instance = *submission.m_instance;
+    if (submission.m_kind == Submission::SYNC) {
+        if (cqe.res < 0)
+            LOG_ERROR("Failed to sync " << instance.m_streamPath << ": " << std::strerror(-cqe.res));
+        instance.m_syncInFlight = false;
+        completeSync(instance, submission.m_ticket);
+        return;
+    }
+
+    const char* data = submission.m_slot >= 0 ? m_fixedBuffers.get() + submission.m_slot * FIXED_BUFFER_SIZE : instance.m_buffer.data();
+    if (cqe.res < 0) {
+        LOG_ERROR("Failed to write " << submission.m_length << " bytes to " << instance.m_streamPath << ": " << std::strerror(-cqe.res));
+        closeInstance(instance);
+    } else {
+        instance.m_fdDirty = true;
+
+        // finish a short write the slow way
+        const size_t written = static_cast<size_t>(cqe.res);
+        instance.m_fileSize += written;
+        if (written < submission.m_length)
+            writeAll(instance, data + written, submission.m_length - written);
     }
+
+    if (submission.m_slot >= 0)
+        m_freeSlots.push_back(submission.m_slot);
+    else
+        instance.m_buffer.clear();
+    instance.m_writtenTicket = submission.m_ticket;
+    instance.m_writeInFlight = false;
+}
+
+void FileWriter::drainRing()
+{
+    while (m_inFlight > 0) {
+        m_ring.wait(std::chrono::milliseconds(1));
+        reapCompletions();
+    }
+}
+
+void FileWriter::post(std::function<void()> task)
+{
+    {
+        std::lock_guard lock(m_taskMutex);
+        m_tasks.push_back(std::move(task));
+        m_hasTasks.store(true, std::memory_order_release);
+    }
+    wake();
+}
+
+void FileWriter::runTasks(std::vector<std::function<void()>>& tasks)
+{
+    if (tasks.empty())
+        return;
+
+    for (auto& task : tasks) {
+        try {
+            task();
+        } catch (const std::exception& e) {
+            LOG_ERROR("Background file task failed: " << e.what());
+        }
+    }
+    tasks.clear();
+
+    // next write reopens whatever file is at the path now
+    for (auto& [_, instance] : m_instances)
+        closeInstance(*instance);
 }
 
 void FileWriter::process()
 {
+    std::vector<std::function<void()>> tasks;
     while (m_enabled.load(std::memory_order_acquire)) {
-        bool anyDirty = false;
-        for (const auto& [_, instance] : m_instances) {
-            if (instance->m_dirty.load(std::memory_order_acquire)) {
-                anyDirty = true;
-                break;
-            }
+        const bool completed = m_async && reapCompletions() > 0;
+
+        // taken before the flush, so the flush covers everything queued ahead of them
+        if (m_hasTasks.load(std::memory_order_acquire)) {
+            std::lock_guard lock(m_taskMutex);
+            tasks.swap(m_tasks);
+            m_hasTasks.store(false, std::memory_order_release);
+        }
+
+        const bool flushed = flushInstances();
+
+        const bool ranTasks = !tasks.empty();
+        if (ranTasks) {
+            // tasks may replace files, so nothing can still be in flight
+            if (m_async)
+                drainRing();
+            runTasks(tasks);
+        }
+        const auto nextSync = syncInstances(false);
+
+        // the whole pass goes to the kernel at once
+        if (m_async)
+            m_ring.submit();
+
+        if (!flushed && !ranTasks && !completed)
+            sleep(nextSync);
+    }
+}
+
+void FileWriter::sleep(std::chrono::steady_clock::time_point until)
+{
+    // producers only signal the eventfd while this is set; checking the dirty
+    // list after setting it closes the gap with a push that just missed it
+    m_sleeping.store(true, std::memory_order_seq_cst);
+    if (!m_dirtyHead.load(std::memory_order_seq_cst) && !m_hasTasks.load(std::memory_order_acquire) && m_enabled.load(std::memory_order_acquire)) {
+        timespec timeout{};
+        timespec* timeoutPtr = nullptr;
+        if (until != std::chrono::steady_clock::time_point::max()) {
+            const auto wait = std::max(std::chrono::nanoseconds(0), until - std::chrono::steady_clock::now());
+            timeout.tv_sec = static_cast<time_t>(wait.count() / 1'000'000'000);
+            timeout.tv_nsec = static_cast<long>(wait.count() % 1'000'000'000);
+            timeoutPtr = &timeout;
+        }
+        // without a completion eventfd, in-flight requests are polled for
+        if (m_async && m_inFlight > 0 && !m_ringEventFd && (!timeoutPtr || timeout.tv_sec > 0 || timeout.tv_nsec > 500'000)) {
+            timeout = {0, 500'000};
+            timeoutPtr = &timeout;
         }
 
-        if (anyDirty)
-            flushInstances();
-        else
-            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        pollfd pfd{m_wakeFd, POLLIN, 0};
+        ::ppoll(&pfd, 1, timeoutPtr, nullptr);
+
+        uint64_t count;
+        [[maybe_unused]] const auto ret = ::read(m_wakeFd, &count, sizeof(count));
     }
+    m_sleeping.store(false, std::memory_order_relaxed);
 }
 
-void WriterInstance::write(const std::string& text)
+void WriterInstance::enqueue(Item&& item)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_queue.append(text);
-    m_dirty.store(true, std::memory_order_release);
+    const uint64_t position = m_queue.push(std::move(item));
+
+    // pushes from other threads can finish out of order; the ticket only moves forward
+    uint64_t queued = m_queuedTicket.load(std::memory_order_relaxed);
+    while (queued < position && !m_queuedTicket.compare_exchange_weak(queued, position, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+
+    if (!m_dirty.exchange(true, std::memory_order_acq_rel) && m_owner)
+        m_owner->markDirty(*this);
+}
+
+void WriterInstance::write(std::string_view text)
+{
+    enqueue({Item::Type::DATA, false, false, 0, std::string(text)});
 }
 
 void WriterInstance::writeRaw(const char* prefix, size_t prefixLen, const std::string& body)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_queue.append(prefix, prefixLen);
-    m_queue.append(body);
-    m_dirty.store(true, std::memory_order_release);
+    std::string data;
+    data.reserve(prefixLen + body.size());
+    data.append(prefix, prefixLen);
+    data.append(body);
+    enqueue({Item::Type::DATA, false, false, 0, std::move(data)});
 }
 
 void WriterInstance::writeMessage(int64_t epoch_us, bool inbound, const std::string& msg)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_logEntryQueue.push_back({epoch_us, inbound, msg});
-    m_dirty.store(true, std::memory_order_release);
+    enqueue({Item::Type::MESSAGE, inbound, false, epoch_us, msg});
 }
 
 void WriterInstance::writeMessage(int64_t epoch_us, bool inbound, std::string&& msg)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_logEntryQueue.push_back({epoch_us, inbound, std::move(msg)});
-    m_dirty.store(true, std::memory_order_release);
+    enqueue({Item::Type::MESSAGE, inbound, false, epoch_us, std::move(msg)});
+}
+
+void WriterInstance::reopen(std::string path, bool truncate)
+{
+    {
+        std::lock_guard lock(m_pathMutex);
+        m_path = path;
+    }
+    enqueue({Item::Type::OPEN, false, truncate, 0, std::move(path)});
+}
+
+void WriterInstance::remove(std::string path)
+{
+    enqueue({Item::Type::REMOVE, false, false, 0, std::move(path)});
+}
+
+void WriterInstance::reset()
+{
+    std::string path;
+    {
+        std::lock_guard lock(m_pathMutex);
+        path = m_path;
+    }
+    enqueue({Item::Type::RESET, false, false, 0, std::move(path)});
+}
+
+void WriterInstance::setDurability(Durability durability, std::chrono::milliseconds interval, std::function<void()> beforeSync)
+{
+    m_durability = durability;
+    m_syncInterval = interval;
+    m_beforeSync = std::move(beforeSync);
+}
+
+void WriterInstance::setCompression(size_t blockBytes)
+{
+    if (!m_compressor)
+        m_compressor = std::make_unique<BlockCompressor>(blockBytes);
+}
+
+void WriterInstance::setPreallocation(uint64_t bytes)
+{
+    if (m_preallocateBytes == 0)
+        m_preallocateBytes = bytes;
+}
+
+void WriterInstance::preallocate(std::string path)
+{
+    enqueue({Item::Type::PREALLOCATE, false, false, 0, std::move(path)});
+}
+
+void WriterInstance::setRotation(const RotationPolicy& rotation)
+{
+    if (!m_rotation.enabled())
+        m_rotation = rotation;
+}
+
+void WriterInstance::waitSynced(uint64_t ticket)
+{
+    std::unique_lock lock(m_syncMutex);
+    m_syncCV.wait(lock, [&] { return synced(ticket) || !m_writerRunning.load(std::memory_order_acquire); });
+}
+
+void WriterInstance::waitWritten(uint64_t ticket)
+{
+    if (m_visibleTicket.load(std::memory_order_acquire) >= ticket || synced(ticket))
+        return;
+
+    std::unique_lock lock(m_syncMutex);
+    m_syncCV.wait(lock, [&] {
+        return m_visibleTicket.load(std::memory_order_acquire) >= ticket || synced(ticket) || !m_writerRunning.load(std::memory_order_acquire);
+    });
+}
+
+void WriterInstance::onSynced(uint64_t ticket, std::function<void()> fn)
+{
+    {
+        std::lock_guard lock(m_syncMutex);
+        if (!synced(ticket) && m_writerRunning.load(std::memory_order_acquire)) {
+            m_syncCallbacks.emplace_back(ticket, std::move(fn));
+            return;
+        }
+    }
+    fn();
+}
+
+////////////////////////////////////////////
+//               MappedFile               //
+////////////////////////////////////////////
+
+MappedFile::MappedFile(std::string path)
+    : m_path(std::move(path))
+{
+    remap();
+}
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_path(std::move(other.m_path))
+    , m_data(std::exchange(other.m_data, nullptr))
+    , m_size(std::exchange(other.m_size, 0))
+{}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        unmap();
+        m_path = std::move(other.m_path);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+
+void MappedFile::unmap()
+{
+    if (m_data)
+        ::munmap(const_cast<char*>(m_data), m_size);
+    m_data = nullptr;
+    m_size = 0;
+}
+
+bool MappedFile::remap()
+{
+    unmap();
+
+    const int fd = ::open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // nothing to map yet
+    if (st.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        return false;
+
+    m_data = static_cast<const char*>(addr);
+    m_size = static_cast<size_t>(st.st_size);
+    return true;
 }
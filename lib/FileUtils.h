@@ -1,68 +1,286 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
-#include <fstream>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 
+#include "CompressedLog.h"
+#include "Dispatcher.h"
+#include "IoUring.h"
 #include "Log.h"
+#include "MessageLog.h"
+#include "MpscQueue.h"
 #include "Types.h"
 
-struct LogEntry
-{
-    int64_t epoch_us;
-    bool inbound;
-    std::string msg;
-};
-
 // 1KB write buffer
 #define BUF_SIZE 1024
 
 class FileWriter;
 
+// How far the FileWriter goes to make an instance's writes durable:
+//   NONE      - written to the file, left to the page cache
+//   PERIODIC  - fdatasync at most once per sync interval
+//   GROUP     - one fdatasync per writer pass, covering everything written in it
+//   EVERY     - as GROUP; callers additionally wait for their own write to be synced
+enum class Durability : uint8_t
+{
+    NONE,
+    PERIODIC,
+    GROUP,
+    EVERY
+};
+
+// When a WriterInstance moves its file aside for a fresh one at the same path.
+// The old file becomes <path>.<YYYYMMDD-HHMMSS> (UTC, when it was rotated) and
+// goes to a background thread to be compressed and pruned.
+struct RotationPolicy
+{
+    uint64_t m_maxBytes = 0;          // before the file would grow past this (0 = no limit)
+    int64_t m_dailyAt = -1;           // each day at this many seconds past midnight UTC (-1 = never)
+    size_t m_retain = 0;              // rotated files kept, oldest deleted first (0 = keep all)
+    size_t m_compressBlockBytes = 0;  // compress rotated files into frames this big (0 = leave them)
+
+    bool enabled() const
+    {
+        return m_maxBytes > 0 || m_dailyAt >= 0;
+    }
+};
+
+// Read-only mapping of a whole file. remap() picks up growth since the last
+// mapping; views handed out before a remap are invalidated by it.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(std::string path);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // false if the file doesn't exist or can't be mapped
+    bool remap();
+
+    const char* data() const
+    {
+        return m_data;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    std::string_view view() const
+    {
+        return {m_data, m_size};
+    }
+
+    const std::string& getPath() const
+    {
+        return m_path;
+    }
+
+private:
+    void unmap();
+
+    std::string m_path;
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+// Producers queue writes without locking: each is one push onto an MPSC queue,
+// and only the push that makes an idle instance dirty touches the FileWriter.
 class WriterInstance
 {
 public:
-    explicit WriterInstance(std::string path, bool formatFIXMessages = false)
-        : m_path(std::move(path))
-        , m_shouldReset(false)
+    // session tags BINARY message records
+    explicit WriterInstance(std::string path, MessageFormat messageFormat = MessageFormat::RAW, std::string session = {})
+        : m_path(path)
+        , m_streamPath(std::move(path))
         , m_dirty(false)
-        , m_formatFIXMessages(formatFIXMessages)
+        , m_messageFormat(messageFormat)
+        , m_session(std::move(session))
     {
         m_buffer.reserve(BUF_SIZE);
-        m_queue.reserve(BUF_SIZE);
     }
 
-    void write(const std::string& text);
+    void write(std::string_view text);
     void writeRaw(const char* prefix, size_t prefixLen, const std::string& body);
     void writeMessage(int64_t epoch_us, bool inbound, const std::string& msg);
     void writeMessage(int64_t epoch_us, bool inbound, std::string&& msg);
 
-    void reset()
+    // Subsequent writes go to path, which is truncated first if asked. Writes
+    // queued before the call still land in the previous file.
+    void reopen(std::string path, bool truncate);
+
+    // Deletes path once everything queued before the call has been written.
+    void remove(std::string path);
+
+    // Drops anything still queued and truncates the current file.
+    void reset();
+
+    // beforeSync runs on the writer thread ahead of each fdatasync, for state
+    // kept outside the file that should be made durable along with it.
+    void setDurability(Durability durability, std::chrono::milliseconds interval, std::function<void()> beforeSync = {});
+
+    Durability getDurability() const
     {
-        m_shouldReset.store(true, std::memory_order_release);
-        m_dirty.store(true, std::memory_order_release);
+        return m_durability;
     }
 
+    // Writes go out block-compressed (see CompressedLog), in frames of about
+    // blockBytes. Set before anything is written; later calls are ignored.
+    void setCompression(size_t blockBytes);
+
+    // Each file gets room for bytes reserved as it's opened, with fallocate and
+    // without changing its size, so appends don't allocate blocks as they go.
+    // What a file doesn't use is released when the instance moves on from it.
+    // Set before anything is written; later calls are ignored.
+    void setPreallocation(uint64_t bytes);
+
+    // Creates path and reserves the preallocation for it ahead of time, for the
+    // file a later reopen(path, true) will start.
+    void preallocate(std::string path);
+
+    // With preallocation, the file that replaces a rotated one is set up a
+    // pass ahead, as <path>.next. Set before anything is written; later calls
+    // are ignored.
+    void setRotation(const RotationPolicy& rotation);
+
+    // Writes are numbered as they're queued; a ticket covers every write queued
+    // before it was taken. Writes dropped by reset() count as covered.
+    uint64_t ticket() const
+    {
+        return m_queuedTicket.load(std::memory_order_acquire);
+    }
+    bool synced(uint64_t ticket) const
+    {
+        return m_syncedTicket.load(std::memory_order_acquire) >= ticket;
+    }
+    void waitSynced(uint64_t ticket);
+    // Blocks until ticket's writes have reached the file, synced or not, so
+    // they can be read back through it.
+    void waitWritten(uint64_t ticket);
+
+    // Runs fn once ticket is synced: right away if it already is, otherwise on
+    // the writer thread.
+    void onSynced(uint64_t ticket, std::function<void()> fn);
+
 private:
-    std::string m_buffer;
-    std::string m_queue;
+    struct Item
+    {
+        enum class Type : uint8_t
+        {
+            DATA,
+            MESSAGE,
+            OPEN,
+            REMOVE,
+            RESET,
+            PREALLOCATE
+        };
 
-    std::ofstream m_stream;
+        Type m_type = Type::DATA;
+        bool m_inbound = false;   // MESSAGE
+        bool m_truncate = false;  // OPEN
+        int64_t m_epochUs = 0;    // MESSAGE
+        std::string m_data;       // bytes, message or path
+    };
 
-    std::mutex m_mutex;
+    void enqueue(Item&& item);
+
+    struct FileOp
+    {
+        enum class Type : uint8_t
+        {
+            OPEN,
+            REMOVE,
+            PREALLOCATE
+        };
 
+        Type m_type;
+        size_t m_offset;  // position in m_buffer the op applies at
+        std::string m_path;
+        bool m_truncate = false;
+    };
+
+    MpscQueue<Item> m_queue;
+    // drained from m_queue and not yet written; writer thread only
+    std::string m_buffer;
+
+    int m_fd = -1;
+    // written through m_fd since it was last synced; writer thread only
+    bool m_fdDirty = false;
+
+    // target of newly queued writes
+    std::mutex m_pathMutex;
     std::string m_path;
+    // file m_fd writes to; writer thread only
+    std::string m_streamPath;
+
+    Durability m_durability = Durability::NONE;
+    std::chrono::milliseconds m_syncInterval{0};
+    std::function<void()> m_beforeSync;
+
+    // highest queue position pushed so far, the one drained through, and how far
+    // the file has been written and synced
+    std::atomic<uint64_t> m_queuedTicket{0};
+    uint64_t m_swappedTicket = 0;
+    uint64_t m_writtenTicket = 0;
+    std::atomic<uint64_t> m_syncedTicket{0};
+    // m_writtenTicket as published to readers, once per pass
+    std::atomic<uint64_t> m_visibleTicket{0};
+
+    // io_uring requests outstanding for this instance; writer thread only
+    bool m_writeInFlight = false;
+    bool m_syncInFlight = false;
+
+    std::chrono::steady_clock::time_point m_lastSync;
+    // a file was created since the last sync, so its directory entry needs syncing too
+    bool m_createdFile = false;
+
+    // cleared while the FileWriter isn't running, so nobody waits on a sync forever
+    std::atomic<bool> m_writerRunning{false};
+
+    std::mutex m_syncMutex;
+    std::condition_variable m_syncCV;
+    std::vector<std::pair<uint64_t, std::function<void()>>> m_syncCallbacks;
 
-    std::vector<LogEntry> m_logEntryQueue;
-    std::vector<LogEntry> m_logEntryBuffer;
+    std::vector<FileOp> m_opsBuffer;
 
-    std::atomic<bool> m_shouldReset;
+    // set by the push that finds the instance idle, which then links it into
+    // the owner's dirty list; cleared by the writer before it drains m_queue
     std::atomic<bool> m_dirty;
-    bool m_formatFIXMessages;
+    WriterInstance* m_nextDirty = nullptr;
+    FileWriter* m_owner = nullptr;
+
+    MessageFormat m_messageFormat;
+    std::string m_session;
+
+    // set for block-compressed files; writer thread only once writes start
+    std::unique_ptr<BlockCompressor> m_compressor;
+    std::string m_compressBuffer;
+
+    // fixed before writes start
+    uint64_t m_preallocateBytes = 0;
+    RotationPolicy m_rotation;
+
+    // size of the file m_fd writes to, when it's next due to rotate (min() =
+    // not worked out yet) and whether its .next needs setting up; writer thread only
+    uint64_t m_fileSize = 0;
+    std::chrono::system_clock::time_point m_nextRotation = std::chrono::system_clock::time_point::min();
+    bool m_prepareNext = false;
 
     friend class FileWriter;
 };
@@ -73,22 +291,118 @@ public:
     FileWriter();
     ~FileWriter();
 
-    void start();
+    // With ioUring, each pass submits the writes (and syncs) of every dirty
+    // instance as one io_uring batch and picks up their completions on later
+    // passes, so one slow file doesn't hold up the rest. Falls back to
+    // blocking writes if io_uring can't be set up.
+    void start(bool ioUring = false);
     void stop();
 
-    std::unique_ptr<WriterInstance>& createInstance(const std::string& fileName, bool formatFIXMessages = false);
+    std::unique_ptr<WriterInstance>& createInstance(const std::string& fileName, MessageFormat messageFormat = MessageFormat::RAW,
+                                                    std::string session = {});
+
+    // Runs task on the writer thread once everything queued before the call
+    // has been written. The task may replace files behind any instance, so
+    // every instance reopens its file afterwards.
+    void post(std::function<void()> task);
 
 private:
     void process();
-    void flushInstances();
+    // returns whether any instance had anything to write
+    bool flushInstances();
+    void markDirty(WriterInstance& instance);
+    void wake();
+    // blocks until woken or until (time_point::max() = no deadline)
+    void sleep(std::chrono::steady_clock::time_point until);
+    void runTasks(std::vector<std::function<void()>>& tasks);
+
+    bool openInstance(WriterInstance& instance);
+    void writeAll(WriterInstance& instance, const char* data, size_t length);
+    bool writeBuffer(WriterInstance& instance, size_t begin, size_t end);
+    void applyOp(WriterInstance& instance, const WriterInstance::FileOp& op);
+    // compresses m_buffer from begin on, moving the ops to match
+    void compressBuffer(WriterInstance& instance, size_t begin);
+
+    // reserves instance's preallocation for the file fd writes to
+    void reserve(WriterInstance& instance, int fd, const std::string& path);
+    void preallocateFile(WriterInstance& instance, const std::string& path);
+    // gives back whatever of the reservation the current file didn't use
+    void releaseReservation(WriterInstance& instance);
+
+    // whether the current file should rotate before pending more bytes go in
+    bool rotationDue(WriterInstance& instance, size_t pending);
+    // rotates after writing the first carried bytes of m_buffer to the old file
+    void rotateInstance(WriterInstance& instance, size_t carried);
+    void archive(WriterInstance& instance);
+
+    // Syncs instances per their durability; force syncs anything unsynced
+    // regardless. Returns when the next periodic sync falls due.
+    std::chrono::steady_clock::time_point syncInstances(bool force);
+    // false if the data sync was submitted to the ring and completes later
+    bool syncInstance(WriterInstance& instance);
+    void completeSync(WriterInstance& instance, uint64_t ticket);
+    void closeInstance(WriterInstance& instance);
+
+    struct Submission
+    {
+        enum Kind : uint8_t
+        {
+            WRITE,
+            SYNC
+        };
+
+        Kind m_kind;
+        WriterInstance* m_instance;
+        uint64_t m_ticket;
+        size_t m_length;
+        int m_slot;  // registered buffer holding the data, -1 if written from the instance buffer
+    };
+
+    bool initRing();
+    io_uring_sqe* nextSqe();
+    uint64_t addSubmission(const Submission& submission);
+    bool submitWrite(WriterInstance& instance);
+    bool submitSync(WriterInstance& instance);
+    size_t reapCompletions();
+    void completeSubmission(const io_uring_cqe& cqe);
+    void drainRing();
 
     std::thread m_thread;
 
     HashMapT<std::string, std::unique_ptr<WriterInstance>> m_instances;
 
+    // instances made dirty since the writer last looked, pushed by producers
+    std::atomic<WriterInstance*> m_dirtyHead{nullptr};
+    // dirty instances the writer has taken but not drained yet (write in flight)
+    std::vector<WriterInstance*> m_pending;
+
+    // eventfd the writer blocks on while idle; producers only signal it then
+    int m_wakeFd = -1;
+    std::atomic<bool> m_sleeping{false};
+
+    std::mutex m_taskMutex;
+    std::vector<std::function<void()>> m_tasks;
+    std::atomic<bool> m_hasTasks{false};
+
     std::atomic<bool> m_enabled;
 
+    IoUring m_ring;
+    bool m_async = false;
+    bool m_ringEventFd = false;
+    std::vector<Submission> m_submissions;
+    std::vector<uint32_t> m_freeSubmissions;
+    size_t m_inFlight = 0;
+
+    // registered once at start; small writes are copied in and written with WRITE_FIXED
+    std::unique_ptr<char[]> m_fixedBuffers;
+    std::vector<int> m_freeSlots;
+
+    // compresses and prunes rotated files; started by the first rotating instance
+    std::unique_ptr<Dispatcher> m_archiver;
+
     CREATE_LOGGER("FileWriter");
+
+    friend class WriterInstance;
 };
 
 #undef BUF_SIZE
@@ -0,0 +1,276 @@
+#include "IoUring.h"
+
+#include <linux/time_types.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+template <typename T>
+T loadAcquire(T* p)
+{
+    return std::atomic_ref<T>(*p).load(std::memory_order_acquire);
+}
+
+template <typename T>
+void storeRelease(T* p, T value)
+{
+    std::atomic_ref<T>(*p).store(value, std::memory_order_release);
+}
+
+template <typename T>
+T* at(void* base, uint32_t offset)
+{
+    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+}  // namespace
+
+IoUring::~IoUring()
+{
+    close();
+}
+
+bool IoUring::init(unsigned entries)
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CLAMP;
+
+    const int fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+        LOG_INFO("io_uring unavailable: " << std::strerror(errno));
+        return false;
+    }
+    m_fd = fd;
+    m_extArg = params.features & IORING_FEAT_EXT_ARG;
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap)
+        m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+
+    m_sqRing = ::mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED) {
+        m_sqRing = nullptr;
+        close();
+        return false;
+    }
+
+    if (singleMmap) {
+        m_cqRing = m_sqRing;
+    } else {
+        m_cqRing = ::mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+        if (m_cqRing == MAP_FAILED) {
+            m_cqRing = nullptr;
+            close();
+            return false;
+        }
+    }
+
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        close();
+        return false;
+    }
+    m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+    m_sqHead = at<unsigned>(m_sqRing, params.sq_off.head);
+    m_sqTail = at<unsigned>(m_sqRing, params.sq_off.tail);
+    m_sqArray = at<unsigned>(m_sqRing, params.sq_off.array);
+    m_sqMask = *at<unsigned>(m_sqRing, params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+
+    m_cqHead = at<unsigned>(m_cqRing, params.cq_off.head);
+    m_cqTail = at<unsigned>(m_cqRing, params.cq_off.tail);
+    m_cqes = at<io_uring_cqe>(m_cqRing, params.cq_off.cqes);
+    m_cqMask = *at<unsigned>(m_cqRing, params.cq_off.ring_mask);
+    m_cqEntries = params.cq_entries;
+
+    m_sqeTail = *m_sqTail;
+    m_published = m_sqeTail;
+    return true;
+}
+
+void IoUring::close()
+{
+    if (m_sqes)
+        ::munmap(m_sqes, m_sqesSize);
+    if (m_cqRing && m_cqRing != m_sqRing)
+        ::munmap(m_cqRing, m_cqRingSize);
+    if (m_sqRing)
+        ::munmap(m_sqRing, m_sqRingSize);
+    if (m_fd >= 0)
+        ::close(m_fd);
+
+    m_sqes = nullptr;
+    m_sqRing = m_cqRing = nullptr;
+    m_fd = -1;
+}
+
+bool IoUring::registerBuffers(const iovec* buffers, unsigned count)
+{
+    if (::syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_BUFFERS, buffers, count) != 0) {
+        LOG_INFO("Unable to register io_uring buffers: " << std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool IoUring::registerEventFd(int fd)
+{
+    if (::syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_EVENTFD, &fd, 1) != 0) {
+        LOG_INFO("Unable to register io_uring eventfd: " << std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool IoUring::registerBufferRing(io_uring_buf_ring* ring, unsigned entries, uint16_t group)
+{
+    io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+    reg.ring_entries = entries;
+    reg.bgid = group;
+
+    if (::syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        LOG_INFO("Unable to register io_uring buffer ring: " << std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+io_uring_sqe* IoUring::getSqe()
+{
+    if (m_sqeTail - loadAcquire(m_sqHead) >= m_sqEntries)
+        return nullptr;
+
+    io_uring_sqe* sqe = &m_sqes[m_sqeTail & m_sqMask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    ++m_sqeTail;
+    return sqe;
+}
+
+int IoUring::enter(unsigned toSubmit, unsigned minComplete, unsigned flags, const void* arg, size_t argSize)
+{
+    int ret;
+    do {
+        ret = static_cast<int>(::syscall(__NR_io_uring_enter, m_fd, toSubmit, minComplete, flags, arg, argSize));
+    } while (ret < 0 && errno == EINTR);
+    return ret < 0 ? -errno : ret;
+}
+
+int IoUring::submit()
+{
+    // publish the SQEs handed out since the last submit; slot i holds SQE i
+    for (; m_published != m_sqeTail; ++m_published)
+        m_sqArray[m_published & m_sqMask] = m_published & m_sqMask;
+    storeRelease(m_sqTail, m_sqeTail);
+
+    // anything the kernel hasn't consumed yet, including leftovers from a partial submit
+    const unsigned toSubmit = m_sqeTail - loadAcquire(m_sqHead);
+    if (toSubmit == 0)
+        return 0;
+    return enter(toSubmit, 0, 0, nullptr, 0);
+}
+
+void IoUring::wait(std::chrono::microseconds timeout)
+{
+    submit();
+    if (loadAcquire(m_cqTail) != *m_cqHead)
+        return;
+
+    if (!m_extArg) {
+        std::this_thread::sleep_for(timeout);
+        return;
+    }
+
+    __kernel_timespec ts;
+    ts.tv_sec = timeout.count() / 1'000'000;
+    ts.tv_nsec = (timeout.count() % 1'000'000) * 1000;
+
+    io_uring_getevents_arg arg;
+    std::memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+
+    // -ETIME just means nothing completed in time
+    enter(0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+size_t IoUring::reap(const std::function<void(const io_uring_cqe&)>& fn)
+{
+    unsigned head = *m_cqHead;
+    const unsigned tail = loadAcquire(m_cqTail);
+
+    size_t count = 0;
+    for (; head != tail; ++head, ++count) {
+        // copied out so fn may submit (and complete) more work
+        const io_uring_cqe cqe = m_cqes[head & m_cqMask];
+        storeRelease(m_cqHead, head + 1);
+        fn(cqe);
+    }
+    return count;
+}
+
+////////////////////////////////////////////
+//           IoUringBufferRing            //
+////////////////////////////////////////////
+
+IoUringBufferRing::~IoUringBufferRing()
+{
+    if (m_ring)
+        ::munmap(m_ring, m_ringBytes);
+    if (m_buffers)
+        ::munmap(m_buffers, m_bufferBytes);
+}
+
+bool IoUringBufferRing::init(IoUring& ring, uint16_t group, unsigned count, unsigned size)
+{
+    // the ring itself has to be page aligned, so both come straight from mmap
+    m_ringBytes = count * sizeof(io_uring_buf);
+    void* mem = ::mmap(nullptr, m_ringBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+        return false;
+    m_ring = static_cast<io_uring_buf_ring*>(mem);
+
+    m_bufferBytes = static_cast<size_t>(count) * size;
+    mem = ::mmap(nullptr, m_bufferBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+        return false;
+    m_buffers = static_cast<char*>(mem);
+
+    m_size = size;
+    m_mask = count - 1;
+    m_group = group;
+    m_tail = 0;
+    if (!ring.registerBufferRing(m_ring, count, group))
+        return false;
+
+    for (unsigned id = 0; id < count; ++id)
+        recycle(static_cast<uint16_t>(id));
+    return true;
+}
+
+void IoUringBufferRing::recycle(uint16_t id)
+{
+    // Indexed off the ring's start rather than through m_ring->bufs: in C++
+    // the header's flex array sits after an empty struct, 8 bytes further in
+    // than where the kernel reads it.
+    io_uring_buf& buf = reinterpret_cast<io_uring_buf*>(m_ring)[m_tail & m_mask];
+    buf.addr = reinterpret_cast<uint64_t>(get(id));
+    buf.len = m_size;
+    buf.bid = id;
+    storeRelease(&m_ring->tail, ++m_tail);
+}
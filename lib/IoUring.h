@@ -0,0 +1,133 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#include "Log.h"
+
+// Minimal io_uring wrapper over the raw syscalls: one submission and one
+// completion ring, driven from a single thread. SQEs handed out by getSqe()
+// are queued locally and reach the kernel in one go on the next submit().
+class IoUring
+{
+public:
+    IoUring() = default;
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // false if io_uring is unavailable (old kernel, seccomp, disabled by sysctl)
+    bool init(unsigned entries);
+    void close();
+
+    bool valid() const
+    {
+        return m_fd >= 0;
+    }
+
+    // Registers buffers for IORING_OP_*_FIXED; false if the kernel refuses
+    // (typically RLIMIT_MEMLOCK).
+    bool registerBuffers(const iovec* buffers, unsigned count);
+
+    // Has the kernel signal fd (an eventfd) whenever a completion is posted
+    bool registerEventFd(int fd);
+
+    // Registers a provided buffer ring as buffer group `group`; false before 5.19
+    bool registerBufferRing(io_uring_buf_ring* ring, unsigned entries, uint16_t group);
+
+    // A zeroed SQE, or nullptr if the submission ring is full
+    io_uring_sqe* getSqe();
+
+    // Submits every SQE obtained since the last call, returning how many the
+    // kernel took or -errno.
+    int submit();
+
+    // Submits, then blocks until a completion is available or timeout passes.
+    void wait(std::chrono::microseconds timeout);
+
+    // Calls fn for each completion ready now; returns how many were seen.
+    size_t reap(const std::function<void(const io_uring_cqe&)>& fn);
+
+    unsigned getCqEntries() const
+    {
+        return m_cqEntries;
+    }
+
+private:
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags, const void* arg, size_t argSize);
+
+    int m_fd = -1;
+    bool m_extArg = false;
+
+    void* m_sqRing = nullptr;
+    size_t m_sqRingSize = 0;
+    void* m_cqRing = nullptr;
+    size_t m_cqRingSize = 0;
+    io_uring_sqe* m_sqes = nullptr;
+    size_t m_sqesSize = 0;
+
+    unsigned* m_sqHead = nullptr;
+    unsigned* m_sqTail = nullptr;
+    unsigned* m_sqArray = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned m_sqEntries = 0;
+
+    unsigned* m_cqHead = nullptr;
+    unsigned* m_cqTail = nullptr;
+    io_uring_cqe* m_cqes = nullptr;
+    unsigned m_cqMask = 0;
+    unsigned m_cqEntries = 0;
+
+    // SQEs handed out locally vs. published to the kernel
+    unsigned m_sqeTail = 0;
+    unsigned m_published = 0;
+
+    CREATE_LOGGER("IoUring");
+};
+
+// Buffers handed to the kernel through a provided buffer ring, for requests
+// made with IOSQE_BUFFER_SELECT: each completion names the buffer it filled
+// (cqe.flags >> IORING_CQE_BUFFER_SHIFT), which is the caller's until recycled.
+class IoUringBufferRing
+{
+public:
+    IoUringBufferRing() = default;
+    ~IoUringBufferRing();
+
+    IoUringBufferRing(const IoUringBufferRing&) = delete;
+    IoUringBufferRing& operator=(const IoUringBufferRing&) = delete;
+
+    // count (a power of two) buffers of size bytes each, all given to the kernel
+    bool init(IoUring& ring, uint16_t group, unsigned count, unsigned size);
+
+    uint16_t getGroup() const
+    {
+        return m_group;
+    }
+
+    char* get(uint16_t id) const
+    {
+        return m_buffers + static_cast<size_t>(id) * m_size;
+    }
+
+    // gives a buffer back to the kernel
+    void recycle(uint16_t id);
+
+private:
+    io_uring_buf_ring* m_ring = nullptr;
+    size_t m_ringBytes = 0;
+    char* m_buffers = nullptr;
+    size_t m_bufferBytes = 0;
+
+    unsigned m_size = 0;
+    unsigned m_mask = 0;
+    uint16_t m_tail = 0;
+    uint16_t m_group = 0;
+
+    CREATE_LOGGER("IoUring");
+};
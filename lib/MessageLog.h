@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "Utils.h"
+
+// How a WriterInstance lays out writeMessage() entries.
+//   RAW     - text lines, message bytes as given
+//   TEXT    - text lines, SOH shown as '|'
+//   BINARY  - length-prefixed MessageLog records, nothing formatted
+enum class MessageFormat : uint8_t
+{
+    RAW,
+    TEXT,
+    BINARY
+};
+
+// Message log records. A text record is one line:
+//   <YYYYMMDD-HH:MM:SS.ffffff> RECV: <message>
+// A binary record keeps the same fields raw, in native byte order:
+//   length(4) epoch_us(8) inbound(1) reserved(1) session length(2) session message
+// where length counts every byte after itself.
+struct MessageLog
+{
+    static constexpr size_t BINARY_HEADER_SIZE = 16;
+
+    struct Record
+    {
+        int64_t m_epochUs = 0;
+        bool m_inbound = false;
+        std::string_view m_session;
+        std::string_view m_message;
+    };
+
+    enum class ReadResult
+    {
+        OK,
+        INCOMPLETE,
+        CORRUPT
+    };
+
+    static void appendText(std::string& out, const Record& record, bool pipes)
+    {
+        out += Utils::formatTimestampMicros(record.m_epochUs);
+        out += record.m_inbound ? " RECV: " : " SENT: ";
+
+        const size_t start = out.size();
+        out += record.m_message;
+        if (pipes) {
+            for (size_t i = start; i < out.size(); ++i) {
+                if (out[i] == '\x01')
+                    out[i] = '|';
+            }
+        }
+        out += '\n';
+    }
+
+    static void appendBinary(std::string& out, const Record& record)
+    {
+        const auto sessionLength = static_cast<uint16_t>(record.m_session.size());
+        const auto length = static_cast<uint32_t>(BINARY_HEADER_SIZE - sizeof(uint32_t) + sessionLength + record.m_message.size());
+        const uint8_t flags[2] = {static_cast<uint8_t>(record.m_inbound), 0};
+
+        char hdr[BINARY_HEADER_SIZE];
+        std::memcpy(hdr, &length, sizeof(length));
+        std::memcpy(hdr + 4, &record.m_epochUs, sizeof(record.m_epochUs));
+        std::memcpy(hdr + 12, flags, sizeof(flags));
+        std::memcpy(hdr + 14, &sessionLength, sizeof(sessionLength));
+
+        out.append(hdr, sizeof(hdr));
+        out.append(record.m_session.data(), sessionLength);
+        out += record.m_message;
+    }
+
+    // Parses the binary record data starts with. On OK, size is the number of
+    // bytes it takes up and record's views point into data.
+    static ReadResult readBinary(std::string_view data, Record& record, size_t& size)
+    {
+        if (data.size() < BINARY_HEADER_SIZE)
+            return ReadResult::INCOMPLETE;
+
+        uint32_t length;
+        uint16_t sessionLength;
+        std::memcpy(&length, data.data(), sizeof(length));
+        std::memcpy(&record.m_epochUs, data.data() + 4, sizeof(record.m_epochUs));
+        std::memcpy(&sessionLength, data.data() + 14, sizeof(sessionLength));
+
+        if (length < BINARY_HEADER_SIZE - sizeof(uint32_t) + sessionLength || data[12] > 1)
+            return ReadResult::CORRUPT;
+
+        size = sizeof(uint32_t) + length;
+        if (data.size() < size)
+            return ReadResult::INCOMPLETE;
+
+        record.m_inbound = data[12] == 1;
+        record.m_session = data.substr(BINARY_HEADER_SIZE, sessionLength);
+        record.m_message = data.substr(BINARY_HEADER_SIZE + sessionLength, size - BINARY_HEADER_SIZE - sessionLength);
+        return ReadResult::OK;
+    }
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// Unbounded multi-producer, single-consumer queue (Vyukov's linked-list
+// queue). A push is a counter increment and one atomic exchange, and never
+// waits on the consumer or other producers. Unlike LockFreeQueueT, items come
+// out in one total order - the order of those exchanges - even across
+// producer threads. Each push is also numbered by the counter. Two producers
+// can take numbers in one order and exchange in the other, so pop doesn't
+// report the item's own number but the highest position through which every
+// push has come out.
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue()
+        : m_head(new Node)
+        , m_tail(m_head.load(std::memory_order_relaxed))
+    {}
+
+    ~MpscQueue()
+    {
+        T value;
+        uint64_t position;
+        while (pop(value, position)) {
+        }
+        delete m_tail;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Returns the item's position, counting from 1. Once pop reports it, the
+    // item has come out.
+    uint64_t push(T value)
+    {
+        const uint64_t position = m_pushed.fetch_add(1, std::memory_order_relaxed) + 1;
+        Node* node = new Node{std::move(value), position};
+
+        // prev can't be consumed (and freed) before it links to node
+        Node* prev = m_head.exchange(node, std::memory_order_acq_rel);
+        prev->m_next.store(node, std::memory_order_release);
+        return position;
+    }
+
+    // Consumer only. False if the queue is empty, or if the next push has
+    // claimed its place but not yet linked in; it shows up on a later pop.
+    // position is the highest through which every push has been popped; it
+    // lags the item's own while a lower-numbered push is still to link in.
+    bool pop(T& value, uint64_t& position)
+    {
+        Node* next = m_tail->m_next.load(std::memory_order_acquire);
+        if (!next)
+            return false;
+
+        // next becomes the new (already consumed) tail
+        value = std::move(next->m_value);
+        if (next->m_position == m_popped + 1) {
+            ++m_popped;
+            while (!m_early.empty() && m_early.top() == m_popped + 1) {
+                m_early.pop();
+                ++m_popped;
+            }
+        } else {
+            m_early.push(next->m_position);
+        }
+        position = m_popped;
+        delete m_tail;
+        m_tail = next;
+        return true;
+    }
+
+    // Consumer only
+    bool empty() const
+    {
+        return m_tail->m_next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node
+    {
+        T m_value{};
+        uint64_t m_position = 0;
+        std::atomic<Node*> m_next{nullptr};
+    };
+
+    alignas(64) std::atomic<Node*> m_head;
+    alignas(64) std::atomic<uint64_t> m_pushed{0};
+
+    // consumer only
+    alignas(64) Node* m_tail;
+    uint64_t m_popped = 0;
+    // popped ahead of a lower position that hasn't come out yet
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> m_early;
+};
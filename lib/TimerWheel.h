@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Hierarchical timing wheel with millisecond ticks, for a single thread.
+// Level 0 has a slot per ms for the next SLOTS ms, each level above covers
+// SLOTS times the span of the one below, and a slot's entries cascade down a
+// level when time reaches it. Scheduling is O(1), and so is advancing per
+// entry; empty stretches of time are skipped a level-0 turn at a time.
+//
+// There's no cancel: owners that move a deadline later leave the old entry to
+// fire and check for themselves whether anything is actually due.
+template <typename T>
+class TimerWheel
+{
+public:
+    static constexpr int LEVEL_BITS = 8;
+    static constexpr int LEVELS = 4;
+    static constexpr int64_t SLOTS = int64_t{1} << LEVEL_BITS;
+    static constexpr int64_t NONE = std::numeric_limits<int64_t>::max();
+
+    explicit TimerWheel(int64_t nowMs)
+        : m_now(nowMs)
+    {}
+
+    // Deadlines already past fire on the next advance(); ones further out than
+    // the wheel spans (about 49 days) fire early, at its far end.
+    void schedule(int64_t deadlineMs, T value)
+    {
+        insert({deadlineMs, std::move(value)});
+        ++m_size;
+    }
+
+    // Moves time on to nowMs and calls fn(value) on every entry that's come
+    // due, after the wheel is done with them, so fn may schedule more.
+    template <typename Fn>
+    void advance(int64_t nowMs, Fn&& fn)
+    {
+        while (m_now < nowMs && m_size > m_due.size()) {
+            // nothing in level 0 means nothing fires before the next cascade
+            if (m_counts[0] == 0) {
+                const int64_t turnEnd = m_now | (SLOTS - 1);
+                if (turnEnd >= nowMs)
+                    break;
+                m_now = turnEnd;
+            }
+
+            ++m_now;
+            cascade();
+
+            auto& slot = m_slots[0][m_now & (SLOTS - 1)];
+            m_counts[0] -= slot.size();
+            for (auto& entry : slot)
+                m_due.push_back(std::move(entry));
+            slot.clear();
+        }
+        if (m_now < nowMs)
+            m_now = nowMs;
+
+        if (m_due.empty())
+            return;
+
+        m_firing.swap(m_due);
+        m_size -= m_firing.size();
+        for (auto& entry : m_firing)
+            fn(std::move(entry.m_value));
+        m_firing.clear();
+    }
+
+    // Earliest time advance() might have something to fire (a cascade, if the
+    // nearest entries are on a higher level), or NONE if the wheel is empty
+    int64_t nextDeadline() const
+    {
+        if (!m_due.empty())
+            return m_now;
+
+        int64_t next = NONE;
+        for (int level = 0; level < LEVELS; ++level) {
+            if (m_counts[level] == 0)
+                continue;
+
+            // level 0 slots fire at their ms; higher ones at the tick they cascade
+            const int shift = level * LEVEL_BITS;
+            const int64_t tick = m_now >> shift;
+            for (int64_t step = 1; step <= SLOTS; ++step) {
+                if (!m_slots[level][(tick + step) & (SLOTS - 1)].empty()) {
+                    next = std::min(next, (tick + step) << shift);
+                    break;
+                }
+            }
+        }
+        return next;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+private:
+    struct Entry
+    {
+        int64_t m_deadline;
+        T m_value;
+    };
+
+    void insert(Entry&& entry)
+    {
+        const int64_t delta = entry.m_deadline - m_now;
+        if (delta <= 0) {
+            m_due.push_back(std::move(entry));
+            return;
+        }
+
+        int level = 0;
+        while (level < LEVELS - 1 && delta >= (int64_t{1} << ((level + 1) * LEVEL_BITS)))
+            ++level;
+        // past the top level's span: park it in the furthest slot there is
+        if (delta >= (int64_t{1} << (LEVELS * LEVEL_BITS)))
+            entry.m_deadline = m_now + (int64_t{1} << (LEVELS * LEVEL_BITS)) - 1;
+
+        m_slots[level][(entry.m_deadline >> (level * LEVEL_BITS)) & (SLOTS - 1)].push_back(std::move(entry));
+        ++m_counts[level];
+    }
+
+    // Redistributes the slots of the levels that just turned over at m_now,
+    // highest first, so entries land in the slots below before those are read
+    void cascade()
+    {
+        int top = 0;
+        while (top < LEVELS - 1 && ((m_now >> ((top + 1) * LEVEL_BITS)) << ((top + 1) * LEVEL_BITS)) == m_now)
+            ++top;
+
+        for (int level = top; level > 0; --level) {
+            auto& slot = m_slots[level][(m_now >> (level * LEVEL_BITS)) & (SLOTS - 1)];
+            if (slot.empty())
+                continue;
+
+            m_counts[level] -= slot.size();
+            m_cascading.swap(slot);
+            for (auto& entry : m_cascading)
+                insert(std::move(entry));
+            m_cascading.clear();
+        }
+    }
+
+    int64_t m_now;
+    size_t m_size = 0;
+
+    std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> m_slots;
+    std::array<size_t, LEVELS> m_counts{};
+
+    // entries past their deadline, waiting for advance() to fire them
+    std::vector<Entry> m_due;
+    std::vector<Entry> m_firing;
+    std::vector<Entry> m_cascading;
+};
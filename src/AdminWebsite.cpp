@@ -1,14 +1,19 @@
 #include "AdminWebsite.h"
 
+#include <openfix/CompressedLog.h>
 #include <openfix/CpuOrchestrator.h>
+#include <openfix/MessageLog.h>
 
 #include "Application.h"
 #include "Session.h"
 
 #include <algorithm>
 #include <fstream>
+#include <iomanip>
+#include <iterator>
 #include <sstream>
 #include <string>
+#include <strings.h>
 #include <unordered_map>
 #include <vector>
 
@@ -250,6 +255,114 @@ std::vector<std::string> readLogTail(const std::string& path, int maxLines, cons
     return lines;
 }
 
+// Decodes the binary records data starts with into text lines. Returns how
+// much of data they took up, or npos if it's corrupt.
+size_t decodeBinaryLines(std::string_view data, const std::string& filter, std::vector<std::string>& lines)
+{
+    size_t pos = 0;
+    MessageLog::Record record;
+    size_t size;
+    std::string line;
+    for (;;) {
+        const auto result = MessageLog::readBinary(data.substr(pos), record, size);
+        if (result == MessageLog::ReadResult::CORRUPT)
+            return std::string_view::npos;
+        if (result == MessageLog::ReadResult::INCOMPLETE)
+            return pos;
+        pos += size;
+
+        line.clear();
+        MessageLog::appendText(line, record, true);
+        line.pop_back();
+        if (filter.empty() || line.find(filter) != std::string::npos)
+            lines.push_back(std::move(line));
+    }
+}
+
+void splitLines(std::string_view data, const std::string& filter, std::vector<std::string>& lines)
+{
+    while (!data.empty()) {
+        const size_t eol = data.find('\n');
+        const std::string_view line = data.substr(0, eol);
+        if (!line.empty() && (filter.empty() || line.find(filter) != std::string_view::npos))
+            lines.emplace_back(line);
+        data = eol == std::string_view::npos ? std::string_view() : data.substr(eol + 1);
+    }
+}
+
+void trimLines(std::vector<std::string>& lines, int maxLines)
+{
+    if (static_cast<int>(lines.size()) > maxLines)
+        lines.erase(lines.begin(), lines.begin() + (lines.size() - maxLines));
+}
+
+// binary logs have no line breaks to seek back to, so they're decoded from the start
+std::vector<std::string> readBinaryLogTail(const std::string& path, int maxLines, const std::string& filter)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return {};
+
+    std::vector<std::string> lines;
+    std::string buffer;
+    char chunk[64 * 1024];
+    while (file.read(chunk, sizeof(chunk)) || file.gcount() > 0) {
+        buffer.append(chunk, static_cast<size_t>(file.gcount()));
+
+        const size_t used = decodeBinaryLines(buffer, filter, lines);
+        trimLines(lines, maxLines);
+        if (used == std::string_view::npos)
+            break;
+        buffer.erase(0, used);
+    }
+    return lines;
+}
+
+// compressed logs are decompressed a frame at a time, from the last one back
+std::vector<std::string> readCompressedLogTail(const std::string& path, int maxLines, const std::string& filter, bool binary)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+        return {};
+    const auto fileSize = static_cast<uint64_t>(file.tellg());
+
+    // whatever precedes the first indexed frame (all of it, without an index) is read as one run
+    auto frames = CompressedLog::readIndex(path);
+    while (!frames.empty() && frames.back() >= fileSize)
+        frames.pop_back();
+    if (frames.empty() || frames.front() != 0)
+        frames.insert(frames.begin(), 0);
+
+    std::vector<std::string> lines;
+    std::vector<std::string> frameLines;
+    std::string compressed;
+    std::string raw;
+    BlockDecompressor decompressor;
+    uint64_t end = fileSize;
+    for (auto it = frames.rbegin(); it != frames.rend() && static_cast<int>(lines.size()) < maxLines; ++it) {
+        compressed.resize(end - *it);
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(*it));
+        file.read(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+        end = *it;
+
+        // a frame cut short still gives up what was flushed of it
+        raw.clear();
+        decompressor.reset();
+        decompressor.decompress(compressed, raw);
+
+        frameLines.clear();
+        if (binary)
+            decodeBinaryLines(raw, filter, frameLines);
+        else
+            splitLines(raw, filter, frameLines);
+        lines.insert(lines.begin(), std::make_move_iterator(frameLines.begin()), std::make_move_iterator(frameLines.end()));
+    }
+
+    trimLines(lines, maxLines);
+    return lines;
+}
+
 std::unordered_map<std::string, std::string> parseFormBody(const std::string& body)
 {
     std::unordered_map<std::string, std::string> result;
@@ -318,6 +431,14 @@ void AdminWebsite::start()
 
     // ── Dashboard ────────────────────────────────────────────────────────────
     CROW_ROUTE(m_website, "/")([this](const crow::request&, crow::response& res) {
+        // session -> the reader its connection is on
+        const auto readers = m_app.getReaderStats();
+        std::unordered_map<std::string, std::string> sessionReaders;
+        for (const auto& reader : readers) {
+            for (const auto& sessionID : reader.m_sessions)
+                sessionReaders[sessionID] = reader.m_name;
+        }
+
         std::ostringstream body;
         body << "<div class=\"page-title\">Sessions</div>";
         body << "<div class=\"card\">";
@@ -329,7 +450,7 @@ void AdminWebsite::start()
                  << "<thead><tr>"
                  << "<th>Name</th><th>Type</th><th>FIX Version</th>"
                  << "<th>State</th><th>Connected</th><th>Enabled</th>"
-                 << "<th>Sender SeqNum</th><th>Target SeqNum</th>"
+                 << "<th>Sender SeqNum</th><th>Target SeqNum</th><th>Reader</th>"
                  << "</tr></thead><tbody>";
 
             for (auto& [name, session] : m_app.m_sessionMap) {
@@ -347,12 +468,53 @@ void AdminWebsite::start()
                      << "<td><span class=\"dot " << (enabled ? "dot-green" : "dot-red") << "\"></span>" << (enabled ? "Yes" : "No") << "</td>"
                      << "<td>" << session->getSenderSeqNum() << "</td>"
                      << "<td>" << session->getTargetSeqNum() << "</td>"
+                     << "<td>" << htmlEscape(sessionReaders[settings.getSessionID()]) << "</td>"
                      << "</tr>";
             }
             body << "</tbody></table>";
         }
         body << "</div>";
 
+        // ── Reader threads ──
+        if (!readers.empty()) {
+            body << "<div class=\"card\"><h2>Reader Threads</h2><table>"
+                 << "<thead><tr>"
+                 << "<th>Name</th><th>Pool</th><th>Busy Poll</th><th>Placed</th>"
+                 << "<th>Connections</th><th>Sessions</th><th>Messages</th><th>Bytes</th><th>Busy</th>"
+                 << "<th>Load</th><th>Moved In</th><th>Moved Out</th><th>Wakeups</th><th>Flushes</th><th>Spins</th>"
+                 << "</tr></thead><tbody>";
+            for (const auto& reader : readers) {
+                std::string sessions;
+                for (const auto& sessionID : reader.m_sessions)
+                    sessions += (sessions.empty() ? "" : ", ") + sessionID;
+
+                std::ostringstream busy, load;
+                busy << std::fixed << std::setprecision(1) << reader.m_busy * 100.0 << '%';
+                load << std::fixed << std::setprecision(1) << reader.m_load * 100.0 << '%';
+
+                body << "<tr>"
+                     << "<td>" << htmlEscape(reader.m_name) << "</td>"
+                     << "<td>" << htmlEscape(reader.m_pool) << "</td>"
+                     << "<td>" << (reader.m_busyPoll ? "Yes" : "No") << "</td>"
+                     << "<td>" << reader.m_placed << "</td>"
+                     << "<td>" << reader.m_connections << "</td>"
+                     << "<td>" << htmlEscape(sessions) << "</td>"
+                     << "<td>" << reader.m_messages << "</td>"
+                     << "<td>" << reader.m_bytes << "</td>"
+                     << "<td>" << busy.str() << "</td>"
+                     << "<td>" << load.str() << "</td>"
+                     << "<td>" << reader.m_movedIn << "</td>"
+                     << "<td>" << reader.m_movedOut << "</td>"
+                     << "<td>" << reader.m_wakeups << "</td>"
+                     << "<td>" << reader.m_flushes << "</td>"
+                     << "<td>" << reader.m_spins << "</td>"
+                     << "</tr>";
+            }
+            body << "</tbody></table>"
+                 << "<p class=\"empty\" style=\"margin-top:10px\">Connections moved by rebalancing: " << m_app.m_network->getRebalanceCount() << "</p>"
+                 << "</div>";
+        }
+
         res.body = buildPage("Dashboard", "", body.str(), true, 5000);
         res.end();
     });
@@ -392,6 +554,18 @@ void AdminWebsite::start()
              << "<div class=\"stat-value\">" << session.getSenderSeqNum() << "</div></div>";
         body << "<div class=\"stat-item\"><div class=\"stat-label\">Target SeqNum</div>"
              << "<div class=\"stat-value\">" << session.getTargetSeqNum() << "</div></div>";
+
+        // where it's placed, and where its connection is now
+        std::string reader;
+        for (const auto& stats : m_app.getReaderStats()) {
+            if (std::find(stats.m_sessions.begin(), stats.m_sessions.end(), settings.getSessionID()) != stats.m_sessions.end())
+                reader = stats.m_name;
+        }
+        const std::string placement = m_app.m_network->getPlacement(settings.getSessionID());
+        body << "<div class=\"stat-item\"><div class=\"stat-label\">Placement</div>"
+             << "<div class=\"stat-value\">" << (placement.empty() ? "&mdash;" : htmlEscape(placement)) << "</div></div>";
+        body << "<div class=\"stat-item\"><div class=\"stat-label\">Reader</div>"
+             << "<div class=\"stat-value\">" << (reader.empty() ? "&mdash;" : htmlEscape(reader)) << "</div></div>";
         body << "</div></div>";
 
         // Controls card
@@ -464,6 +638,9 @@ void AdminWebsite::start()
         brow("TCPNoDelay",             settings.getBool(SessionSettings::ENABLE_TCP_NODELAY));
         brow("TCPQuickAck",            settings.getBool(SessionSettings::ENABLE_TCP_QUICKACK));
         row("FIXDictionary",           settings.getString(SessionSettings::FIX_DICTIONARY));
+        row("ReaderThread",            settings.getString(SessionSettings::READER_THREAD));
+        row("ReaderPool",              settings.getString(SessionSettings::READER_POOL));
+        row("ReaderPriority",          settings.getString(SessionSettings::READER_PRIORITY));
         row("StartTime",               settings.getString(SessionSettings::START_TIME));
         row("StopTime",                settings.getString(SessionSettings::STOP_TIME));
 
@@ -543,8 +720,12 @@ void AdminWebsite::start()
 
         if (tail <= 0 || tail > 5000) tail = 200;
 
-        const std::string logPath = getLogBase(session) + ".messages.log";
-        const auto lines = readLogTail(logPath, tail, filter);
+        const bool binary = strcasecmp(PlatformSettings::getString(PlatformSettings::LOG_FORMAT).c_str(), "binary") == 0;
+        const bool compressed = strcasecmp(PlatformSettings::getString(PlatformSettings::LOG_COMPRESSION).c_str(), "zstd") == 0;
+        const std::string logPath = getLogBase(session) + (binary ? ".messages.bin" : ".messages.log") + (compressed ? ".zst" : "");
+        const auto lines = compressed ? readCompressedLogTail(logPath, tail, filter, binary)
+                         : binary     ? readBinaryLogTail(logPath, tail, filter)
+                                      : readLogTail(logPath, tail, filter);
 
         const std::string nav = std::string("<span class=\"breadcrumb\"><a href=\"/\">Dashboard</a> &rsaquo; ")
                         + "<a href=\"/session/" + enc + "\">" + enc + "</a>"
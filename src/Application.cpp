@@ -1,7 +1,6 @@
 #include "Application.h"
 
 #include <openfix/CpuOrchestrator.h>
-#include <unistd.h>
 
 Application::Application()
     : Application(std::make_shared<FileLogger>(), std::make_shared<FileStore>())
@@ -29,10 +28,16 @@ void Application::start()
         return;
     m_running.store(true, std::memory_order_release);
 
+    // any reader set to spin: by default, in a busy pool (name:threads:busy) or critical
+    const bool busyPolling = PlatformSettings::getBool(PlatformSettings::READER_BUSY_POLL)
+                          || PlatformSettings::getString(PlatformSettings::READER_POOLS).find(":busy") != std::string::npos
+                          || PlatformSettings::getBool(PlatformSettings::READER_CRITICAL_BUSY_POLL);
     CpuOrchestrator::initialize(
         PlatformSettings::getString(PlatformSettings::CPU_CORES),
         PlatformSettings::getBool(PlatformSettings::CPU_AVOID_HT),
-        static_cast<int>(PlatformSettings::getLong(PlatformSettings::CPU_NUMA_NODE))
+        static_cast<int>(PlatformSettings::getLong(PlatformSettings::CPU_NUMA_NODE)),
+        PlatformSettings::getString(PlatformSettings::CPU_SPIN_CORES),
+        busyPolling
     );
 
     m_logger->start();
@@ -41,21 +46,32 @@ void Application::start()
     m_network->start();
 
     // Background thread handles disconnected session updates (reconnect logic).
-    // Connected sessions are updated inline by the ReaderThread via NetworkDelegate.
+    // Connected sessions are updated inline by the ReaderThread via NetworkDelegate,
+    // on traffic and at the deadlines they leave on its timer wheel.
     m_updateThread = std::thread([&]() {
         CpuOrchestrator::bind(ThreadRole::UPDATE);
+        const auto delay = std::chrono::milliseconds(PlatformSettings::getLong(PlatformSettings::UPDATE_DELAY));
         while (m_running.load(std::memory_order_acquire)) {
             runUpdate();
-            ::usleep(PlatformSettings::getLong(PlatformSettings::UPDATE_DELAY) * 1000);
+            std::unique_lock lock(m_updateMutex);
+            m_updateCV.wait_for(lock, delay, [&] { return !m_running.load(std::memory_order_acquire); });
         }
     });
 }
 
 void Application::stop()
 {
-    if (!m_running.load(std::memory_order_acquire))
-        return;
-    m_running.store(false, std::memory_order_release);
+    {
+        std::lock_guard lock(m_updateMutex);
+        if (!m_running.load(std::memory_order_acquire))
+            return;
+        m_running.store(false, std::memory_order_release);
+    }
+    m_updateCV.notify_all();
+
+    // the update thread may be mid-connect, so it has to finish before the
+    // network tears down its reader threads
+    m_updateThread.join();
 
     // stop all sessions while network is still alive
     for (auto& [_, session] : m_sessionMap)
@@ -65,8 +81,6 @@ void Application::stop()
 
     m_logger->stop();
     m_store->stop();
-
-    m_updateThread.join();
 }
 
 std::shared_ptr<Session> Application::createSession(const std::string& sessionName, const SessionSettings& settings)
@@ -74,6 +88,9 @@ std::shared_ptr<Session> Application::createSession(const std::string& sessionNa
     if (m_sessionMap.find(sessionName) != m_sessionMap.end())
         throw std::runtime_error("Session already exists with name: " + sessionName);
 
+    // placement checks the session's reader settings before anything's created
+    m_network->registerSession(settings);
+
     auto session = std::make_shared<Session>(settings, *m_network, m_logger, m_store);
     m_sessionMap[sessionName] = session;
     return session;
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <thread>
 
 #include "AdminWebsite.h"
@@ -31,6 +33,12 @@ public:
     void start();
     void stop();
 
+    // placement and load of each reader thread, empty while stopped
+    std::vector<ReaderStats> getReaderStats()
+    {
+        return m_network->getReaderStats();
+    }
+
 private:
     void runUpdate();
 
@@ -42,6 +50,8 @@ private:
     std::atomic<bool> m_running{false};
 
     std::thread m_updateThread;
+    std::mutex m_updateMutex;
+    std::condition_variable m_updateCV;
 
     HashMapT<std::string, std::shared_ptr<Session>> m_sessionMap;
 
@@ -185,6 +185,17 @@ public:
         instance().Config<Class>::load(settings);
     }
 
+    // a copy of every current value, for restore() to put back
+    static Config<Class> snapshot()
+    {
+        return instance();
+    }
+
+    static void restore(const Config<Class>& values)
+    {
+        static_cast<Config<Class>&>(instance()) = values;
+    }
+
 private:
     static StaticConfig<Class>& instance()
     {
@@ -202,16 +213,59 @@ struct PlatformSettings : StaticConfig<PlatformSettings>
 
     static inline ConfigItem<long> UPDATE_DELAY = createLong("UpdateDelay", 1000L);
     static inline ConfigItem<long> EPOLL_TIMEOUT = createLong("EpollTimeout", 1000L);
+    // readers spin on epoll_wait rather than sleep in it, until idle for ReaderBusyPollIdleUs
+    // (0 = always spin); spinning readers are bound to CpuSpinCores first
+    static inline ConfigItem<bool> READER_BUSY_POLL = createBool("ReaderBusyPoll", false);
+    static inline ConfigItem<long> READER_BUSY_POLL_IDLE_US = createLong("ReaderBusyPollIdleUs", 0L);
+    // SO_BUSY_POLL (us) on session sockets, with SO_PREFER_BUSY_POLL where the kernel has it (0 = off)
+    static inline ConfigItem<long> SOCKET_BUSY_POLL_US = createLong("SocketBusyPollUs", 0L);
+    // epoll or io_uring; readers fall back to epoll where io_uring is unavailable
+    static inline ConfigItem<std::string> READER_BACKEND = createString("ReaderBackend", "epoll");
+    // receive buffers (READ_BUF_SIZE each) per io_uring reader, rounded up to a power of two
+    static inline ConfigItem<long> READER_RING_BUFFERS = createLong("ReaderRingBuffers", 256L);
+    // extra reader pools beside the InputThreads readers (pool "default"), as
+    // name:threads[:busy],... e.g. "bulk:2,fast:1:busy"; busy pools spin like ReaderBusyPoll
+    static inline ConfigItem<std::string> READER_POOLS = createString("ReaderPools");
+    // the dedicated readers of critical sessions spin like ReaderBusyPoll
+    static inline ConfigItem<bool> READER_CRITICAL_BUSY_POLL = createBool("ReaderCriticalBusyPoll", false);
+    // every ReaderRebalanceIntervalMs (0 = never), a pool whose busiest reader's share of time
+    // spent handling events is ReaderRebalanceThreshold past its idlest's moves one connection over
+    static inline ConfigItem<long> READER_REBALANCE_INTERVAL_MS = createLong("ReaderRebalanceIntervalMs", 0L);
+    static inline ConfigItem<double> READER_REBALANCE_THRESHOLD = createDouble("ReaderRebalanceThreshold", 0.25);
+    // most a reader reads from one connection per turn (0 = no limit), before
+    // moving on to its other sockets; the connection has another turn next iteration
+    static inline ConfigItem<long> READ_BUDGET_BYTES = createLong("ReadBudgetBytes", 0L);
+    static inline ConfigItem<long> READ_BUDGET_MESSAGES = createLong("ReadBudgetMessages", 0L);
 
     static inline ConfigItem<std::string> LOG_PATH = createString("LogPath", "./log");
+    // text or binary (<session>.messages.bin, read with fixlog-decode)
+    static inline ConfigItem<std::string> LOG_FORMAT = createString("LogFormat", "text");
+    // none or zstd (message logs gain a .zst suffix and a .zst.idx block index)
+    static inline ConfigItem<std::string> LOG_COMPRESSION = createString("LogCompression", "none");
+    static inline ConfigItem<long> LOG_BLOCK_BYTES = createLong("LogBlockBytes", 256L * 1024);
+    // logs rotate before passing LogRotateBytes (0 = no limit) and, with LogRotateDaily, at
+    // the session's StartTime; the newest LogRetainFiles rotated files are kept (0 = all)
+    static inline ConfigItem<long> LOG_ROTATE_BYTES = createLong("LogRotateBytes", 0L);
+    static inline ConfigItem<bool> LOG_ROTATE_DAILY = createBool("LogRotateDaily", false);
+    static inline ConfigItem<long> LOG_RETAIN_FILES = createLong("LogRetainFiles", 0L);
+    static inline ConfigItem<bool> LOG_COMPRESS_ROTATED = createBool("LogCompressRotated", false);
+    static inline ConfigItem<long> LOG_PREALLOCATE_BYTES = createLong("LogPreallocateBytes", 0L);
     static inline ConfigItem<std::string> DATA_PATH = createString("DataPath", "./data");
 
+    // store and log files are written through io_uring where the kernel allows it
+    static inline ConfigItem<bool> FILE_WRITER_IO_URING = createBool("FileWriterIoUring", true);
+
+    // sessions' stores share this many journal files instead of writing their own (0 = off)
+    static inline ConfigItem<long> STORE_JOURNAL_SHARDS = createLong("StoreJournalShards", 0L);
+    static inline ConfigItem<long> STORE_JOURNAL_SEGMENT_BYTES = createLong("StoreJournalSegmentBytes", 1024L * 1024 * 1024);
+
     static inline ConfigItem<long> ADMIN_WEBSITE_PORT = createLong("AdminWebsitePort", 51234);
 
     // CPU affinity settings
     static inline ConfigItem<std::string> CPU_CORES = createString("CpuCores");         // explicit core list, e.g. "2,3,4,5"
     static inline ConfigItem<bool> CPU_AVOID_HT = createBool("CpuAvoidHT", false);      // auto-detect physical cores, skip HT siblings
     static inline ConfigItem<long> CPU_NUMA_NODE = createLong("CpuNumaNode", -1L);       // NUMA node (-1 = auto-detect best node)
+    static inline ConfigItem<std::string> CPU_SPIN_CORES = createString("CpuSpinCores"); // cores for busy-polling threads (default: kernel-isolated cores)
 };
 
 struct SessionSettings : Config<SessionSettings>
@@ -257,6 +311,15 @@ struct SessionSettings : Config<SessionSettings>
 
     static inline ConfigItem<long> CONNECT_TIMEOUT = createLong("ConnectTimeout", 5000L);
 
+    // Which reader thread carries the session's connection: ReaderThread names one
+    // (e.g. "bulk-1"), ReaderPool puts it on the least loaded of a pool's readers. Of
+    // the ReaderPriority classes, critical sessions get a reader of their own and bulk
+    // ones share the "bulk" pool, if there is one. Unplaced sessions spread over the
+    // default pool by fd.
+    static inline ConfigItem<std::string> READER_THREAD = createString("ReaderThread");
+    static inline ConfigItem<std::string> READER_POOL = createString("ReaderPool");
+    static inline ConfigItem<std::string> READER_PRIORITY = createString("ReaderPriority", "normal");
+
     static inline ConfigItem<long> HEARTBEAT_INTERVAL = createLong("HeartbeatInterval", 10L);
     static inline ConfigItem<long> LOGON_INTERVAL = createLong("LogonInterval", 10L);
     static inline ConfigItem<long> RECONNECT_INTERVAL = createLong("ReconnectInterval", 10L);
@@ -264,6 +327,32 @@ struct SessionSettings : Config<SessionSettings>
     static inline ConfigItem<double> TEST_REQUEST_THRESHOLD = createDouble("TestRequestThreshold", 2.0);
     static inline ConfigItem<long> SENDING_TIME_THRESHOLD = createLong("SendingTimeThreshold", 10L);
 
+    // outbound messages kept in memory for resend; older ones are read back from the store
+    static inline ConfigItem<long> CACHE_WINDOW = createLong("CacheWindow", 16384L);                     // messages (rounded up to a power of 2)
+    static inline ConfigItem<long> CACHE_WINDOW_BYTES = createLong("CacheWindowBytes", 16L * 1024 * 1024);  // arena size
+    // out-of-sequence inbound messages further ahead than this are left to the resend request
+    static inline ConfigItem<long> INBOUND_QUEUE_WINDOW = createLong("InboundQueueWindow", 16384L);  // messages (rounded up to a power of 2)
+
+    // the store starts a new data segment once the current one would pass this size
+    static inline ConfigItem<long> STORE_SEGMENT_BYTES = createLong("StoreSegmentBytes", 256L * 1024 * 1024);
+    // once this many sealed segments pile up, the newest StoreRetainMessages messages are
+    // copied into one segment in the background and the rest deleted (0 = never compact)
+    static inline ConfigItem<long> STORE_RETAIN_MESSAGES = createLong("StoreRetainMessages", 0L);
+    static inline ConfigItem<long> STORE_COMPACT_SEGMENTS = createLong("StoreCompactSegments", 4L);
+    // reserve StoreSegmentBytes of disk for each segment, and the next one, ahead of writing
+    static inline ConfigItem<bool> STORE_PREALLOCATE = createBool("StorePreallocate", false);
+    // none, periodic (fdatasync every StoreSyncInterval ms), group (one fdatasync per writer
+    // pass) or every (as group, and storing a message waits for its sync)
+    static inline ConfigItem<std::string> STORE_DURABILITY = createString("StoreDurability", "none");
+    static inline ConfigItem<long> STORE_SYNC_INTERVAL = createLong("StoreSyncInterval", 1000L);
+    // hold back send callbacks until the message is also durable in the store
+    static inline ConfigItem<bool> STORE_SYNCED_CALLBACKS = createBool("StoreSyncedCallbacks", false);
+
+    // message recovery is replayed in chunks, one per event-loop iteration
+    static inline ConfigItem<long> RESEND_BATCH_SIZE = createLong("ResendBatchSize", 1000L);          // max messages per chunk
+    static inline ConfigItem<long> RESEND_BATCH_BYTES = createLong("ResendBatchBytes", 256L * 1024);   // max bytes per chunk
+    static inline ConfigItem<long> RESEND_MAX_BYTES_PER_SEC = createLong("ResendMaxBytesPerSec", 0L);  // replay bandwidth cap (0 = unlimited)
+
     static inline ConfigItem<std::string> SESSION_TYPE_STR = createString("SessionType");
 
     SessionType getSessionType() const
@@ -1,35 +1,50 @@
 #include "FIXCache.h"
 
+#include <limits>
+
 MemoryCache::MemoryCache(const SessionSettings& settings, std::shared_ptr<Dictionary> dictionary, std::shared_ptr<IFIXStore> store)
     : m_settings(settings)
     , m_dictionary(std::move(dictionary))
     , m_senderSeqNum(1)
     , m_targetSeqNum(1)
+    , m_ring(settings.getLong(SessionSettings::CACHE_WINDOW), settings.getLong(SessionSettings::CACHE_WINDOW_BYTES))
+    , m_inboundQueue(64, settings.getLong(SessionSettings::INBOUND_QUEUE_WINDOW))
     , m_store(store->createStore(settings))
 {}
 
 void MemoryCache::load()
 {
+    std::lock_guard lock(m_mutex);
+
     const auto data = m_store.load();
 
-    m_messages.clear();
+    m_ring.clear();
 
     m_senderSeqNum.store(data.m_senderSeqNum, std::memory_order_release);
     m_targetSeqNum.store(data.m_targetSeqNum, std::memory_order_release);
     m_seqNumsDirty = false;
     m_pendingStoreSeqNums.clear();
 
-    // Store wire strings directly — no need to parse on load
-    for (auto& [idx, msg] : data.m_messages) {
-        m_messages.emplace(idx, std::move(msg));
-    }
+    // Only the most recent window is brought into memory; the rest stays in
+    // the store and is read back from there if a resend reaches it.
+    const int windowBegin = std::max(1, data.m_senderSeqNum - static_cast<int>(m_settings.getLong(SessionSettings::CACHE_WINDOW)));
+    WireOffsets offsets;
+    m_store.forEachMessage(windowBegin, 0, [&](int seqnum, std::string_view wire) {
+        scanWireOffsets(wire, *m_dictionary->getHeaderSpec(), offsets);
+        m_ring.append(seqnum, wire, offsets);
+        return true;
+    });
 }
 
 void MemoryCache::reset()
 {
-    m_messages.clear();
+    std::lock_guard lock(m_mutex);
+
+    m_ring.clear();
     m_inboundQueue.clear();
     m_pendingStoreSeqNums.clear();
+    // the reset covers whatever was never stored
+    releaseSyncedCallbacks(std::numeric_limits<int>::max());
 
     m_senderSeqNum.store(0, std::memory_order_release);
     m_targetSeqNum.store(0, std::memory_order_release);
@@ -76,45 +91,138 @@ int MemoryCache::nextTargetSeqNum()
 
 void MemoryCache::flushSeqNums()
 {
+    std::lock_guard lock(m_mutex);
+
     // batch write seq nums out of line
-    if (!m_pendingStoreSeqNums.empty()) {
-        for (const int seq : m_pendingStoreSeqNums) {
-            const auto it = m_messages.find(seq);
-            if (it != m_messages.end())
-                m_store.store(seq, it->second);
-        }
-        m_pendingStoreSeqNums.clear();
-    }
+    flushPendingMessages();
 
     if (!m_seqNumsDirty)
         return;
     m_seqNumsDirty = false;
-    m_store.setSenderSeqNum(m_senderSeqNum.load(std::memory_order_acquire));
-    m_store.setTargetSeqNum(m_targetSeqNum.load(std::memory_order_acquire));
+    m_store.setSeqNums(m_senderSeqNum.load(std::memory_order_acquire), m_targetSeqNum.load(std::memory_order_acquire));
+}
+
+void MemoryCache::flushPendingMessages()
+{
+    if (m_pendingStoreSeqNums.empty())
+        return;
+
+    MessageRing::Entry entry;
+    for (const int seq : m_pendingStoreSeqNums) {
+        if (m_ring.get(seq, entry))
+            m_store.store(seq, std::string(entry.m_wire));
+    }
+
+    // cleared before any callback can run and cache another message
+    const int last = m_pendingStoreSeqNums.back();
+    m_pendingStoreSeqNums.clear();
+    releaseSyncedCallbacks(last);
+}
+
+void MemoryCache::releaseSyncedCallbacks(int seqnum)
+{
+    if (m_syncedCallbacks.empty())
+        return;
+
+    const uint64_t ticket = m_store.syncTicket();
+    auto it = m_syncedCallbacks.begin();
+    while (it != m_syncedCallbacks.end() && it->first <= seqnum)
+        ++it;
+
+    // taken out first, as one run right away may send and register another
+    std::vector<std::pair<int, std::function<void()>>> released(std::make_move_iterator(m_syncedCallbacks.begin()), std::make_move_iterator(it));
+    m_syncedCallbacks.erase(m_syncedCallbacks.begin(), it);
+    for (auto& [seq, fn] : released)
+        m_store.onSynced(ticket, std::move(fn));
+}
+
+std::function<void()> MemoryCache::syncedCallback(int seqnum, std::function<void()> fn)
+{
+    if (!fn || m_store.getDurability() == Durability::NONE)
+        return fn;
+
+    std::lock_guard lock(m_mutex);
+
+    // whichever of the network write and the store sync comes second runs fn
+    auto remaining = std::make_shared<std::atomic<int>>(2);
+    auto shared = std::make_shared<std::function<void()>>(std::move(fn));
+    auto half = [remaining, shared] {
+        if (remaining->fetch_sub(1, std::memory_order_acq_rel) == 1)
+            (*shared)();
+    };
+
+    m_syncedCallbacks.emplace_back(seqnum, half);
+    // already stored unless it's still waiting in the pending batch
+    if (m_pendingStoreSeqNums.empty() || m_pendingStoreSeqNums.back() < seqnum)
+        releaseSyncedCallbacks(seqnum);
+    return half;
 }
 
 void MemoryCache::cache(int seqnum, const std::string& wire)
 {
-    m_messages[seqnum] = wire;
-    m_pendingStoreSeqNums.push_back(seqnum);
+    // header offsets are recorded once here so a resend can patch the wire directly
+    WireOffsets offsets;
+    if (!scanWireOffsets(wire, *m_dictionary->getHeaderSpec(), offsets))
+        LOG_DEBUG("Unable to index header of cached message " << seqnum << ", resend will re-parse it");
+
+    const bool durable = m_store.getDurability() == Durability::EVERY;
+    uint64_t ticket = 0;
+    {
+        std::lock_guard lock(m_mutex);
+
+        // never let the window evict a message before it has been handed to the store
+        if (!m_pendingStoreSeqNums.empty() && m_ring.retainedAfter(seqnum, wire.size()) > m_pendingStoreSeqNums.front())
+            flushPendingMessages();
+
+        m_ring.append(seqnum, wire, offsets);
+
+        // with every-message durability the send waits for the store instead of batching
+        if (m_ring.lastSeqNum() == seqnum && !durable) {
+            m_pendingStoreSeqNums.push_back(seqnum);
+            return;
+        }
+
+        m_store.store(seqnum, wire);  // or larger than the whole window
+        ticket = m_store.syncTicket();
+    }
+
+    // outside the lock, so the reader's flushes and replays don't queue up behind the fsync
+    if (durable)
+        m_store.waitSynced(ticket);
 }
 
 void MemoryCache::getMessages(int begin, int end, MessageConsumer consumer) const
 {
-    // we store messages out of order for efficiency; collect entries and order them here for replay
-    std::vector<std::pair<int, const std::string*>> entries;
-    for (const auto& [seqnum, wire] : m_messages) {
-        if (seqnum >= begin && (end == 0 || seqnum <= end))
-            entries.emplace_back(seqnum, &wire);
-    }
-    std::sort(entries.begin(), entries.end(),
-        [](const auto& a, const auto& b) { return a.first < b.first; });
-    for (const auto& [seqnum, wire] : entries) {
-        consumer(seqnum, m_dictionary->parse(m_settings, *wire));
+    // anything older than the in-memory window comes from the store, read
+    // without the lock so sends don't queue up behind a long resend; if the
+    // window moves on meanwhile, what it dropped was stored and is read next
+    int next = begin;
+    WireOffsets offsets;
+    for (;;) {
+        int storeEnd = end;
+        {
+            std::lock_guard lock(m_mutex);
+            if (!m_ring.empty() && next >= m_ring.firstSeqNum()) {
+                m_ring.forEach(next, end, consumer);
+                return;
+            }
+            if (!m_ring.empty())
+                storeEnd = end == 0 ? m_ring.firstSeqNum() - 1 : std::min(end, m_ring.firstSeqNum() - 1);
+        }
+
+        bool stopped = false;
+        m_store.forEachMessage(next, storeEnd, [&](int seqnum, std::string_view wire) {
+            scanWireOffsets(wire, *m_dictionary->getHeaderSpec(), offsets);
+            stopped = !consumer(seqnum, wire, offsets);
+            return !stopped;
+        });
+        if (stopped || storeEnd == end)
+            return;
+        next = storeEnd + 1;
     }
 }
 
-std::map<int, Message>& MemoryCache::getInboundQueue()
+InboundQueue& MemoryCache::getInboundQueue()
 {
     return m_inboundQueue;
 }
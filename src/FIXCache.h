@@ -2,12 +2,15 @@
 
 #include <algorithm>
 #include <atomic>
-#include <map>
 #include <memory>
+#include <mutex>
 
 #include "Dictionary.h"
 #include "FIXStore.h"
+#include "InboundQueue.h"
 #include "Message.h"
+#include "MessageRing.h"
+#include "WirePatch.h"
 
 class IFIXCache
 {
@@ -16,7 +19,14 @@ public:
 
     virtual void cache(int seqnum, const std::string& wire) = 0;
 
-    using MessageConsumer = std::function<void(int, const Message&)>;
+    // Wraps the send callback of a cached message so it runs only once the
+    // wrapper has been called (after the network write) and the store write
+    // covering seqnum is durable.
+    virtual std::function<void()> syncedCallback(int seqnum, std::function<void()> fn) = 0;
+
+    // replays cached wire strings in seqnum order along with their header offsets;
+    // the consumer returns false to stop early
+    using MessageConsumer = std::function<bool(int, std::string_view, const WireOffsets&)>;
     virtual void getMessages(int begin, int end, MessageConsumer consumer) const = 0;
 
     virtual void setSenderSeqNum(int num) = 0;
@@ -28,7 +38,7 @@ public:
     virtual int nextSenderSeqNum() = 0;
     virtual int nextTargetSeqNum() = 0;
 
-    virtual std::map<int, Message>& getInboundQueue() = 0;
+    virtual InboundQueue& getInboundQueue() = 0;
 
     virtual void flushSeqNums() = 0;
 
@@ -43,6 +53,8 @@ public:
 
     void cache(int seqnum, const std::string& wire) override;
 
+    std::function<void()> syncedCallback(int seqnum, std::function<void()> fn) override;
+
     void getMessages(int begin, int end, MessageConsumer consumer) const override;
 
     void setSenderSeqNum(int num) override;
@@ -56,7 +68,7 @@ public:
 
     void flushSeqNums() override;
 
-    std::map<int, Message>& getInboundQueue() override;
+    InboundQueue& getInboundQueue() override;
 
     void load() override;
     void reset() override;
@@ -68,12 +80,25 @@ private:
     std::atomic<int> m_senderSeqNum;
     std::atomic<int> m_targetSeqNum;
 
-    HashMapT<int, std::string> m_messages;
+    void flushPendingMessages();
+    // hands callbacks for messages up to seqnum over to the store
+    void releaseSyncedCallbacks(int seqnum);
+
+    // Guards the ring, the store and what's waiting on it: messages are cached
+    // by whichever thread sends them while the reader flushes them to the store
+    // and replays them. Recursive, as a synced callback released to the store
+    // may run right away and send again.
+    mutable std::recursive_mutex m_mutex;
+
+    // recent outbound messages; anything older is read back from m_store
+    MessageRing m_ring;
 
     bool m_seqNumsDirty = false;
     std::vector<int> m_pendingStoreSeqNums;
+    // synced callbacks waiting for their message to reach the store, in seqnum order
+    std::vector<std::pair<int, std::function<void()>>> m_syncedCallbacks;
 
-    std::map<int, Message> m_inboundQueue;
+    InboundQueue m_inboundQueue;
 
     StoreHandle m_store;
 
@@ -1,5 +1,27 @@
 #include "FIXLogger.h"
 
+#include <strings.h>
+
+#include <algorithm>
+#include <cstdio>
+
+#include "Exception.h"
+
+namespace {
+
+// seconds past midnight of an HH:MM:SS time
+int64_t parseTimeOfDay(const std::string& time)
+{
+    int hours, minutes, seconds;
+    char extra;
+    if (std::sscanf(time.c_str(), "%d:%d:%d%c", &hours, &minutes, &seconds, &extra) != 3 || hours < 0 || hours > 23 || minutes < 0
+        || minutes > 59 || seconds < 0 || seconds > 59)
+        throw MisconfiguredSessionError("Invalid time of day: " + time);
+    return hours * 3600L + minutes * 60L + seconds;
+}
+
+}  // namespace
+
 FileLogger::~FileLogger()
 {
     stop();
@@ -7,7 +29,7 @@ FileLogger::~FileLogger()
 
 void FileLogger::start()
 {
-    m_writer.start();
+    m_writer.start(PlatformSettings::getBool(PlatformSettings::FILE_WRITER_IO_URING));
 }
 
 void FileLogger::stop()
@@ -23,9 +45,41 @@ LoggerHandle IFIXLogger::createHandle(LoggerFunction evtLogger, MsgLoggerFunctio
 LoggerHandle FileLogger::createLogger(const SessionSettings& settings)
 {
     const std::string sessionID = settings.getString(SessionSettings::SENDER_COMP_ID) + "-" + settings.getString(SessionSettings::TARGET_COMP_ID);
+    const std::string basePath = PlatformSettings::getString(PlatformSettings::LOG_PATH) + "/" + sessionID;
+
+    const std::string& format = PlatformSettings::getString(PlatformSettings::LOG_FORMAT);
+    const bool binary = strcasecmp(format.c_str(), "binary") == 0;
+    if (!binary && strcasecmp(format.c_str(), "text") != 0)
+        throw MisconfiguredSessionError("Unknown log format: " + format);
+
+    const std::string& compression = PlatformSettings::getString(PlatformSettings::LOG_COMPRESSION);
+    const bool compressed = strcasecmp(compression.c_str(), "zstd") == 0;
+    if (!compressed && strcasecmp(compression.c_str(), "none") != 0)
+        throw MisconfiguredSessionError("Unknown log compression: " + compression);
+
+    const std::string msgPath = basePath + (binary ? ".messages.bin" : ".messages.log") + (compressed ? ".zst" : "");
+
+    auto& evtLogger = *m_writer.createInstance(basePath + ".event.log");
+    auto& msgLogger = binary ? *m_writer.createInstance(msgPath, MessageFormat::BINARY, sessionID)
+                             : *m_writer.createInstance(msgPath, MessageFormat::TEXT);
+    const auto blockBytes = static_cast<size_t>(PlatformSettings::getLong(PlatformSettings::LOG_BLOCK_BYTES));
+    if (compressed)
+        msgLogger.setCompression(blockBytes);
+
+    RotationPolicy rotation;
+    rotation.m_maxBytes = static_cast<uint64_t>(std::max(0L, PlatformSettings::getLong(PlatformSettings::LOG_ROTATE_BYTES)));
+    if (PlatformSettings::getBool(PlatformSettings::LOG_ROTATE_DAILY))
+        rotation.m_dailyAt = parseTimeOfDay(settings.getString(SessionSettings::START_TIME));
+    rotation.m_retain = static_cast<size_t>(std::max(0L, PlatformSettings::getLong(PlatformSettings::LOG_RETAIN_FILES)));
+    const bool compressRotated = PlatformSettings::getBool(PlatformSettings::LOG_COMPRESS_ROTATED);
+    const auto preallocate = static_cast<uint64_t>(std::max(0L, PlatformSettings::getLong(PlatformSettings::LOG_PREALLOCATE_BYTES)));
 
-    auto& evtLogger = *m_writer.createInstance(PlatformSettings::getString(PlatformSettings::LOG_PATH) + "/" + sessionID + ".event.log");
-    auto& msgLogger = *m_writer.createInstance(PlatformSettings::getString(PlatformSettings::LOG_PATH) + "/" + sessionID + ".messages.log", true);
+    for (auto* logger : {&evtLogger, &msgLogger}) {
+        // a log compressed as it's written needs nothing more once rotated
+        rotation.m_compressBlockBytes = compressRotated && !(compressed && logger == &msgLogger) ? blockBytes : 0;
+        logger->setRotation(rotation);
+        logger->setPreallocation(preallocate);
+    }
 
     auto evtFunction = [&](const std::string& msg) { evtLogger.write(msg); };
     auto msgFunction = [&](int64_t epoch_us, bool inbound, std::string msg) {
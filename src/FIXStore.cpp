@@ -1,5 +1,9 @@
 #include "FIXStore.h"
 
+#include <fcntl.h>
+#include <strings.h>
+#include <unistd.h>
+
 #include <algorithm>
 #include <cstring>
 #include <filesystem>
@@ -7,13 +11,122 @@
 
 #include "Exception.h"
 
+// seqnum records are only read now, from stores written before the seqnum page;
+// journal records carry the session they belong to
 enum class WriteType : uint8_t
 {
     MSG,
     SENDER_SEQ_NUM,
-    TARGET_SEQ_NUM
+    TARGET_SEQ_NUM,
+    JOURNAL_MSG,
+    JOURNAL_RESET
 };
 
+namespace {
+
+// message record header: type(1) + seqnum(4) + length(8) = 13 bytes
+constexpr size_t MSG_HEADER_SIZE = 1 + sizeof(int) + sizeof(size_t);
+
+// journal record header: type(1) + seqnum(4) + length(8) + tag length(2) = 15
+// bytes, followed by the tag and then the body
+constexpr size_t JOURNAL_HEADER_SIZE = 1 + sizeof(int) + sizeof(size_t) + sizeof(uint16_t);
+
+// segment 0 is the single-file store written before segments existed
+constexpr uint32_t LEGACY_SEGMENT = 0;
+
+struct JournalRecord
+{
+    WriteType m_type;
+    int m_seqnum;
+    size_t m_length;
+    std::string_view m_tag;
+    uint64_t m_body;  // offset of the body
+};
+
+std::string segmentFile(const std::string& basePath, uint32_t segment)
+{
+    if (segment == LEGACY_SEGMENT)
+        return basePath + ".data";
+    return basePath + "." + std::to_string(segment) + ".data";
+}
+
+std::string journalFile(const std::string& dir, uint32_t shard)
+{
+    return dir + "/journal-" + std::to_string(shard);
+}
+
+// <base>.data is the legacy segment, <base>.<n>.data the numbered ones
+std::vector<uint32_t> listSegmentFiles(const std::string& basePath)
+{
+    std::vector<uint32_t> ret;
+
+    const std::filesystem::path base(basePath);
+    const std::string prefix = base.filename().string() + ".";
+    const auto dir = base.parent_path().empty() ? std::filesystem::path(".") : base.parent_path();
+
+    std::error_code ec;
+    for (const auto& file : std::filesystem::directory_iterator(dir, ec)) {
+        const std::string name = file.path().filename().string();
+
+        if (name == prefix + "data") {
+            ret.push_back(LEGACY_SEGMENT);
+            continue;
+        }
+        if (!name.starts_with(prefix) || !name.ends_with(".data") || name.size() <= prefix.size() + 5)
+            continue;
+
+        const std::string number = name.substr(prefix.size(), name.size() - prefix.size() - 5);
+        if (number.find_first_not_of("0123456789") != std::string::npos)
+            continue;
+        ret.push_back(static_cast<uint32_t>(std::stoul(number)));
+    }
+
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
+
+// false if the record at pos runs past the end of data
+bool readJournalRecord(std::string_view data, uint64_t pos, JournalRecord& record)
+{
+    if (pos + JOURNAL_HEADER_SIZE > data.size())
+        return false;
+
+    uint16_t tagLength;
+    record.m_type = static_cast<WriteType>(data[pos]);
+    std::memcpy(&record.m_seqnum, data.data() + pos + 1, sizeof(record.m_seqnum));
+    std::memcpy(&record.m_length, data.data() + pos + 1 + sizeof(record.m_seqnum), sizeof(record.m_length));
+    std::memcpy(&tagLength, data.data() + pos + 1 + sizeof(record.m_seqnum) + sizeof(record.m_length), sizeof(tagLength));
+
+    if (tagLength > data.size() - pos - JOURNAL_HEADER_SIZE)
+        return false;
+    record.m_tag = data.substr(pos + JOURNAL_HEADER_SIZE, tagLength);
+    record.m_body = pos + JOURNAL_HEADER_SIZE + tagLength;
+    return record.m_length <= data.size() - record.m_body;
+}
+
+Durability parseDurability(const std::string& value)
+{
+    if (strcasecmp(value.c_str(), "none") == 0)
+        return Durability::NONE;
+    else if (strcasecmp(value.c_str(), "periodic") == 0)
+        return Durability::PERIODIC;
+    else if (strcasecmp(value.c_str(), "group") == 0)
+        return Durability::GROUP;
+    else if (strcasecmp(value.c_str(), "every") == 0)
+        return Durability::EVERY;
+    else
+        throw MisconfiguredSessionError("Unknown store durability: " + value);
+}
+
+void writeRecordHeader(char* hdr, int seqnum, size_t len)
+{
+    hdr[0] = static_cast<char>(WriteType::MSG);
+    std::memcpy(hdr + 1, &seqnum, sizeof(seqnum));
+    std::memcpy(hdr + 1 + sizeof(seqnum), &len, sizeof(len));
+}
+
+}  // namespace
+
 FileStore::~FileStore()
 {
     stop();
@@ -21,111 +134,872 @@ FileStore::~FileStore()
 
 void FileStore::start()
 {
-    m_writer.start();
+    m_writer.start(PlatformSettings::getBool(PlatformSettings::FILE_WRITER_IO_URING));
 }
 
 void FileStore::stop()
 {
     m_writer.stop();
+
+    for (const auto& journal : m_journals) {
+        if (journal)
+            journal->close();
+    }
 }
 
 StoreHandle FileStore::createStore(const SessionSettings& settings)
 {
     const std::string sessionID = settings.getString(SessionSettings::SENDER_COMP_ID) + "-" + settings.getString(SessionSettings::TARGET_COMP_ID);
-    const std::string path = PlatformSettings::getString(PlatformSettings::DATA_PATH) + "/" + sessionID + ".data";
+    const std::string basePath = PlatformSettings::getString(PlatformSettings::DATA_PATH) + "/" + sessionID;
 
-    auto& writer = *m_writer.createInstance(path);
-    return createHandle(settings, writer, path);
+    auto& indexWriter = *m_writer.createInstance(basePath + ".index");
+
+    auto& seqNums = m_seqNumFiles[basePath];
+    const bool created = !seqNums;
+    if (created) {
+        seqNums = std::make_unique<SeqNumFile>(
+            basePath + ".seqnums", settings.getString(SessionSettings::SENDER_COMP_ID), settings.getString(SessionSettings::TARGET_COMP_ID));
+    }
+
+    if (PlatformSettings::getLong(PlatformSettings::STORE_JOURNAL_SHARDS) > 0) {
+        auto& journal = journalFor(sessionID, settings);
+        if (created)
+            journal.addSession(*seqNums, basePath + ".index");
+        return createHandle(settings, m_writer, journal.getWriter(), indexWriter, *seqNums, basePath, &journal);
+    }
+
+    // the data writer is pointed at the right segment once the store is opened
+    auto& writer = *m_writer.createInstance(basePath + ".data");
+
+    if (created) {
+        // the index can be rebuilt from the segments, so only they are synced
+        const auto durability = parseDurability(settings.getString(SessionSettings::STORE_DURABILITY));
+        if (durability != Durability::NONE) {
+            const auto interval = std::chrono::milliseconds(settings.getLong(SessionSettings::STORE_SYNC_INTERVAL));
+            writer.setDurability(durability, interval, [page = seqNums.get()] { page->sync(); });
+        }
+        if (settings.getBool(SessionSettings::STORE_PREALLOCATE))
+            writer.setPreallocation(static_cast<uint64_t>(settings.getLong(SessionSettings::STORE_SEGMENT_BYTES)));
+    }
+
+    return createHandle(settings, m_writer, writer, indexWriter, *seqNums, basePath);
 }
 
-void StoreHandle::store(int seqnum, const std::string& msg)
+StoreJournal& FileStore::journalFor(const std::string& sessionID, const SessionSettings& settings)
+{
+    const auto shards = static_cast<size_t>(PlatformSettings::getLong(PlatformSettings::STORE_JOURNAL_SHARDS));
+    if (m_journals.size() != shards)
+        m_journals.resize(shards);
+
+    // FNV-1a, so a session keeps its shard from one run to the next
+    uint32_t hash = 2166136261u;
+    for (const char c : sessionID) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    const auto shard = static_cast<uint32_t>(hash % shards);
+
+    const auto durability = parseDurability(settings.getString(SessionSettings::STORE_DURABILITY));
+
+    auto& journal = m_journals[shard];
+    if (!journal) {
+        const auto segmentBytes = static_cast<uint64_t>(PlatformSettings::getLong(PlatformSettings::STORE_JOURNAL_SEGMENT_BYTES));
+        journal = std::make_unique<StoreJournal>(
+            m_writer, journalFile(PlatformSettings::getString(PlatformSettings::DATA_PATH), shard), shard, segmentBytes);
+        journal->open();
+
+        // the first session on a shard decides how it's synced and whether it's preallocated
+        if (durability != Durability::NONE)
+            journal->setDurability(durability, std::chrono::milliseconds(settings.getLong(SessionSettings::STORE_SYNC_INTERVAL)));
+        if (settings.getBool(SessionSettings::STORE_PREALLOCATE))
+            journal->setPreallocation();
+    } else if (durability != journal->getWriter().getDurability()) {
+        LOG_WARN("Session " << sessionID << " asks for a different StoreDurability than journal " << journal->getBasePath()
+                            << " was opened with, keeping the journal's");
+    }
+
+    return *journal;
+}
+
+StoreJournal::StoreJournal(FileWriter& fileWriter, std::string basePath, uint32_t shard, uint64_t segmentBytes)
+    : m_fileWriter(fileWriter)
+    , m_basePath(std::move(basePath))
+    , m_shard(shard)
+    , m_segmentBytes(segmentBytes)
+{}
+
+std::string StoreJournal::segmentPath(uint32_t segment) const
+{
+    return segmentFile(m_basePath, segment);
+}
+
+void StoreJournal::open()
+{
+    auto segments = listSegmentFiles(m_basePath);
+    // an empty last segment was only preallocated, and the one before is still live
+    while (segments.size() > 1 && std::filesystem::is_empty(segmentPath(segments.back())))
+        segments.pop_back();
+    if (!segments.empty())
+        m_segment = std::max(1u, segments.back());
+
+    // appends continue after the last complete record
+    const std::string path = segmentPath(m_segment);
+    {
+        const MappedFile file(path);
+        const std::string_view data = file.view();
+
+        JournalRecord record;
+        uint64_t pos = 0;
+        while (pos < data.size() && readJournalRecord(data, pos, record))
+            pos = record.m_body + record.m_length;
+
+        if (pos < data.size()) {
+            LOG_WARN("Dropping incomplete record at the end of " << path << " (offset " << pos << ")");
+            if (::truncate(path.c_str(), static_cast<off_t>(pos)) != 0)
+                throw FileStoreLoadError("Unable to truncate incomplete record from " + path);
+        }
+        m_offset = pos;
+    }
+
+    // the marker only vouches for the journal exactly as close() left it
+    const std::string marker = m_basePath + ".clean";
+    bool clean = false;
+    {
+        std::ifstream in(marker);
+        uint32_t segment;
+        uint64_t offset;
+        if (in >> segment >> offset)
+            clean = segment == m_segment && offset == m_offset;
+    }
+    std::error_code ec;
+    std::filesystem::remove(marker, ec);
+
+    if (!clean && !segments.empty())
+        recover(segments);
+
+    LOG_INFO("Opened store journal " << path << " at offset " << m_offset);
+    m_writer = m_fileWriter.createInstance(path).get();
+}
+
+void StoreJournal::recover(const std::vector<uint32_t>& segments)
+{
+    using IndexEntry = StoreHandle::IndexEntry;
+
+    const uint32_t journal = m_shard + 1;
+    const auto dir = std::filesystem::path(m_basePath).parent_path();
+
+    struct Session
+    {
+        std::string m_indexPath;
+        // records up to here are indexed already
+        uint32_t m_segment = 0;
+        uint64_t m_end = 0;
+
+        std::vector<IndexEntry> m_entries;
+        bool m_reset = false;
+    };
+    HashMapT<std::string, Session> sessions;
+
+    const auto session = [&](std::string_view tag) -> Session& {
+        auto it = sessions.find(std::string(tag));
+        if (it != sessions.end())
+            return it->second;
+
+        Session ret;
+        ret.m_indexPath = (dir / (std::string(tag) + ".index")).string();
+        const MappedFile index(ret.m_indexPath);
+        const auto* entries = reinterpret_cast<const IndexEntry*>(index.data());
+        for (size_t i = index.size() / sizeof(IndexEntry); i > 0; --i) {
+            if (entries[i - 1].m_journal == journal) {
+                ret.m_segment = entries[i - 1].m_segment;
+                ret.m_end = entries[i - 1].m_offset + entries[i - 1].m_length;
+                break;
+            }
+        }
+        return sessions.emplace(std::string(tag), std::move(ret)).first->second;
+    };
+
+    LOG_INFO("Store journal " << m_basePath << " wasn't closed cleanly, checking session indexes against it");
+
+    for (const uint32_t segment : segments) {
+        if (segment == LEGACY_SEGMENT)
+            continue;
+
+        const MappedFile file(segmentPath(segment));
+        const std::string_view data = file.view();
+
+        JournalRecord record;
+        uint64_t pos = 0;
+        while (pos < data.size() && readJournalRecord(data, pos, record)) {
+            if (record.m_type != WriteType::JOURNAL_MSG && record.m_type != WriteType::JOURNAL_RESET)
+                throw FileStoreLoadError("Journal " + file.getPath() + " corrupted; unknown record type at offset " + std::to_string(pos));
+
+            auto& owner = session(record.m_tag);
+            if (segment > owner.m_segment || (segment == owner.m_segment && record.m_body >= owner.m_end)) {
+                if (record.m_type == WriteType::JOURNAL_MSG) {
+                    owner.m_entries.push_back({record.m_seqnum, segment, record.m_body, static_cast<uint32_t>(record.m_length), journal});
+                } else {
+                    owner.m_entries.clear();
+                    owner.m_reset = true;
+                }
+            }
+            pos = record.m_body + record.m_length;
+        }
+    }
+
+    for (const auto& [tag, owner] : sessions) {
+        if (owner.m_entries.empty() && !owner.m_reset)
+            continue;
+
+        // a reset leaves nothing from before it, the session's own segments included
+        std::ofstream out(owner.m_indexPath, std::ios::binary | (owner.m_reset ? std::ios::trunc : std::ios::app));
+        out.write(reinterpret_cast<const char*>(owner.m_entries.data()), static_cast<std::streamsize>(owner.m_entries.size() * sizeof(IndexEntry)));
+        out.flush();
+        if (!out)
+            throw FileStoreLoadError("Unable to write " + owner.m_indexPath);
+
+        LOG_INFO("Indexed " << owner.m_entries.size() << " messages for " << tag << " from " << m_basePath << (owner.m_reset ? " after a reset" : ""));
+    }
+}
+
+void StoreJournal::close()
+{
+    if (m_closed || !m_writer)
+        return;
+    m_closed = true;
+
+    // a durable journal's marker mustn't vouch for index entries still in the page cache
+    if (m_writer->getDurability() != Durability::NONE) {
+        std::lock_guard lock(m_sessionsMutex);
+        for (const auto& path : m_indexPaths) {
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd >= 0) {
+                ::fdatasync(fd);
+                ::close(fd);
+            }
+        }
+    }
+
+    std::ofstream out(m_basePath + ".clean", std::ios::trunc);
+    out << m_segment << ' ' << m_offset << '\n';
+}
+
+void StoreJournal::setDurability(Durability durability, std::chrono::milliseconds interval)
+{
+    m_writer->setDurability(durability, interval, [this] { syncPages(); });
+}
+
+void StoreJournal::setPreallocation()
+{
+    std::lock_guard lock(m_mutex);
+    m_preallocate = true;
+    m_writer->setPreallocation(m_segmentBytes);
+    m_writer->preallocate(segmentPath(m_segment + 1));
+}
+
+void StoreJournal::addSession(SeqNumFile& seqNums, std::string indexPath)
+{
+    std::lock_guard lock(m_sessionsMutex);
+    m_seqNums.push_back(&seqNums);
+    m_indexPaths.push_back(std::move(indexPath));
+}
+
+void StoreJournal::syncPages()
+{
+    std::lock_guard lock(m_sessionsMutex);
+    for (const auto* page : m_seqNums)
+        page->sync();
+}
+
+std::pair<uint32_t, uint64_t> StoreJournal::append(const std::string& tag, int seqnum, const std::string& msg)
+{
+    return appendRecord(static_cast<uint8_t>(WriteType::JOURNAL_MSG), tag, seqnum, msg);
+}
+
+void StoreJournal::appendReset(const std::string& tag)
+{
+    appendRecord(static_cast<uint8_t>(WriteType::JOURNAL_RESET), tag, 0, {});
+}
+
+std::pair<uint32_t, uint64_t> StoreJournal::appendRecord(uint8_t type, const std::string& tag, int seqnum, const std::string& msg)
 {
-    // header: type(1) + seqnum(4) + length(8) = 13 bytes
-    char hdr[1 + sizeof(seqnum) + sizeof(size_t)];
-    hdr[0] = static_cast<char>(WriteType::MSG);
-    std::memcpy(hdr + 1, &seqnum, sizeof(seqnum));
     const size_t len = msg.length();
-    std::memcpy(hdr + 1 + sizeof(seqnum), &len, sizeof(len));
-    m_writer.writeRaw(hdr, sizeof(hdr), msg);
+    const auto tagLength = static_cast<uint16_t>(tag.size());
+
+    std::string hdr(JOURNAL_HEADER_SIZE + tagLength, '\0');
+    hdr[0] = static_cast<char>(type);
+    std::memcpy(hdr.data() + 1, &seqnum, sizeof(seqnum));
+    std::memcpy(hdr.data() + 1 + sizeof(seqnum), &len, sizeof(len));
+    std::memcpy(hdr.data() + 1 + sizeof(seqnum) + sizeof(len), &tagLength, sizeof(tagLength));
+    std::memcpy(hdr.data() + JOURNAL_HEADER_SIZE, tag.data(), tagLength);
+
+    const uint64_t recordSize = hdr.size() + len;
+
+    std::lock_guard lock(m_mutex);
+    if (m_offset > 0 && m_offset + recordSize > m_segmentBytes) {
+        ++m_segment;
+        m_offset = 0;
+        m_writer->reopen(segmentPath(m_segment), true);
+        if (m_preallocate)
+            m_writer->preallocate(segmentPath(m_segment + 1));
+    }
+
+    m_writer->writeRaw(hdr.data(), hdr.size(), msg);
+    const std::pair<uint32_t, uint64_t> ret{m_segment, m_offset + hdr.size()};
+    m_offset += recordSize;
+    return ret;
 }
 
-void StoreHandle::setSenderSeqNum(int num)
+std::string StoreHandle::segmentPath(uint32_t segment) const
 {
-    char buf[1 + sizeof(num)];
-    buf[0] = static_cast<char>(WriteType::SENDER_SEQ_NUM);
-    std::memcpy(buf + 1, &num, sizeof(num));
-    m_writer.write(std::string(buf, sizeof(buf)));
+    return segmentFile(m_basePath, segment);
 }
 
-void StoreHandle::setTargetSeqNum(int num)
+std::string StoreHandle::entryPath(const IndexEntry& entry) const
 {
-    char buf[1 + sizeof(num)];
-    buf[0] = static_cast<char>(WriteType::TARGET_SEQ_NUM);
-    std::memcpy(buf + 1, &num, sizeof(num));
-    m_writer.write(std::string(buf, sizeof(buf)));
+    if (entry.m_journal == 0)
+        return segmentPath(entry.m_segment);
+
+    const auto dir = std::filesystem::path(m_basePath).parent_path();
+    return segmentFile(journalFile(dir.empty() ? "." : dir.string(), entry.m_journal - 1), entry.m_segment);
 }
 
-SessionData StoreHandle::load()
+std::string StoreHandle::indexPath() const
 {
-    SessionData ret;
+    return m_basePath + ".index";
+}
 
-    if (!std::filesystem::exists(m_path)) {
-        LOG_INFO("Store file doesn't exist, not loading session state.");
-        return ret;
+void StoreHandle::store(int seqnum, const std::string& msg)
+{
+    std::lock_guard lock(m_indexMutex);
+    open();
+    applyCompaction();
+
+    const size_t len = msg.length();
+    IndexEntry entry;
+    if (m_journal) {
+        const auto [segment, offset] = m_journal->append(m_journalTag, seqnum, msg);
+        entry = {seqnum, segment, offset, static_cast<uint32_t>(len), m_journal->getShard() + 1};
+    } else {
+        const uint64_t recordSize = MSG_HEADER_SIZE + len;
+        const uint64_t segmentLimit = static_cast<uint64_t>(m_settings.getLong(SessionSettings::STORE_SEGMENT_BYTES));
+        if (m_segmentOffset > 0 && m_segmentOffset + recordSize > segmentLimit)
+            rotate();
+
+        char hdr[MSG_HEADER_SIZE];
+        writeRecordHeader(hdr, seqnum, len);
+        m_writer.writeRaw(hdr, sizeof(hdr), msg);
+
+        entry = {seqnum, m_segment, m_segmentOffset + MSG_HEADER_SIZE, static_cast<uint32_t>(len), 0};
+        m_segmentOffset += recordSize;
     }
 
-    LOG_INFO("Loading session state from store file: " << m_path);
-    std::ifstream storeFile(m_path, std::ios::binary);
+    if (!m_index.empty() && seqnum <= m_index.back().m_seqnum)
+        m_indexSorted = false;
+    m_index.push_back(entry);
+    m_indexWriter.write(std::string_view(reinterpret_cast<const char*>(&entry), sizeof(entry)));
+}
+
+void StoreHandle::setSeqNums(int senderSeqNum, int targetSeqNum)
+{
+    m_seqNums.write(senderSeqNum, targetSeqNum);
+}
 
-    size_t cnt = 0;
-    while (true) {
-        WriteType type;
-        storeFile.read(reinterpret_cast<char*>(&type), sizeof(WriteType));
-        if (!storeFile)
-            break;
+uint64_t StoreHandle::scanSegment(uint32_t segment, uint64_t from)
+{
+    const MappedFile file(segmentPath(segment));
+    const std::string_view data = file.view();
+
+    uint64_t pos = from;
+    while (pos < data.size()) {
+        const auto type = static_cast<WriteType>(data[pos]);
 
         if (type == WriteType::SENDER_SEQ_NUM || type == WriteType::TARGET_SEQ_NUM) {
             int seqNum;
-            if (!storeFile.read(reinterpret_cast<char*>(&seqNum), sizeof(seqNum)))
-                throw FileStoreLoadError("Data file corrupted; unable to parse seqnum");
+            if (pos + 1 + sizeof(seqNum) > data.size())
+                break;
+            std::memcpy(&seqNum, data.data() + pos + 1, sizeof(seqNum));
 
             if (type == WriteType::SENDER_SEQ_NUM)
-                ret.m_senderSeqNum = seqNum;
-            if (type == WriteType::TARGET_SEQ_NUM)
-                ret.m_targetSeqNum = seqNum;
+                m_legacySenderSeqNum = seqNum;
+            else
+                m_legacyTargetSeqNum = seqNum;
+            pos += 1 + sizeof(seqNum);
         } else if (type == WriteType::MSG) {
-            // first read seqnum
             int seqNum;
-            if (!storeFile.read(reinterpret_cast<char*>(&seqNum), sizeof(seqNum)))
-                throw FileStoreLoadError("Data file corrupted; unable to parse message seqnum");
-
-            // now read msg length
             size_t length;
-            if (!storeFile.read(reinterpret_cast<char*>(&length), sizeof(length)))
-                throw FileStoreLoadError("Data file corrupted; unable to parse message length");
-
-            // read msg directly into a pre-sized string
-            std::string msg(length, '\0');
-            size_t read = 0;
-            while (read < length) {
-                const size_t toRead = length - read;
-                if (!storeFile.read(msg.data() + read, toRead))
-                    throw FileStoreLoadError("Data file corrupted; unable to read complete message");
-                read += toRead;
-            }
+            if (pos + MSG_HEADER_SIZE > data.size())
+                break;
+            std::memcpy(&seqNum, data.data() + pos + 1, sizeof(seqNum));
+            std::memcpy(&length, data.data() + pos + 1 + sizeof(seqNum), sizeof(length));
+            if (length > data.size() - pos - MSG_HEADER_SIZE)
+                break;
 
-            ret.m_messages[seqNum] = std::move(msg);
-            ++cnt;
+            m_index.push_back({seqNum, segment, pos + MSG_HEADER_SIZE, static_cast<uint32_t>(length), 0});
+            pos += MSG_HEADER_SIZE + length;
+        } else {
+            throw FileStoreLoadError("Data file " + file.getPath() + " corrupted; unknown record type at offset " + std::to_string(pos));
         }
     }
 
-    LOG_INFO("Loaded " << cnt << " messages from file store.");
+    if (pos < data.size())
+        LOG_WARN("Ignoring incomplete record at the end of " << file.getPath() << " (offset " << pos << ")");
+    return pos;
+}
+
+void StoreHandle::open()
+{
+    if (m_opened)
+        return;
+    m_opened = true;
+
+    // the index is a flat array of entries; copy it out in one go
+    const MappedFile index(indexPath());
+    const size_t indexed = index.size() / sizeof(IndexEntry);
+    m_index.resize(indexed);
+    if (indexed > 0)
+        std::memcpy(m_index.data(), index.data(), indexed * sizeof(IndexEntry));
+
+    bool rewrite = index.size() % sizeof(IndexEntry) != 0;
+
+    // drop entries pointing past the end of their segment (index written, data lost)
+    HashMapT<uint64_t, uint64_t> segmentSizes;
+    const auto segmentSize = [&](const IndexEntry& entry) {
+        const uint64_t key = static_cast<uint64_t>(entry.m_journal) << 32 | entry.m_segment;
+        auto it = segmentSizes.find(key);
+        if (it == segmentSizes.end()) {
+            std::error_code ec;
+            const auto size = std::filesystem::file_size(entryPath(entry), ec);
+            it = segmentSizes.emplace(key, ec ? 0 : size).first;
+        }
+        return it->second;
+    };
+    const auto invalid = [&](const IndexEntry& entry) { return entry.m_offset + entry.m_length > segmentSize(entry); };
+
+    // a crash can leave the last entries indexed ahead of their data: a torn tail
+    auto tail = m_index.end();
+    while (tail != m_index.begin() && invalid(*std::prev(tail)))
+        --tail;
+    if (tail != m_index.end()) {
+        LOG_WARN("Store index " << indexPath() << " references data that was never written, truncating it to " << (tail - m_index.begin())
+                                << " entries");
+        m_index.erase(tail, m_index.end());
+        rewrite = true;
+    }
+
+    // one bad entry further in mustn't take every later message with it
+    const auto bad = std::remove_if(m_index.begin(), m_index.end(), invalid);
+    if (bad != m_index.end()) {
+        LOG_WARN("Skipping " << (m_index.end() - bad) << " entries of store index " << indexPath() << " that reference data missing from their segment");
+        m_index.erase(bad, m_index.end());
+        rewrite = true;
+    }
+
+    // pick up records the index missed: the tail of the last indexed segment
+    // and any segment after it (or every segment, with no index at all)
+    const auto segments = listSegments();
+    const size_t recovered = m_index.size();
+    const auto lastOwn = std::find_if(m_index.rbegin(), m_index.rend(), [](const IndexEntry& entry) { return entry.m_journal == 0; });
+    const bool haveOwn = lastOwn != m_index.rend();
+    const uint32_t lastIndexed = haveOwn ? lastOwn->m_segment : LEGACY_SEGMENT;
+    const uint64_t lastIndexedEnd = haveOwn ? lastOwn->m_offset + lastOwn->m_length : 0;
+    uint64_t segmentEnd = 0;
+    m_segment = 1;
+    for (const uint32_t segment : segments) {
+        if (segment < lastIndexed)
+            continue;
+
+        uint64_t from = 0;
+        if (haveOwn && segment == lastIndexed)
+            from = lastIndexedEnd;
+
+        const uint64_t end = scanSegment(segment, from);
+        if (segment != LEGACY_SEGMENT) {
+            m_segment = segment;
+            segmentEnd = end;
+        }
+    }
+
+    // segments below the oldest one referenced were left behind by an interrupted compaction
+    uint32_t oldest = UINT32_MAX;
+    for (const auto& entry : m_index) {
+        if (entry.m_journal == 0)
+            oldest = std::min(oldest, entry.m_segment);
+    }
+    if (oldest != UINT32_MAX) {
+        for (const uint32_t segment : segments) {
+            if (segment >= oldest)
+                break;
+            LOG_INFO("Removing unreferenced store segment " << segmentPath(segment));
+            std::error_code ec;
+            std::filesystem::remove(segmentPath(segment), ec);
+        }
+    }
+
+    if (m_index.size() > recovered)
+        LOG_INFO("Indexed " << (m_index.size() - recovered) << " stored messages missing from " << indexPath());
+
+    // appends continue after the last complete record; the journal tracks its own end
+    if (!m_journal) {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(segmentPath(m_segment), ec);
+        if (!ec && segmentEnd < size) {
+            if (::truncate(segmentPath(m_segment).c_str(), static_cast<off_t>(segmentEnd)) != 0)
+                throw FileStoreLoadError("Unable to truncate incomplete record from " + segmentPath(m_segment));
+        }
+        m_segmentOffset = segmentEnd;
+        m_writer.reopen(segmentPath(m_segment), false);
+        preallocateNext();
+    }
+
+    if (rewrite) {
+        m_indexWriter.reopen(indexPath(), true);
+        m_indexWriter.write(std::string_view(reinterpret_cast<const char*>(m_index.data()), m_index.size() * sizeof(IndexEntry)));
+    } else if (m_index.size() > recovered) {
+        const auto* added = reinterpret_cast<const char*>(m_index.data() + recovered);
+        m_indexWriter.write(std::string_view(added, (m_index.size() - recovered) * sizeof(IndexEntry)));
+    }
+
+    m_indexSorted = std::adjacent_find(m_index.begin(), m_index.end(), [](const IndexEntry& a, const IndexEntry& b) {
+                        return a.m_seqnum >= b.m_seqnum;
+                    }) == m_index.end();
+}
+
+std::vector<uint32_t> StoreHandle::listSegments() const
+{
+    return listSegmentFiles(m_basePath);
+}
+
+SessionData StoreHandle::load()
+{
+    SessionData ret;
+
+    LOG_INFO("Loading session state from store: " << m_basePath);
+    std::lock_guard lock(m_indexMutex);
+    open();
+    LOG_INFO("Store index holds " << m_index.size() << " messages.");
+
+    const bool havePage = m_seqNums.read(ret.m_senderSeqNum, ret.m_targetSeqNum);
+    if (havePage) {
+        LOG_INFO("Loaded seqnums from " << m_seqNums.getPath() << " (incarnation " << m_seqNums.getIncarnation() << "): sender=" << ret.m_senderSeqNum
+                                        << ", target=" << ret.m_targetSeqNum);
+    } else if (m_legacySenderSeqNum || m_legacyTargetSeqNum) {
+        // store predates the seqnum page; carry its seqnums over
+        if (m_legacySenderSeqNum)
+            ret.m_senderSeqNum = m_legacySenderSeqNum;
+        if (m_legacyTargetSeqNum)
+            ret.m_targetSeqNum = m_legacyTargetSeqNum;
+        LOG_INFO("Migrating seqnums from store file to " << m_seqNums.getPath());
+        m_seqNums.write(ret.m_senderSeqNum, ret.m_targetSeqNum);
+    }
+
+    // a synced message can be newer than the last synced seqnum page; never
+    // hand out its seqnum again
+    if (m_writer.getDurability() != Durability::NONE && !m_index.empty()) {
+        sortIndex();
+        const int lastStored = m_index.back().m_seqnum;
+        if (lastStored >= ret.m_senderSeqNum) {
+            LOG_WARN("Store holds message " << lastStored << " past sender seqnum " << ret.m_senderSeqNum << ", continuing from " << (lastStored + 1));
+            ret.m_senderSeqNum = lastStored + 1;
+            m_seqNums.write(ret.m_senderSeqNum, ret.m_targetSeqNum);
+        }
+    }
 
     return ret;
 }
 
+void StoreHandle::sortIndex() const
+{
+    if (m_indexSorted)
+        return;
+
+    // later records win, so keep the last entry for each seqnum
+    std::stable_sort(m_index.begin(), m_index.end(), [](const IndexEntry& a, const IndexEntry& b) { return a.m_seqnum < b.m_seqnum; });
+    auto out = m_index.begin();
+    for (auto it = m_index.begin(); it != m_index.end(); ++it) {
+        if (std::next(it) != m_index.end() && std::next(it)->m_seqnum == it->m_seqnum)
+            continue;
+        *out++ = *it;
+    }
+    m_index.erase(out, m_index.end());
+    m_indexSorted = true;
+}
+
+std::shared_ptr<const MappedFile> StoreHandle::mapSegment(const IndexEntry& entry) const
+{
+    const uint64_t key = static_cast<uint64_t>(entry.m_journal) << 32 | entry.m_segment;
+    const uint64_t end = entry.m_offset + entry.m_length;
+
+    std::lock_guard lock(m_segmentsMutex);
+    auto& segment = m_segments[key];
+
+    // the segment may have grown since it was mapped
+    if (!segment || segment->size() < end)
+        segment = std::make_shared<const MappedFile>(entryPath(entry));
+    return segment->size() >= end ? segment : nullptr;
+}
+
+void StoreHandle::forEachMessage(int begin, int end, const MessageVisitor& fn) const
+{
+    // entries are copied out a batch at a time, so stores carry on while the
+    // messages are visited
+    constexpr size_t batchSize = 256;
+    std::vector<IndexEntry> batch;
+    batch.reserve(batchSize);
+
+    int next = begin;
+    for (;;) {
+        batch.clear();
+        {
+            std::lock_guard lock(m_indexMutex);
+            applyCompaction();
+            sortIndex();
+
+            auto it = std::lower_bound(m_index.begin(), m_index.end(), next, [](const IndexEntry& entry, int seqnum) { return entry.m_seqnum < seqnum; });
+            for (; it != m_index.end() && (end == 0 || it->m_seqnum <= end) && batch.size() < batchSize; ++it)
+                batch.push_back(*it);
+        }
+        if (batch.empty())
+            return;
+
+        for (const auto& entry : batch) {
+            auto segment = mapSegment(entry);
+            if (!segment) {
+                // indexed as soon as it's queued, so the write may still be on its way
+                WriterInstance& writer = entry.m_journal != 0 && m_journal ? m_journal->getWriter() : m_writer;
+                writer.waitWritten(writer.ticket());
+                segment = mapSegment(entry);
+            }
+            if (!segment)
+                throw FileStoreLoadError("Stored message " + std::to_string(entry.m_seqnum) + " is missing from " + entryPath(entry));
+
+            if (!fn(entry.m_seqnum, std::string_view(segment->data() + entry.m_offset, entry.m_length)))
+                return;
+        }
+        next = batch.back().m_seqnum + 1;
+    }
+}
+
 void StoreHandle::reset()
 {
-    LOG_INFO("Resetting session store, wiping data file...");
-    m_writer.reset();
+    LOG_INFO("Resetting session store, wiping data files...");
+    std::lock_guard lock(m_indexMutex);
+    open();
+
+    m_seqNums.reset();
+
+    if (m_compaction) {
+        m_compaction->m_cancelled.store(true, std::memory_order_release);
+        m_compaction.reset();
+    }
+
+    if (m_journal) {
+        // the journal is shared, so the session's records in it are dropped
+        // by a marker; segments from before the journal go outright
+        m_journal->appendReset(m_journalTag);
+        m_indexWriter.reset();
+        for (const uint32_t segment : listSegments())
+            m_indexWriter.remove(segmentPath(segment));
+    } else {
+        // start over in segment 1 and delete everything else, in order on the writer thread
+        m_writer.reset();
+        for (uint32_t segment = LEGACY_SEGMENT; segment <= m_segment + 1; ++segment) {
+            if (segment != 1)
+                m_writer.remove(segmentPath(segment));
+        }
+        m_writer.reopen(segmentPath(1), true);
+        m_indexWriter.reset();
+    }
+
+    m_index.clear();
+    m_indexSorted = true;
+    {
+        std::lock_guard segmentsLock(m_segmentsMutex);
+        m_segments.clear();
+    }
+    m_segment = 1;
+    m_segmentOffset = 0;
+    m_legacySenderSeqNum = 0;
+    m_legacyTargetSeqNum = 0;
+
+    if (!m_journal)
+        preallocateNext();
+}
+
+void StoreHandle::rotate()
+{
+    const long retain = m_settings.getLong(SessionSettings::STORE_RETAIN_MESSAGES);
+    const size_t threshold = static_cast<size_t>(std::max(1L, m_settings.getLong(SessionSettings::STORE_COMPACT_SEGMENTS)));
+
+    bool compact = false;
+    if (retain > 0 && !m_compaction) {
+        // the segment being sealed counts too
+        HashSetT<uint32_t> sealed;
+        for (const auto& entry : m_index) {
+            if (entry.m_journal == 0)
+                sealed.insert(entry.m_segment);
+        }
+        compact = sealed.size() >= threshold;
+    }
+
+    if (compact) {
+        // the compacted segment slots in below the next live one, keeping
+        // segment numbers in index order
+        startCompaction(m_segment + 1);
+        m_segment += 2;
+    } else {
+        ++m_segment;
+    }
+
+    m_segmentOffset = 0;
+    m_writer.reopen(segmentPath(m_segment), true);
+    preallocateNext();
+}
+
+void StoreHandle::preallocateNext()
+{
+    if (m_settings.getBool(SessionSettings::STORE_PREALLOCATE))
+        m_writer.preallocate(segmentPath(m_segment + 1));
+}
+
+void StoreHandle::startCompaction(uint32_t segment)
+{
+    sortIndex();
+
+    auto compaction = std::make_shared<Compaction>();
+    compaction->m_basePath = m_basePath;
+    compaction->m_segment = segment;
+    compaction->m_activeSegment = segment + 1;
+
+    const long retain = m_settings.getLong(SessionSettings::STORE_RETAIN_MESSAGES);
+    const int64_t cutoff = m_index.empty() ? 0 : static_cast<int64_t>(m_index.back().m_seqnum) - retain;
+
+    HashSetT<uint32_t> oldSegments;
+    uint64_t pos = 0;
+    for (const auto& entry : m_index) {
+        // the journal is shared, so what the session has there stays put
+        if (entry.m_journal != 0) {
+            compaction->m_entries.push_back(entry);
+            continue;
+        }
+
+        oldSegments.insert(entry.m_segment);
+        if (entry.m_seqnum <= cutoff)
+            continue;
+
+        compaction->m_sources.push_back(entry);
+        compaction->m_entries.push_back({entry.m_seqnum, segment, pos + MSG_HEADER_SIZE, entry.m_length, 0});
+        pos += MSG_HEADER_SIZE + entry.m_length;
+    }
+    compaction->m_oldSegments.assign(oldSegments.begin(), oldSegments.end());
+
+    LOG_INFO("Compacting " << oldSegments.size() << " store segments into " << segmentPath(segment) << ", keeping " << compaction->m_entries.size()
+                           << " of " << m_index.size() << " messages");
+
+    m_compaction = compaction;
+    m_fileWriter.post([compaction]() { compact(*compaction); });
+}
+
+void StoreHandle::compact(Compaction& compaction)
+{
+    const std::string segmentPath = segmentFile(compaction.m_basePath, compaction.m_segment);
+    const std::string indexPath = compaction.m_basePath + ".index";
+    const std::string segmentTmp = segmentPath + ".tmp";
+    const std::string indexTmp = indexPath + ".tmp";
+
+    try {
+        {
+            std::ofstream out(segmentTmp, std::ios::binary | std::ios::trunc);
+            HashMapT<uint32_t, MappedFile> sources;
+            char hdr[MSG_HEADER_SIZE];
+
+            for (const auto& source : compaction.m_sources) {
+                auto it = sources.find(source.m_segment);
+                if (it == sources.end())
+                    it = sources.emplace(source.m_segment, MappedFile(segmentFile(compaction.m_basePath, source.m_segment))).first;
+                if (source.m_offset + source.m_length > it->second.size())
+                    throw FileStoreLoadError("Message " + std::to_string(source.m_seqnum) + " is missing from " + it->second.getPath());
+
+                writeRecordHeader(hdr, source.m_seqnum, source.m_length);
+                out.write(hdr, sizeof(hdr));
+                out.write(it->second.data() + source.m_offset, source.m_length);
+            }
+
+            out.flush();
+            if (!out)
+                throw FileStoreLoadError("Unable to write " + segmentTmp);
+        }
+
+        // everything indexed since the compaction was planned is on disk by
+        // now; carry the entries for the live segment over
+        std::string index(reinterpret_cast<const char*>(compaction.m_entries.data()), compaction.m_entries.size() * sizeof(IndexEntry));
+        {
+            const MappedFile current(indexPath);
+            const auto* entries = reinterpret_cast<const IndexEntry*>(current.data());
+            for (size_t i = 0; i < current.size() / sizeof(IndexEntry); ++i) {
+                if (entries[i].m_journal == 0 && entries[i].m_segment >= compaction.m_activeSegment)
+                    index.append(reinterpret_cast<const char*>(&entries[i]), sizeof(IndexEntry));
+            }
+        }
+        {
+            std::ofstream out(indexTmp, std::ios::binary | std::ios::trunc);
+            out.write(index.data(), static_cast<std::streamsize>(index.size()));
+            out.flush();
+            if (!out)
+                throw FileStoreLoadError("Unable to write " + indexTmp);
+        }
+
+        if (compaction.m_cancelled.load(std::memory_order_acquire)) {
+            std::filesystem::remove(segmentTmp);
+            std::filesystem::remove(indexTmp);
+            return;
+        }
+
+        // segment first: until the index moves over, nothing refers to it
+        std::filesystem::rename(segmentTmp, segmentPath);
+        std::filesystem::rename(indexTmp, indexPath);
+        compaction.m_state.store(Compaction::DONE, std::memory_order_release);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Store compaction into " << segmentPath << " failed: " << e.what());
+        std::error_code ec;
+        std::filesystem::remove(segmentTmp, ec);
+        std::filesystem::remove(indexTmp, ec);
+        compaction.m_state.store(Compaction::FAILED, std::memory_order_release);
+    }
+}
+
+void StoreHandle::applyCompaction() const
+{
+    if (!m_compaction)
+        return;
+
+    const int state = m_compaction->m_state.load(std::memory_order_acquire);
+    if (state == Compaction::PENDING)
+        return;
+
+    const auto compaction = std::move(m_compaction);
+    if (state == Compaction::FAILED)
+        return;
+
+    std::vector<IndexEntry> index = compaction->m_entries;
+    for (const auto& entry : m_index) {
+        if (entry.m_journal == 0 && entry.m_segment >= compaction->m_activeSegment)
+            index.push_back(entry);
+    }
+    m_index.swap(index);
+    m_indexSorted = std::adjacent_find(m_index.begin(), m_index.end(), [](const IndexEntry& a, const IndexEntry& b) {
+                        return a.m_seqnum >= b.m_seqnum;
+                    }) == m_index.end();
+
+    // old segments go once nothing here can still be reading them; a reader
+    // holding one keeps its mapping, which outlives the file
+    {
+        std::lock_guard lock(m_segmentsMutex);
+        for (const uint32_t segment : compaction->m_oldSegments)
+            m_segments.erase(segment);
+    }
+    for (const uint32_t segment : compaction->m_oldSegments)
+        m_writer.remove(segmentPath(segment));
+
+    LOG_INFO("Store compaction into " << segmentPath(compaction->m_segment) << " complete");
 }
@@ -3,15 +3,19 @@
 #include <openfix/FileUtils.h>
 #include <openfix/Log.h>
 
+#include <atomic>
+#include <chrono>
 #include <functional>
-#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
 
 #include "Config.h"
+#include "SeqNumFile.h"
 
 struct SessionData
 {
-    std::map<int, std::string> m_messages;
-
     int m_senderSeqNum = 1;
     int m_targetSeqNum = 1;
 };
@@ -20,35 +24,239 @@ using WriteFunction = std::function<void(const std::string&)>;
 
 class IFIXStore;
 
+// With StoreJournalShards set, sessions share journal-<shard>.<n>.data files
+// instead of writing segments of their own: every message is appended to its
+// session's shard as a record tagged with the session ID, so the FileWriter
+// sees a few large sequential streams and one sync covers every session on a
+// shard. Sessions still keep their own index and seqnum page; after an unclean
+// shutdown the journal brings every session's index up to date when opened.
+class StoreJournal
+{
+public:
+    StoreJournal(FileWriter& fileWriter, std::string basePath, uint32_t shard, uint64_t segmentBytes);
+
+    // Finds the live segment and drops an incomplete record from its tail.
+    // Without the marker close() leaves, indexes the journal's records into
+    // their sessions' index files.
+    void open();
+    // Marks the journal as closed cleanly; the FileWriter must be stopped.
+    void close();
+
+    // Appends a record for the session tagged tag, returning the segment and
+    // offset its body lands at.
+    std::pair<uint32_t, uint64_t> append(const std::string& tag, int seqnum, const std::string& msg);
+    // everything appended for tag before this is dropped when the journal is rescanned
+    void appendReset(const std::string& tag);
+
+    // Syncs the journal per durability, along with the seqnum page of every
+    // session added to it.
+    void setDurability(Durability durability, std::chrono::milliseconds interval);
+    // reserves each segment's full size on disk ahead of writing it, a segment in advance
+    void setPreallocation();
+    void addSession(SeqNumFile& seqNums, std::string indexPath);
+
+    WriterInstance& getWriter() const
+    {
+        return *m_writer;
+    }
+
+    uint32_t getShard() const
+    {
+        return m_shard;
+    }
+
+    const std::string& getBasePath() const
+    {
+        return m_basePath;
+    }
+
+    std::string segmentPath(uint32_t segment) const;
+
+private:
+    std::pair<uint32_t, uint64_t> appendRecord(uint8_t type, const std::string& tag, int seqnum, const std::string& msg);
+    void recover(const std::vector<uint32_t>& segments);
+    void syncPages();
+
+    FileWriter& m_fileWriter;
+    WriterInstance* m_writer = nullptr;
+    std::string m_basePath;
+    uint32_t m_shard;
+    uint64_t m_segmentBytes;
+
+    // appends from every session on the shard are serialised so each one
+    // knows its offset
+    std::mutex m_mutex;
+    uint32_t m_segment = 1;
+    uint64_t m_offset = 0;
+    bool m_preallocate = false;
+
+    bool m_closed = false;
+
+    std::mutex m_sessionsMutex;
+    std::vector<SeqNumFile*> m_seqNums;
+    std::vector<std::string> m_indexPaths;
+
+    CREATE_LOGGER("StoreJournal");
+};
+
+// Messages are appended to numbered segment files (<Sender>-<Target>.<n>.data)
+// and located through <Sender>-<Target>.index, a flat array of fixed-size
+// entries mapping each seqnum to its segment and offset. Opening a store reads
+// the index rather than replaying the messages, and stored messages are read
+// back as slices of the mapped segments. With StoreRetainMessages set, sealed
+// segments are periodically compacted into one on the FileWriter thread.
+// StoreDurability decides how the FileWriter syncs the data segments (and the
+// seqnum page along with them). Given a StoreJournal, messages go to the shared
+// journal instead and index entries point into it; entries written before the
+// journal was enabled keep pointing at the session's own segments.
 class StoreHandle
 {
 public:
     void store(int seqnum, const std::string& msg);
-    void setSenderSeqNum(int num);
-    void setTargetSeqNum(int num);
+    // in-place update of the session's seqnum page, no file I/O
+    void setSeqNums(int senderSeqNum, int targetSeqNum);
 
     SessionData load();
     void reset();
 
+    // Visits stored messages in [begin, end] (end 0 = no limit) in seqnum order;
+    // fn returns false to stop. The views point into the mapped segments and are
+    // only valid for the duration of the call. A message stored but not yet
+    // written out is waited for; one that never arrives throws FileStoreLoadError.
+    using MessageVisitor = std::function<bool(int, std::string_view)>;
+    void forEachMessage(int begin, int end, const MessageVisitor& fn) const;
+
+    Durability getDurability() const
+    {
+        return m_writer.getDurability();
+    }
+
+    // A ticket covering every message stored so far, and a way to run fn once
+    // those messages are durable (or written out, with durability none).
+    uint64_t syncTicket()
+    {
+        return m_writer.ticket();
+    }
+    void onSynced(uint64_t ticket, std::function<void()> fn)
+    {
+        m_writer.onSynced(ticket, std::move(fn));
+    }
+    // Blocks until ticket is synced. store() never waits itself, so with
+    // every-message durability the caller waits here once it's dropped its locks.
+    void waitSynced(uint64_t ticket)
+    {
+        m_writer.waitSynced(ticket);
+    }
+
 private:
-    StoreHandle(const SessionSettings& settings, WriterInstance& writer, std::string path)
+    struct IndexEntry
+    {
+        int32_t m_seqnum;
+        uint32_t m_segment;
+        uint64_t m_offset;  // of the message body within the segment
+        uint32_t m_length;
+        uint32_t m_journal;  // 0 = the session's own segments, otherwise journal shard + 1
+    };
+    static_assert(sizeof(IndexEntry) == 24);
+
+    // A compaction copies the retained messages of every sealed segment into
+    // m_segment. It's built on the session thread, run on the writer thread and
+    // picked up again by the session thread once m_state leaves PENDING.
+    struct Compaction
+    {
+        enum State
+        {
+            PENDING,
+            DONE,
+            FAILED
+        };
+
+        std::string m_basePath;
+        uint32_t m_segment;
+        // own entries in this segment and above belong to the live segment and are kept as is
+        uint32_t m_activeSegment;
+        std::vector<uint32_t> m_oldSegments;
+
+        // where each retained message is now, and where it will be; entries
+        // in a journal aren't copied and go into m_entries unchanged
+        std::vector<IndexEntry> m_sources;
+        std::vector<IndexEntry> m_entries;
+
+        std::atomic<int> m_state{PENDING};
+        std::atomic<bool> m_cancelled{false};
+    };
+
+    StoreHandle(const SessionSettings& settings, FileWriter& fileWriter, WriterInstance& writer, WriterInstance& indexWriter, SeqNumFile& seqNums,
+                std::string basePath, StoreJournal* journal)
         : m_settings(settings)
+        , m_fileWriter(fileWriter)
         , m_writer(writer)
-        , m_path(std::move(path))
+        , m_indexWriter(indexWriter)
+        , m_seqNums(seqNums)
+        , m_basePath(std::move(basePath))
+        , m_journal(journal)
+        , m_journalTag(journal ? m_basePath.substr(m_basePath.find_last_of('/') + 1) : std::string())
     {}
 
-    void write(const std::string& msg)
-    {
-        m_writer.write(msg);
-    }
+    // open, scanSegment, sortIndex, rotate, startCompaction and applyCompaction
+    // run with m_indexMutex held
+    void open();
+    uint64_t scanSegment(uint32_t segment, uint64_t from);
+    std::vector<uint32_t> listSegments() const;
+    void sortIndex() const;
+    std::shared_ptr<const MappedFile> mapSegment(const IndexEntry& entry) const;
+
+    void rotate();
+    // with StorePreallocate, has the segment after the current one set up ahead of time
+    void preallocateNext();
+    void startCompaction(uint32_t segment);
+    void applyCompaction() const;
+    static void compact(Compaction& compaction);
+
+    std::string segmentPath(uint32_t segment) const;
+    std::string entryPath(const IndexEntry& entry) const;
+    std::string indexPath() const;
 
     const SessionSettings& m_settings;
+    FileWriter& m_fileWriter;
     WriterInstance& m_writer;
-    std::string m_path;
+    WriterInstance& m_indexWriter;
+    SeqNumFile& m_seqNums;
+    std::string m_basePath;
+    StoreJournal* m_journal;
+    std::string m_journalTag;  // <Sender>-<Target>
+
+    bool m_opened = false;
+
+    // Stores come from the session's send path while resends read on the
+    // reader thread. m_indexMutex covers the index and the compaction in
+    // flight, m_segmentsMutex the mappings; when both are held the index's
+    // is taken first. Neither is held while a visitor runs.
+    mutable std::mutex m_indexMutex;
+    mutable std::mutex m_segmentsMutex;
+
+    // sorted by seqnum (later entries winning) on demand before lookups
+    mutable std::vector<IndexEntry> m_index;
+    mutable bool m_indexSorted = true;
+
+    // keyed by journal << 32 | segment; a grown segment is mapped afresh
+    // rather than remapped, so readers can keep using the old mapping
+    mutable HashMapT<uint64_t, std::shared_ptr<const MappedFile>> m_segments;
+
+    // segment being appended to and the bytes queued to it so far
+    uint32_t m_segment = 1;
+    uint64_t m_segmentOffset = 0;
+
+    mutable std::shared_ptr<Compaction> m_compaction;
+
+    // seqnum records found in a pre-index store file
+    int m_legacySenderSeqNum = 0;
+    int m_legacyTargetSeqNum = 0;
 
     CREATE_LOGGER("StoreHandle");
 
     friend class IFIXStore;
+    friend class StoreJournal;
 };
 
 class IFIXStore
@@ -62,9 +270,10 @@ public:
     virtual StoreHandle createStore(const SessionSettings& settings) = 0;
 
 protected:
-    StoreHandle createHandle(const SessionSettings& settings, WriterInstance& writer, std::string path) const
+    StoreHandle createHandle(const SessionSettings& settings, FileWriter& fileWriter, WriterInstance& writer, WriterInstance& indexWriter,
+                             SeqNumFile& seqNums, std::string basePath, StoreJournal* journal = nullptr) const
     {
-        return {settings, writer, std::move(path)};
+        return {settings, fileWriter, writer, indexWriter, seqNums, std::move(basePath), journal};
     }
 };
 
@@ -80,7 +289,14 @@ public:
     StoreHandle createStore(const SessionSettings& settings) override;
 
 private:
+    StoreJournal& journalFor(const std::string& sessionID, const SessionSettings& settings);
+
     FileWriter m_writer;
 
+    HashMapT<std::string, std::unique_ptr<SeqNumFile>> m_seqNumFiles;
+
+    // one per shard, opened on first use
+    std::vector<std::unique_ptr<StoreJournal>> m_journals;
+
     CREATE_LOGGER("FileStore");
 };
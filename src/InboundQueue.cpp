@@ -0,0 +1,104 @@
+#include "InboundQueue.h"
+
+#include <algorithm>
+#include <bit>
+
+InboundQueue::InboundQueue(size_t capacity, size_t maxWindow)
+    : m_slots(std::bit_ceil(std::max<size_t>(capacity, 64)))
+    , m_bitmap(m_slots.size() / 64)
+    , m_mask(m_slots.size() - 1)
+    , m_maxWindow(std::bit_ceil(std::max(maxWindow, m_slots.size())))
+{}
+
+void InboundQueue::clear()
+{
+    std::fill(m_bitmap.begin(), m_bitmap.end(), 0);
+    m_base = 0;
+    m_count = 0;
+}
+
+void InboundQueue::advance(int seqnum)
+{
+    if (seqnum <= m_base)
+        return;
+
+    if (static_cast<size_t>(seqnum - m_base) >= m_slots.size()) {
+        // everything held is older
+        std::fill(m_bitmap.begin(), m_bitmap.end(), 0);
+        m_count = 0;
+    } else {
+        for (int s = m_base; s < seqnum && m_count > 0; ++s) {
+            if (test(s)) {
+                reset(s);
+                --m_count;
+            }
+        }
+    }
+    m_base = seqnum;
+}
+
+void InboundQueue::grow(size_t required)
+{
+    const size_t capacity = std::bit_ceil(required);
+
+    std::vector<std::string> slots(capacity);
+    std::vector<uint64_t> bitmap(capacity / 64);
+    const size_t mask = capacity - 1;
+
+    for (size_t off = 0; off < m_slots.size() && m_count > 0; ++off) {
+        const int seqnum = m_base + static_cast<int>(off);
+        if (!test(seqnum))
+            continue;
+        const size_t idx = static_cast<size_t>(seqnum) & mask;
+        slots[idx] = std::move(m_slots[static_cast<size_t>(seqnum) & m_mask]);
+        bitmap[idx >> 6] |= uint64_t(1) << (idx & 63);
+    }
+
+    m_slots = std::move(slots);
+    m_bitmap = std::move(bitmap);
+    m_mask = mask;
+}
+
+bool InboundQueue::push(int seqnum, std::string_view wire, int floor)
+{
+    if (m_count == 0)
+        m_base = floor;
+    else
+        advance(floor);
+
+    if (seqnum < m_base)
+        return false;
+
+    // too far ahead to hold; the counterparty will resend it
+    const size_t offset = static_cast<size_t>(seqnum - m_base);
+    if (offset >= m_maxWindow)
+        return false;
+    if (offset >= m_slots.size())
+        grow(offset + 1);
+
+    // assign() keeps the slot's existing buffer when it's large enough
+    m_slots[static_cast<size_t>(seqnum) & m_mask].assign(wire);
+    if (!test(seqnum)) {
+        set(seqnum);
+        ++m_count;
+    }
+    return true;
+}
+
+bool InboundQueue::pop(int seqnum, std::string& wire)
+{
+    if (m_count == 0)
+        return false;
+
+    advance(seqnum);
+    if (seqnum < m_base || !test(seqnum))
+        return false;
+
+    reset(seqnum);
+    --m_count;
+    m_base = seqnum + 1;
+
+    // hand the text over and keep the caller's old buffer for the next message
+    wire.swap(m_slots[static_cast<size_t>(seqnum) & m_mask]);
+    return true;
+}
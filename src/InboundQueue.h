@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Out-of-sequence inbound messages waiting for a gap to be filled. Slots are
+// a power-of-2 ring addressed by seqnum offset from the oldest seqnum still
+// wanted, with a bitmap of filled slots. Each slot keeps the raw wire text and
+// its string buffer is reused across gaps, so a long gap on a busy session
+// doesn't turn into one node allocation per message.
+//
+// The ring never grows past maxWindow slots: the seqnum comes from the
+// counterparty, and anything further ahead than that is left to the resend
+// request covering the gap rather than queued.
+class InboundQueue
+{
+public:
+    explicit InboundQueue(size_t capacity = 64, size_t maxWindow = 16384);
+
+    // floor is the next expected seqnum; anything below it is stale and dropped,
+    // as is anything maxWindow or more past it. Returns whether it was queued.
+    bool push(int seqnum, std::string_view wire, int floor);
+
+    // Takes the message for seqnum if queued, dropping anything older.
+    bool pop(int seqnum, std::string& wire);
+
+    void clear();
+
+    bool empty() const
+    {
+        return m_count == 0;
+    }
+
+    size_t size() const
+    {
+        return m_count;
+    }
+
+    size_t capacity() const
+    {
+        return m_slots.size();
+    }
+
+private:
+    bool test(int seqnum) const
+    {
+        const size_t idx = static_cast<size_t>(seqnum) & m_mask;
+        return (m_bitmap[idx >> 6] >> (idx & 63)) & 1;
+    }
+
+    void set(int seqnum)
+    {
+        const size_t idx = static_cast<size_t>(seqnum) & m_mask;
+        m_bitmap[idx >> 6] |= uint64_t(1) << (idx & 63);
+    }
+
+    void reset(int seqnum)
+    {
+        const size_t idx = static_cast<size_t>(seqnum) & m_mask;
+        m_bitmap[idx >> 6] &= ~(uint64_t(1) << (idx & 63));
+    }
+
+    void advance(int seqnum);
+    void grow(size_t required);
+
+    std::vector<std::string> m_slots;
+    std::vector<uint64_t> m_bitmap;
+    size_t m_mask;
+    size_t m_maxWindow;
+
+    // lowest seqnum the ring can hold
+    int m_base = 0;
+    size_t m_count = 0;
+};
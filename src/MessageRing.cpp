@@ -0,0 +1,140 @@
+#include "MessageRing.h"
+
+#include <bit>
+#include <cstring>
+#include <limits>
+
+MessageRing::MessageRing(size_t slots, size_t bytes)
+    : m_slots(std::bit_ceil(std::max<size_t>(slots, 1)))
+    , m_mask(m_slots.size() - 1)
+    , m_arena(new char[std::max<size_t>(bytes, 1)])
+    , m_arenaSize(std::max<size_t>(bytes, 1))
+{}
+
+void MessageRing::clear()
+{
+    for (auto& slot : m_slots)
+        slot.m_seqnum = -1;
+    m_head = m_tail = 0;
+    m_first = m_last = 0;
+    m_live = 0;
+}
+
+bool MessageRing::fits(size_t head, size_t tail, size_t live, size_t len, size_t& offset) const
+{
+    if (live == 0) {
+        offset = 0;
+        return len <= m_arenaSize;
+    }
+
+    if (head > tail) {
+        if (m_arenaSize - head >= len) {
+            offset = head;
+            return true;
+        }
+        // wrap, abandoning the end of the arena until the tail passes it
+        offset = 0;
+        return tail >= len;
+    }
+
+    // head < tail: free run between them; head == tail with live data means full
+    offset = head;
+    return tail - head >= len;
+}
+
+int MessageRing::nextLive(int seqnum) const
+{
+    // skip holes left by seqnum jumps
+    do {
+        ++seqnum;
+    } while (m_slots[seqnum & m_mask].m_seqnum != seqnum);
+    return seqnum;
+}
+
+void MessageRing::evictOldest()
+{
+    m_slots[m_first & m_mask].m_seqnum = -1;
+    if (--m_live == 0) {
+        m_head = m_tail = 0;
+        m_first = m_last = 0;
+        return;
+    }
+
+    m_first = nextLive(m_first);
+    m_tail = m_slots[m_first & m_mask].m_offset;
+}
+
+int MessageRing::retainedAfter(int seqnum, size_t len) const
+{
+    if (empty())
+        return seqnum;
+    if (seqnum <= m_last || len > m_arenaSize)
+        return std::numeric_limits<int>::max();
+
+    // same walk as append(), on copies of the cursors
+    int first = m_first;
+    size_t tail = m_tail;
+    size_t live = m_live;
+    size_t offset = 0;
+    while (live > 0) {
+        const bool slotFull = static_cast<size_t>(seqnum - first) >= m_slots.size();
+        if (!slotFull && fits(m_head, tail, live, len, offset))
+            return first;
+        if (--live == 0)
+            break;
+        first = nextLive(first);
+        tail = m_slots[first & m_mask].m_offset;
+    }
+    return seqnum;
+}
+
+void MessageRing::append(int seqnum, std::string_view wire, const WireOffsets& offsets)
+{
+    if (!empty() && seqnum <= m_last)
+        clear();
+
+    if (wire.size() > m_arenaSize || wire.size() > std::numeric_limits<uint32_t>::max()) {
+        // can never fit; older messages are still in the store
+        clear();
+        return;
+    }
+
+    size_t offset = 0;
+    while (!empty()) {
+        const bool slotFull = static_cast<size_t>(seqnum - m_first) >= m_slots.size();
+        if (!slotFull && fits(m_head, m_tail, m_live, wire.size(), offset))
+            break;
+        evictOldest();
+    }
+    if (empty())
+        offset = 0;
+
+    std::memcpy(m_arena.get() + offset, wire.data(), wire.size());
+
+    auto& slot = m_slots[seqnum & m_mask];
+    slot.m_seqnum = seqnum;
+    slot.m_offset = static_cast<uint32_t>(offset);
+    slot.m_length = static_cast<uint32_t>(wire.size());
+    slot.m_offsets = offsets;
+
+    if (m_live++ == 0) {
+        m_first = seqnum;
+        m_tail = offset;
+    }
+    m_last = seqnum;
+    m_head = offset + wire.size();
+}
+
+bool MessageRing::get(int seqnum, Entry& entry) const
+{
+    if (empty() || seqnum < m_first || seqnum > m_last)
+        return false;
+
+    const auto& slot = m_slots[seqnum & m_mask];
+    if (slot.m_seqnum != seqnum)
+        return false;
+
+    entry.m_wire = std::string_view(m_arena.get() + slot.m_offset, slot.m_length);
+    entry.m_offsets = &slot.m_offsets;
+    return true;
+}
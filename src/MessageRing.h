@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "WirePatch.h"
+
+// Seqnum-indexed window of outbound wire messages. Slots live in a power-of-2
+// ring addressed by seqnum & mask, and the message bytes are packed FIFO into
+// a single circular arena, so lookup is O(1), range iteration is naturally
+// ordered and memory is bounded by the window. Appending past either the slot
+// or byte capacity evicts the oldest messages.
+class MessageRing
+{
+public:
+    struct Entry
+    {
+        std::string_view m_wire;
+        const WireOffsets* m_offsets;
+    };
+
+    MessageRing(size_t slots, size_t bytes);
+
+    // Seqnums are expected to be appended in increasing order; going backwards
+    // (e.g. an admin seqnum change) drops the whole window.
+    void append(int seqnum, std::string_view wire, const WireOffsets& offsets);
+
+    // Oldest seqnum that would survive appending a message of len bytes at seqnum.
+    int retainedAfter(int seqnum, size_t len) const;
+
+    bool get(int seqnum, Entry& entry) const;
+
+    template <typename Fn>
+    void forEach(int begin, int end, Fn&& fn) const
+    {
+        if (empty())
+            return;
+        const int first = std::max(begin, m_first);
+        const int last = end == 0 ? m_last : std::min(end, m_last);
+        for (int seqnum = first; seqnum <= last; ++seqnum) {
+            const auto& slot = m_slots[seqnum & m_mask];
+            if (slot.m_seqnum != seqnum)
+                continue;
+            if (!fn(seqnum, std::string_view(m_arena.get() + slot.m_offset, slot.m_length), slot.m_offsets))
+                return;
+        }
+    }
+
+    void clear();
+
+    bool empty() const
+    {
+        return m_live == 0;
+    }
+
+    // oldest seqnum held in memory, 0 if empty
+    int firstSeqNum() const
+    {
+        return empty() ? 0 : m_first;
+    }
+
+    int lastSeqNum() const
+    {
+        return empty() ? 0 : m_last;
+    }
+
+    size_t size() const
+    {
+        return m_live;
+    }
+
+private:
+    struct Slot
+    {
+        int m_seqnum = -1;  // -1 = empty
+        uint32_t m_offset = 0;
+        uint32_t m_length = 0;
+        WireOffsets m_offsets;
+    };
+
+    void evictOldest();
+    int nextLive(int seqnum) const;
+    bool fits(size_t head, size_t tail, size_t live, size_t len, size_t& offset) const;
+
+    std::vector<Slot> m_slots;
+    size_t m_mask;
+
+    // lazily committed by the kernel, only touched pages cost memory
+    std::unique_ptr<char[]> m_arena;
+    size_t m_arenaSize;
+
+    // arena write position and start of the oldest live message
+    size_t m_head = 0;
+    size_t m_tail = 0;
+
+    int m_first = 0;
+    int m_last = 0;
+    size_t m_live = 0;
+};
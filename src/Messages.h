@@ -3,6 +3,7 @@
 #include <openfix/Types.h>
 
 #include <string>
+#include <string_view>
 
 namespace MESSAGE {
 inline std::string HEARTBEAT = "0";
@@ -15,4 +16,22 @@ inline std::string LOGON = "A";
 
 // no REJECT, this can be retransmitted in a resend
 inline static HashSetT<std::string> SESSION_MSGS = {HEARTBEAT, TEST_REQUEST, RESEND_REQUEST, SEQUENCE_RESET, LOGOUT, LOGON};
+
+// allocation-free equivalent of SESSION_MSGS.count() for wire views
+inline bool isSessionMessage(std::string_view msgType)
+{
+    if (msgType.size() != 1)
+        return false;
+    switch (msgType[0]) {
+        case '0':
+        case '1':
+        case '2':
+        case '4':
+        case '5':
+        case 'A':
+            return true;
+        default:
+            return false;
+    }
+}
 }  // namespace MESSAGE
@@ -17,7 +17,11 @@
 #include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <bit>
 #include <cerrno>
+#include <charconv>
+#include <cmath>
 #include <iostream>
 #include <sstream>
 
@@ -27,6 +31,8 @@
 
 #define EVENT_BUF_SIZE 256
 #define ACCEPTOR_BACKLOG 16
+#define RING_ENTRIES 1024
+#define RING_MAX_BUFFERS 32768
 
 const std::string BEGIN_STRING_TAG = std::to_string(FIELD::BeginString) + TAG_ASSIGNMENT_CHAR;
 
@@ -88,6 +94,29 @@ std::string get_ssl_error()
     return std::string(buf);
 }
 
+enum class ReaderPriority
+{
+    NORMAL,
+    CRITICAL,
+    BULK
+};
+
+ReaderPriority parse_reader_priority(const std::string& value)
+{
+    if (strcasecmp(value.c_str(), "normal") == 0)
+        return ReaderPriority::NORMAL;
+    else if (strcasecmp(value.c_str(), "critical") == 0)
+        return ReaderPriority::CRITICAL;
+    else if (strcasecmp(value.c_str(), "bulk") == 0)
+        return ReaderPriority::BULK;
+    else
+        throw MisconfiguredSessionError("Unknown reader priority: " + value);
+}
+
+const std::string DEFAULT_POOL = "default";
+const std::string BULK_POOL = "bulk";
+const std::string CRITICAL_POOL = "critical";
+
 void Network::start()
 {
     if (m_running.load(std::memory_order_acquire))
@@ -96,12 +125,222 @@ void Network::start()
 
     LOG_INFO("Starting...");
 
-    for (size_t i = 0; i < m_readerThreadCount; ++i)
-        m_readerThreads.push_back(std::make_unique<ReaderThread>(*this));
+    createPools();
+
+    const auto interval = std::chrono::milliseconds(PlatformSettings::getLong(PlatformSettings::READER_REBALANCE_INTERVAL_MS));
+    if (interval.count() > 0) {
+        m_rebalanceThread = std::thread([this, interval] {
+            CpuOrchestrator::bind(ThreadRole::UPDATE);
+            int64_t last = Utils::getEpochMicros();
+            std::unique_lock lock(m_rebalanceMutex);
+            while (!m_rebalanceCV.wait_for(lock, interval, [&] { return !m_running.load(std::memory_order_acquire); })) {
+                const int64_t now = Utils::getEpochMicros();
+                rebalance(now - last);
+                last = now;
+            }
+        });
+    }
 
     LOG_INFO("Started, now running.");
 }
 
+void Network::createPools()
+{
+    std::lock_guard lock(m_placementsMutex);
+
+    const auto addReader = [&](const std::string& name, const std::string& pool, bool busyPoll) {
+        m_readerThreads.push_back(std::make_unique<ReaderThread>(*this, name, pool, busyPoll));
+        return m_readerThreads.back().get();
+    };
+
+    auto& defaultPool = m_pools[DEFAULT_POOL];
+    for (size_t i = 0; i < m_readerThreadCount; ++i)
+        defaultPool.push_back(addReader(DEFAULT_POOL + "-" + std::to_string(i), DEFAULT_POOL, PlatformSettings::getBool(PlatformSettings::READER_BUSY_POLL)));
+
+    // name:threads[:busy], comma-separated
+    std::istringstream pools(PlatformSettings::getString(PlatformSettings::READER_POOLS));
+    std::string spec;
+    while (std::getline(pools, spec, ',')) {
+        std::vector<std::string> parts;
+        std::istringstream fields(spec);
+        std::string field;
+        while (std::getline(fields, field, ':'))
+            parts.push_back(field);
+
+        long threads = 0;
+        if (parts.size() >= 2)
+            std::from_chars(parts[1].data(), parts[1].data() + parts[1].size(), threads);
+        if (parts.size() < 2 || parts.size() > 3 || parts[0].empty() || threads <= 0 || (parts.size() == 3 && parts[2] != "busy")) {
+            LOG_WARN("Ignoring malformed reader pool: '" << spec << "'");
+            continue;
+        }
+        if (m_pools.find(parts[0]) != m_pools.end() || parts[0] == CRITICAL_POOL) {
+            LOG_WARN("Ignoring reader pool with a reserved or repeated name: " << parts[0]);
+            continue;
+        }
+
+        auto& pool = m_pools[parts[0]];
+        for (long i = 0; i < threads; ++i)
+            pool.push_back(addReader(parts[0] + "-" + std::to_string(i), parts[0], parts.size() == 3));
+    }
+
+    // critical sessions get their readers here, once and for all
+    for (const auto& settings : m_sessions) {
+        if (parse_reader_priority(settings.getString(SessionSettings::READER_PRIORITY)) == ReaderPriority::CRITICAL && settings.getString(SessionSettings::READER_THREAD).empty()) {
+            const auto& sessionID = settings.getSessionID();
+            m_placements[sessionID] = addReader(CRITICAL_POOL + "-" + sessionID, CRITICAL_POOL, PlatformSettings::getBool(PlatformSettings::READER_CRITICAL_BUSY_POLL));
+        }
+    }
+
+    for (const auto& settings : m_sessions) {
+        if (m_placements.find(settings.getSessionID()) == m_placements.end()) {
+            if (ReaderThread* reader = place(settings))
+                m_placements[settings.getSessionID()] = reader;
+        }
+    }
+
+    for (const auto& [sessionID, reader] : m_placements)
+        LOG_INFO("Placed session " << sessionID << " on reader " << reader->getName());
+}
+
+ReaderThread* Network::place(const SessionSettings& settings)
+{
+    const auto& threadName = settings.getString(SessionSettings::READER_THREAD);
+    if (!threadName.empty()) {
+        for (const auto& reader : m_readerThreads) {
+            if (reader->getName() == threadName)
+                return reader.get();
+        }
+        LOG_WARN("Unknown reader thread '" << threadName << "' for session " << settings.getSessionID() << ", placing it by pool");
+    }
+
+    const auto priority = parse_reader_priority(settings.getString(SessionSettings::READER_PRIORITY));
+    if (priority == ReaderPriority::CRITICAL && threadName.empty())
+        LOG_WARN("Critical session " << settings.getSessionID() << " registered while running, placing it by pool");
+
+    std::string poolName = settings.getString(SessionSettings::READER_POOL);
+    if (poolName.empty() && priority == ReaderPriority::BULK)
+        poolName = m_pools.find(BULK_POOL) != m_pools.end() ? BULK_POOL : DEFAULT_POOL;
+    if (poolName.empty())
+        return nullptr;
+
+    auto it = m_pools.find(poolName);
+    if (it == m_pools.end()) {
+        LOG_WARN("Unknown reader pool '" << poolName << "' for session " << settings.getSessionID() << ", using the default pool");
+        it = m_pools.find(DEFAULT_POOL);
+    }
+
+    // the reader with the fewest sessions placed on it so far
+    ReaderThread* leastLoaded = nullptr;
+    size_t fewest = SIZE_MAX;
+    for (ReaderThread* reader : it->second) {
+        const size_t placed = std::count_if(m_placements.begin(), m_placements.end(), [&](const auto& placement) { return placement.second == reader; });
+        if (placed < fewest) {
+            leastLoaded = reader;
+            fewest = placed;
+        }
+    }
+    return leastLoaded;
+}
+
+void Network::registerSession(const SessionSettings& settings)
+{
+    // a bad priority is a misconfigured session, caught as it's created
+    parse_reader_priority(settings.getString(SessionSettings::READER_PRIORITY));
+
+    std::lock_guard lock(m_placementsMutex);
+    m_sessions.push_back(settings);
+    if (m_running.load(std::memory_order_acquire)) {
+        if (ReaderThread* reader = place(settings)) {
+            m_placements[settings.getSessionID()] = reader;
+            LOG_INFO("Placed session " << settings.getSessionID() << " on reader " << reader->getName());
+        }
+    }
+}
+
+ReaderThread* Network::getPlacedReader(const SessionID_T& sessionID)
+{
+    std::lock_guard lock(m_placementsMutex);
+    const auto it = m_placements.find(sessionID);
+    return it == m_placements.end() ? nullptr : it->second;
+}
+
+std::string Network::getPlacement(const SessionID_T& sessionID)
+{
+    ReaderThread* reader = getPlacedReader(sessionID);
+    return reader ? reader->getName() : std::string();
+}
+
+void Network::rebalance(int64_t windowMicros)
+{
+    const double threshold = PlatformSettings::getDouble(PlatformSettings::READER_REBALANCE_THRESHOLD);
+
+    std::lock_guard lock(m_placementsMutex);
+
+    // every reader is sampled each window, so each sample covers just that window
+    HashMapT<ReaderThread*, ReaderLoad> loads;
+    for (const auto& reader : m_readerThreads)
+        loads[reader.get()] = reader->sampleLoad(windowMicros);
+
+    for (const auto& [poolName, readers] : m_pools) {
+        if (readers.size() < 2)
+            continue;
+
+        const ReaderLoad* busiest = nullptr;
+        const ReaderLoad* idlest = nullptr;
+        for (ReaderThread* reader : readers) {
+            const auto& load = loads[reader];
+            if (!busiest || load.m_load > busiest->m_load)
+                busiest = &load;
+            if (!idlest || load.m_load < idlest->m_load)
+                idlest = &load;
+        }
+
+        const double gap = busiest->m_load - idlest->m_load;
+        if (gap < threshold)
+            continue;
+
+        // Moving a connection with load l leaves a gap of |gap - 2l|: the one
+        // that narrows it most, if any does. One that's most of its reader's
+        // load on its own would only swap which reader is the busy one.
+        const ConnectionLoad* best = nullptr;
+        for (const auto& connection : busiest->m_connections) {
+            if (connection.m_pinned || connection.m_load <= 0 || connection.m_load >= gap)
+                continue;
+            if (!best || std::abs(gap - 2 * connection.m_load) < std::abs(gap - 2 * best->m_load))
+                best = &connection;
+        }
+        if (!best)
+            continue;
+
+        ReaderThread* from = busiest->m_reader;
+        ReaderThread* to = idlest->m_reader;
+        LOG_INFO("Rebalancing pool " << poolName << ": moving session " << best->m_sessionID << " (" << static_cast<int>(best->m_load * 100) << "% busy, "
+                                     << static_cast<long>(best->m_messageRate) << " msg/s) from " << from->getName() << " ("
+                                     << static_cast<int>(busiest->m_load * 100) << "%) to " << to->getName() << " (" << static_cast<int>(idlest->m_load * 100) << "%)");
+
+        // reconnects follow it
+        m_placements[best->m_sessionID] = to;
+        from->migrate(best->m_connection, *to);
+        m_rebalances.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::vector<ReaderStats> Network::getReaderStats()
+{
+    std::vector<ReaderStats> result;
+    if (!m_running.load(std::memory_order_acquire))
+        return result;
+
+    std::lock_guard lock(m_placementsMutex);
+    for (const auto& reader : m_readerThreads) {
+        auto stats = reader->getStats();
+        stats.m_placed = std::count_if(m_placements.begin(), m_placements.end(), [&](const auto& placement) { return placement.second == reader.get(); });
+        result.push_back(std::move(stats));
+    }
+    return result;
+}
+
 void Network::stop()
 {
     if (!m_running.load(std::memory_order_acquire))
@@ -110,24 +349,32 @@ void Network::stop()
 
     LOG_INFO("Stopping...");
 
+    // no more moves once the readers start shutting down
+    if (m_rebalanceThread.joinable()) {
+        {
+            std::lock_guard lock(m_rebalanceMutex);
+        }
+        m_rebalanceCV.notify_all();
+        m_rebalanceThread.join();
+    }
+
     for (auto& thread : m_readerThreads)
         thread->stop();
 
     for (auto& thread : m_readerThreads)
         thread->join();
 
-    m_readerThreads.clear();
+    // connections and their TLS state go with their reader threads
+    {
+        std::lock_guard lock(m_placementsMutex);
+        m_placements.clear();
+        m_pools.clear();
+        m_readerThreads.clear();
+    }
 
     {
-        std::lock_guard lock(m_tlsMutex);
-        for (auto& [_, conn] : m_tlsConnections) {
-            std::lock_guard connLock(conn->m_mutex);
-            if (conn->m_ssl)
-                SSL_free(conn->m_ssl);
-        }
-        m_tlsConnections.clear();
+        std::lock_guard lock(m_tlsContextsMutex);
         m_tlsContexts.clear();
-        m_hasTLSConnections.store(false, std::memory_order_release);
     }
 
     LOG_INFO("Stopped.");
@@ -211,24 +458,23 @@ bool Network::connect(const SessionSettings& settings, const std::shared_ptr<Net
     if (connected) {
         handler->setSocketSettings(fd);
 
+        std::shared_ptr<TLSConnection> tls;
         if (is_tls_enabled(settings)) {
             std::string tlsServerName = settings.getString(SessionSettings::TLS_SERVER_NAME);
             if (tlsServerName.empty())
                 tlsServerName = hostname;
-            if (!createTLSConnection(fd, settings, false, tlsServerName)) {
+            if (!(tls = createTLSConnection(fd, settings, false, tlsServerName))) {
                 close(fd);
                 return false;
             }
         }
 
-        auto& reader = *m_readerThreads[fd % m_readerThreadCount];
-        if (!reader.addConnection(handler, fd)) {
-            removeConnection(fd);
+        ReaderThread* placed = getPlacedReader(settings.getSessionID());
+        auto& reader = placed ? *placed : *m_readerThreads[fd % m_readerThreadCount];
+        if (!reader.addConnection(handler, fd, std::move(tls))) {
             close(fd);
             return false;
         }
-
-        reader.registerFD(fd);
         return true;
     }
 
@@ -293,10 +539,8 @@ bool Network::addAcceptor(const SessionSettings& settings, const std::shared_ptr
         // add to port->fd map
         m_acceptors[port] = fd;
 
-        // register listen socket with owning reader's epoll (EPOLLIN only, ET)
-        auto& reader = *m_readerThreads[fd % m_readerThreadCount];
-        reader.addAcceptor(handler, settings.getSessionID(), fd);
-        reader.registerFD(fd);
+        // registers the listen socket with the owning reader's epoll
+        m_readerThreads[fd % m_readerThreadCount]->addAcceptor(handler, settings.getSessionID(), fd);
 
         return true;
     }
@@ -334,21 +578,27 @@ bool Network::removeAcceptor(const SessionSettings& settings)
 
 bool Network::accept(int server_fd, const std::shared_ptr<Acceptor>& acceptor)
 {
-    struct sockaddr_in addr;
-    socklen_t addrlen = sizeof(addr);
-    const int fd = ::accept(server_fd, reinterpret_cast<struct sockaddr*>(&addr), &addrlen);
+    const int fd = ::accept(server_fd, nullptr, nullptr);
     if (fd < 0) {
         LOG_WARN("Failed to accept new socket: " << strerror(errno));
         return false;
     }
 
+    LOG_INFO("Accepted new connection fd=" << fd << " on server fd=" << server_fd);
+    return adopt(fd, acceptor);
+}
+
+bool Network::adopt(int fd, const std::shared_ptr<Acceptor>& acceptor)
+{
     if (!try_make_non_blocking(fd)) {
         ::close(fd);
         return false;
     }
 
+    struct sockaddr_in addr;
+    socklen_t addrlen = sizeof(addr);
     char ip[INET_ADDRSTRLEN + 1];
-    if (::inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip)) == NULL) {
+    if (::getpeername(fd, reinterpret_cast<struct sockaddr*>(&addr), &addrlen) != 0 || ::inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip)) == NULL) {
         LOG_WARN("Failed to parse incoming connection IP address: " << strerror(errno));
         ::close(fd);
         return false;
@@ -356,29 +606,28 @@ bool Network::accept(int server_fd, const std::shared_ptr<Acceptor>& acceptor)
 
     const std::string address = std::string(ip) + ":" + std::to_string(::ntohs(addr.sin_port));
 
+    std::shared_ptr<TLSConnection> tls;
     if (!acceptor->m_sessions.empty()) {
         const SessionSettings& settings = acceptor->m_sessions.begin()->second->getSettings();
-        if (is_tls_enabled(settings) && !createTLSConnection(fd, settings, true, "")) {
+        if (is_tls_enabled(settings) && !(tls = createTLSConnection(fd, settings, true, ""))) {
             ::close(fd);
             return false;
         }
     }
 
-    LOG_INFO("Accepted new connection from fd=" << fd << " on server fd=" << server_fd << ": " << address);
+    LOG_INFO("New connection on fd=" << fd << " from " << address);
 
-    // Register with the owning reader: unknown connection first, then epoll
-    auto& reader = *m_readerThreads[fd % m_readerThreads.size()];
-    reader.accept(fd, acceptor);
-    reader.registerFD(fd);
+    // the owning reader takes it as an unknown connection until its first message
+    m_readerThreads[fd % m_readerThreadCount]->accept(fd, acceptor, std::move(tls));
 
     return true;
 }
 
-bool Network::createTLSConnection(int fd, const SessionSettings& settings, bool serverMode, const std::string& serverName)
+std::shared_ptr<TLSConnection> Network::createTLSConnection(int fd, const SessionSettings& settings, bool serverMode, const std::string& serverName)
 {
     auto ctx = getTLSContext(settings, serverMode);
     if (!ctx)
-        return false;
+        return nullptr;
 
     std::shared_ptr<TLSConnection> conn = std::make_shared<TLSConnection>();
     conn->m_ctx = std::move(ctx);
@@ -386,14 +635,12 @@ bool Network::createTLSConnection(int fd, const SessionSettings& settings, bool
     conn->m_ssl = SSL_new(conn->m_ctx.get());
     if (!conn->m_ssl) {
         LOG_ERROR("Failed to create SSL object for fd=" << fd << ": " << get_ssl_error());
-        return false;
+        return nullptr;
     }
 
     if (SSL_set_fd(conn->m_ssl, fd) != 1) {
         LOG_ERROR("Failed to attach SSL object to fd=" << fd << ": " << get_ssl_error());
-        SSL_free(conn->m_ssl);
-        conn->m_ssl = nullptr;
-        return false;
+        return nullptr;
     }
 
     if (serverMode) {
@@ -408,9 +655,7 @@ bool Network::createTLSConnection(int fd, const SessionSettings& settings, bool
             X509_VERIFY_PARAM* verifyParams = SSL_get0_param(conn->m_ssl);
             if (!verifyParams) {
                 LOG_ERROR("Failed to acquire TLS verify params for fd=" << fd);
-                SSL_free(conn->m_ssl);
-                conn->m_ssl = nullptr;
-                return false;
+                return nullptr;
             }
 
             bool verifyTargetSet = false;
@@ -421,17 +666,12 @@ bool Network::createTLSConnection(int fd, const SessionSettings& settings, bool
 
             if (!verifyTargetSet) {
                 LOG_ERROR("Failed to set TLS hostname verification target for fd=" << fd);
-                SSL_free(conn->m_ssl);
-                conn->m_ssl = nullptr;
-                return false;
+                return nullptr;
             }
         }
     }
 
-    std::lock_guard lock(m_tlsMutex);
-    m_tlsConnections[fd] = std::move(conn);
-    m_hasTLSConnections.store(true, std::memory_order_release);
-    return true;
+    return conn;
 }
 
 std::string Network::getTLSContextKey(const SessionSettings& settings, bool serverMode) const
@@ -536,172 +776,26 @@ std::shared_ptr<SSL_CTX> Network::createTLSContext(const SessionSettings& settin
     return ctx;
 }
 
-bool Network::progressConnection(int fd)
-{
-    if (!m_hasTLSConnections.load(std::memory_order_acquire))
-        return true;
-
-    std::shared_ptr<TLSConnection> conn;
-    {
-        std::shared_lock lock(m_tlsMutex);
-        auto it = m_tlsConnections.find(fd);
-        if (it == m_tlsConnections.end())
-            return true;
-        conn = it->second;
-    }
-
-    std::lock_guard connLock(conn->m_mutex);
-    if (conn->m_ready.load(std::memory_order_acquire))
-        return true;
-
-    const int ret = conn->m_serverMode ? SSL_accept(conn->m_ssl) : SSL_connect(conn->m_ssl);
-    if (ret == 1) {
-        conn->m_ready.store(true, std::memory_order_release);
-        LOG_INFO("TLS handshake complete for fd=" << fd << ", version=" << SSL_get_version(conn->m_ssl) << ", cipher=" << SSL_get_cipher(conn->m_ssl));
-        return true;
-    }
-
-    const int sslErr = SSL_get_error(conn->m_ssl, ret);
-    if (sslErr == SSL_ERROR_WANT_READ || sslErr == SSL_ERROR_WANT_WRITE)
-        return true;
-
-    LOG_ERROR("TLS handshake failed on fd=" << fd << ": " << get_ssl_error());
-    return false;
-}
-
-bool Network::isConnectionReady(int fd) const
-{
-    if (!m_hasTLSConnections.load(std::memory_order_acquire))
-        return true;
-
-    std::shared_lock lock(m_tlsMutex);
-    auto it = m_tlsConnections.find(fd);
-    if (it == m_tlsConnections.end())
-        return true;
-    return it->second->m_ready.load(std::memory_order_acquire);
-}
-
-bool Network::requiresConnectionProgress(int fd) const
-{
-    if (!m_hasTLSConnections.load(std::memory_order_acquire))
-        return false;
-
-    std::shared_lock lock(m_tlsMutex);
-    auto it = m_tlsConnections.find(fd);
-    if (it == m_tlsConnections.end())
-        return false;
-    return !it->second->m_ready.load(std::memory_order_acquire);
-}
-
-bool Network::hasTLS(int fd) const
-{
-    if (!m_hasTLSConnections.load(std::memory_order_acquire))
-        return false;
-
-    std::shared_lock lock(m_tlsMutex);
-    return m_tlsConnections.find(fd) != m_tlsConnections.end();
-}
-
-ssize_t Network::readConnection(int fd, void* buf, size_t len)
-{
-    if (!m_hasTLSConnections.load(std::memory_order_acquire))
-        return ::recv(fd, buf, len, 0);
-
-    std::shared_ptr<TLSConnection> conn;
-    {
-        std::shared_lock lock(m_tlsMutex);
-        auto it = m_tlsConnections.find(fd);
-        if (it == m_tlsConnections.end())
-            return ::recv(fd, buf, len, 0);
-        conn = it->second;
-    }
-
-    if (!conn->m_ready.load(std::memory_order_acquire)) {
-        errno = EAGAIN;
-        return -1;
-    }
-
-    std::lock_guard connLock(conn->m_mutex);
-
-    const int ret = SSL_read(conn->m_ssl, buf, static_cast<int>(len));
-    if (ret > 0)
-        return ret;
-
-    const int sslErr = SSL_get_error(conn->m_ssl, ret);
-    if (sslErr == SSL_ERROR_WANT_READ || sslErr == SSL_ERROR_WANT_WRITE) {
-        errno = EAGAIN;
-        return -1;
-    }
-    if (sslErr == SSL_ERROR_ZERO_RETURN)
-        return 0;
-
-    LOG_ERROR("TLS read failed on fd=" << fd << ": " << get_ssl_error());
-    return 0;
-}
-
-ssize_t Network::writeConnection(int fd, const void* buf, size_t len)
-{
-    if (!m_hasTLSConnections.load(std::memory_order_acquire))
-        return ::send(fd, buf, len, MSG_NOSIGNAL);
-
-    std::shared_ptr<TLSConnection> conn;
-    {
-        std::shared_lock lock(m_tlsMutex);
-        auto it = m_tlsConnections.find(fd);
-        if (it == m_tlsConnections.end())
-            return ::send(fd, buf, len, MSG_NOSIGNAL);
-        conn = it->second;
-    }
-
-    if (!conn->m_ready.load(std::memory_order_acquire)) {
-        errno = EAGAIN;
-        return -1;
-    }
-
-    std::lock_guard connLock(conn->m_mutex);
-
-    const int ret = SSL_write(conn->m_ssl, buf, static_cast<int>(len));
-    if (ret > 0)
-        return ret;
-
-    const int sslErr = SSL_get_error(conn->m_ssl, ret);
-    if (sslErr == SSL_ERROR_WANT_READ || sslErr == SSL_ERROR_WANT_WRITE) {
-        errno = EAGAIN;
-        return -1;
-    }
-
-    LOG_ERROR("TLS write failed on fd=" << fd << ": " << get_ssl_error());
-    errno = ECONNRESET;
-    return -1;
-}
-
-void Network::removeConnection(int fd)
+TLSConnection::~TLSConnection()
 {
-    std::shared_ptr<TLSConnection> conn;
-    {
-        std::lock_guard lock(m_tlsMutex);
-        auto it = m_tlsConnections.find(fd);
-        if (it == m_tlsConnections.end())
-            return;
-        conn = it->second;
-        m_tlsConnections.erase(it);
-        if (m_tlsConnections.empty())
-            m_hasTLSConnections.store(false, std::memory_order_release);
-    }
-
-    std::lock_guard connLock(conn->m_mutex);
-    if (conn->m_ssl)
-        SSL_free(conn->m_ssl);
-    conn->m_ssl = nullptr;
+    if (m_ssl)
+        SSL_free(m_ssl);
 }
 
 ////////////////////////////////////////////
 //              ReaderThread              //
 ////////////////////////////////////////////
 
-ReaderThread::ReaderThread(Network& network)
-    : m_running(true)
-    , m_buffer(network)
+ReaderThread::ReaderThread(Network& network, std::string name, std::string pool, bool busyPoll)
+    : m_name(std::move(name))
+    , m_pool(std::move(pool))
+    , m_busyPoll(busyPoll)
+    , m_measureLoad(PlatformSettings::getLong(PlatformSettings::READER_REBALANCE_INTERVAL_MS) > 0)
+    , m_readBudgetBytes(std::max(0L, PlatformSettings::getLong(PlatformSettings::READ_BUDGET_BYTES)))
+    , m_readBudgetMessages(std::max(0L, PlatformSettings::getLong(PlatformSettings::READ_BUDGET_MESSAGES)))
+    , m_running(true)
+    , m_timers(Utils::getEpochMillis())
+    , m_startedMicros(Utils::getEpochMicros())
     , m_network(network)
 {
     m_epollFD = epoll_create1(0);
@@ -712,32 +806,58 @@ ReaderThread::ReaderThread(Network& network)
     if (m_eventFD == -1)
         throw std::runtime_error("ReaderThread: eventfd failed: " + std::string(strerror(errno)));
 
-    // Register eventfd with level-triggered (not ET) so we never miss a wakeup
+    // Register eventfd with level-triggered (not ET) so we never miss a wakeup;
+    // it's the one registration without an entry behind it
     struct epoll_event ev;
     ev.events = EPOLLIN;
-    ev.data.fd = m_eventFD;
+    ev.data.ptr = nullptr;
     if (epoll_ctl(m_epollFD, EPOLL_CTL_ADD, m_eventFD, &ev) < 0)
         throw std::runtime_error("ReaderThread: failed to register eventfd: " + std::string(strerror(errno)));
 
+    const std::string& backend = PlatformSettings::getString(PlatformSettings::READER_BACKEND);
+    if (backend == "io_uring") {
+        if (initRing()) {
+            m_backend = Backend::IO_URING;
+            LOG_INFO("Reading through io_uring");
+        } else {
+            LOG_WARN("io_uring reader backend unavailable, falling back to epoll");
+        }
+    } else if (backend != "epoll") {
+        LOG_WARN("Unknown ReaderBackend '" << backend << "', using epoll");
+    }
+
     m_thread = std::thread([&] {
-        CpuOrchestrator::bind(ThreadRole::READER);
+        CpuOrchestrator::bind(ThreadRole::READER, m_busyPoll);
         process();
     });
 }
 
 ReaderThread::~ReaderThread()
 {
+    // whatever stop() retired after the thread last got to it
+    reclaim();
+
+    // before the buffers it receives into go
+    m_ring.close();
+
     if (m_epollFD >= 0)
         ::close(m_epollFD);
     if (m_eventFD >= 0)
         ::close(m_eventFD);
 }
 
-void ReaderThread::registerFD(int fd)
+void ReaderThread::registerFD(int fd, const std::shared_ptr<PollEntry>& entry)
 {
+    // only the reader touches its ring
+    if (m_backend == Backend::IO_URING) {
+        m_arming.push(entry);
+        wake();
+        return;
+    }
+
     struct epoll_event event;
     event.events = EPOLLIN | EPOLLOUT | EPOLLHUP | EPOLLRDHUP | EPOLLERR | EPOLLET;
-    event.data.fd = fd;
+    event.data.ptr = entry.get();
 
     if (::epoll_ctl(m_epollFD, EPOLL_CTL_ADD, fd, &event) < 0) {
         LOG_WARN("Failed to register fd=" << fd << " with reader epoll: " << strerror(errno));
@@ -745,12 +865,30 @@ void ReaderThread::registerFD(int fd)
 }
 
 void ReaderThread::process()
+{
+    if (m_backend == Backend::IO_URING)
+        processRing();
+    else
+        processEpoll();
+
+    reclaim();
+}
+
+void ReaderThread::processEpoll()
 {
     struct epoll_event events[EVENT_BUF_SIZE];
-    const long timeout = PlatformSettings::getLong(PlatformSettings::EPOLL_TIMEOUT);
+    const long maxTimeout = PlatformSettings::getLong(PlatformSettings::EPOLL_TIMEOUT);
+    const bool busyPoll = m_busyPoll;
+    const int64_t busyPollIdleUs = PlatformSettings::getLong(PlatformSettings::READER_BUSY_POLL_IDLE_US);
+    int64_t lastEventUs = Utils::getEpochMicros();
 
     while (m_running.load(std::memory_order_acquire)) {
-        const int n = ::epoll_wait(m_epollFD, events, EVENT_BUF_SIZE, timeout);
+        // Busy polling never sleeps, saving the wakeup on every message; idle
+        // for long enough, the reader sleeps again until the next event.
+        const bool spinning = busyPoll && (busyPollIdleUs <= 0 || Utils::getEpochMicros() - lastEventUs < busyPollIdleUs);
+        // connections still with their budget's worth to read don't wait
+        const bool ready = !m_ready.empty();
+        const int n = ::epoll_wait(m_epollFD, events, EVENT_BUF_SIZE, spinning || ready ? 0 : nextTimeout(maxTimeout));
 
         if (n < 0) {
             if (errno == EINTR)
@@ -759,237 +897,410 @@ void ReaderThread::process()
             break;
         }
 
+        const int64_t busyFrom = n > 0 || ready ? Utils::getEpochMicros() : 0;
+        m_loadMark = busyFrom;
+        if (n > 0) {
+            if (busyPoll)
+                lastEventUs = busyFrom;
+        } else if (spinning && !ready) {
+            m_spins.fetch_add(1, std::memory_order_relaxed);
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+
+        processReady();
+
         for (int i = 0; i < n; ++i) {
-            const int fd = events[i].data.fd;
+            auto* entry = static_cast<PollEntry*>(events[i].data.ptr);
             const uint32_t mask = events[i].events;
 
             // Handle eventfd wakeup: flush pending writes
-            if (fd == m_eventFD) {
+            if (!entry) {
+                // cleared before the dirty list is drained, so anything
+                // scheduled from here on wakes us again
+                m_wakeupPending.exchange(false, std::memory_order_acq_rel);
                 uint64_t val;
                 ::read(m_eventFD, &val, sizeof(val));
                 flushWrites();
                 continue;
             }
 
-            // Handle errors
-            if (mask & EPOLLERR) {
-                int err = 0;
-                socklen_t len = sizeof(err);
-                if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0) {
-                    LOG_ERROR("EPOLLERR on fd=" << fd << ", error: " << strerror(err));
-                } else {
-                    LOG_ERROR("EPOLLERR on fd=" << fd << ", and getsockopt failed to get error.");
-                }
-            }
-
-            // Handle disconnect
-            if (mask & (EPOLLHUP | EPOLLRDHUP)) {
-                LOG_INFO("disconnect callback for fd=" << fd);
-                disconnect(fd);
+            if (entry->m_type == PollEntry::Type::ACCEPTOR) {
+                if (mask & EPOLLIN)
+                    processAccept(static_cast<Acceptor&>(*entry));
                 continue;
             }
 
-            // Progress TLS handshake if needed
-            if (m_network.requiresConnectionProgress(fd)) {
-                if (!m_network.progressConnection(fd)) {
-                    disconnect(fd);
-                    continue;
-                }
-                if (m_network.requiresConnectionProgress(fd))
-                    continue;  // still in progress, wait for more events
-            }
+            auto& connection = static_cast<ConnectionHandle&>(*entry);
+            processEvents(connection, mask);
+            chargeLoad(connection);
+        }
 
-            // Handle readable data
-            if (mask & EPOLLIN) {
-                try {
-                    processRead(fd);
-                } catch (const SocketClosedError& e) {
-                    LOG_ERROR("Socket is closed, fd=" << fd);
-                }
-            }
+        // nothing from this batch is in hand any more
+        reclaim();
 
-            // Handle writable: flush pending write buffers
-            if (mask & EPOLLOUT) {
-                std::lock_guard lock(m_writeMutex);
-                auto it = m_writeBuffers.find(fd);
-                if (it != m_writeBuffers.end())
-                    flushWrite(fd, it->second);
-            }
-        }
+        updateSessions();
+        processMigrations();
 
-        // Tick all connected sessions (time-gated internally).
-        // Snapshot under the lock: update() can re-enter network code and
-        // mutate m_connections, which would invalidate the iterator.
-        std::vector<std::shared_ptr<NetworkHandler>> handlers;
-        {
-            std::lock_guard lock(m_mutex);
-            handlers.reserve(m_connections.size());
-            for (const auto& [_, handler] : m_connections)
-                handlers.push_back(handler);
-        }
-        for (const auto& handler : handlers)
-            handler->update();
+        if (busyFrom)
+            m_busyMicros.fetch_add(Utils::getEpochMicros() - busyFrom, std::memory_order_relaxed);
     }
-
-    // Reader thread is exiting — safe to clear buffers with no concurrent access
-    m_buffer.clear();
 }
 
-void ReaderThread::processRead(int fd)
+void ReaderThread::processEvents(ConnectionHandle& connection, uint32_t mask)
 {
-    // Fast path: look up the handler and read data under the lock, then release
-    // before message processing. The lock must cover m_buffer.read(fd) because
-    // external disconnect() can erase from m_bufferMap under m_mutex — without
-    // the lock, read()'s reference into the map would dangle.
-    //
-    // Raw pointer is safe here: the Session holds a shared_ptr to the NetworkHandler,
-    // so it stays alive for the duration of message processing on the reader thread.
-    NetworkHandler* handler = nullptr;
-    std::vector<std::string>* msgs = nullptr;
-    {
-        std::lock_guard lock(m_mutex);
-
-        const auto it = m_connections.find(fd);
-        if (it != m_connections.end()) {
-            handler = it->second.get();
-            msgs = &m_buffer.read(fd);
+    const int fd = connection.getFD();
+
+    // Handle errors
+    if (mask & EPOLLERR) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0) {
+            LOG_ERROR("EPOLLERR on fd=" << fd << ", error: " << strerror(err));
+        } else {
+            LOG_ERROR("EPOLLERR on fd=" << fd << ", and getsockopt failed to get error.");
         }
     }
 
-    // Known connection: process outside the lock (msgs points to m_readResult,
-    // which is stable until the next read() call — only happens on this thread)
-    if (handler) {
-        LOG_TRACE("Handling data for known connection on fd=" << fd);
-
-        for (auto& msg : *msgs)
-            handler->processMessage(std::move(msg));
-
+    // Handle disconnect
+    if (mask & (EPOLLHUP | EPOLLRDHUP)) {
+        LOG_INFO("disconnect callback for fd=" << fd);
+        disconnect(connection);
         return;
     }
 
-    // Cold paths (connection setup): re-acquire lock for map mutations
-    std::lock_guard lock(m_mutex);
-
-    // acceptor socket
-    {
-        auto it = m_acceptorSockets.find(fd);
-        if (it != m_acceptorSockets.end()) {
-            LOG_TRACE("Attempting to accept connection on accept socket fd=" << fd);
-            m_network.accept(fd, it->second);
+    // Progress TLS handshake if needed
+    if (connection.requiresProgress()) {
+        if (!connection.progress()) {
+            disconnect(connection);
             return;
         }
+        if (connection.requiresProgress())
+            return;  // still in progress, wait for more events
     }
 
-    // unknown acceptor connections
-    {
-        auto it = m_unknownConnections.find(fd);
-        if (it != m_unknownConnections.end()) {
-            LOG_TRACE("Handling data for unknown connection on fd=" << fd);
-            const auto acceptor = it->second;
-
-            auto& msgs = m_buffer.read(fd);
-            if (!msgs.empty()) {
-                // this connection is either invalid or will be known
-                m_unknownConnections.erase(fd);
-                const auto& msg = msgs[0];
-
-                const auto sender_comp = Utils::getTagValue(msg, SENDER_COMP_ID_PATTERN, SENDER_COMP_ID_PATTERN.size(), 0);
-                if (sender_comp.first.empty()) {
-                    LOG_ERROR("Received message without SenderCompID");
-                    ::close(fd);
-                    return;
-                }
-
-                const auto target_comp = Utils::getTagValue(msg, TARGET_COMP_ID_PATTERN, TARGET_COMP_ID_PATTERN.size(), sender_comp.second);
-                if (target_comp.first.empty()) {
-                    LOG_ERROR("Received message without TargetCompID");
-                    ::close(fd);
-                    return;
-                }
-
-                // flip as this is from their perspective
-                const auto cpty = target_comp.first + ':' + sender_comp.first;
-                const auto consumerIt = acceptor->m_sessions.find(cpty);
-                if (consumerIt == acceptor->m_sessions.end()) {
-                    LOG_ERROR("Received connection from unknown counterparty: " << cpty);
-                    ::close(fd);
-                    return;
-                }
-
-                // make sure this session isn't already connected
-                if (consumerIt->second->isConnected()) {
-                    LOG_ERROR("Received connection from already-connected session: " << cpty);
-                    ::close(fd);
-                    return;
-                }
-
-                // set socket settings
-                consumerIt->second->setSocketSettings(fd);
-
-                // create new connection
-                LOG_DEBUG("Associating fd=" << fd << " with session: " << cpty);
-                addConnection(consumerIt->second, fd);
-
-                for (auto& msg : msgs)
-                    consumerIt->second->processMessage(std::move(msg));
-            }
-
-            return;
+    // Handle readable data, unless the connection is waiting its next turn
+    if ((mask & EPOLLIN) && !connection.m_readReady) {
+        try {
+            processRead(connection);
+        } catch (const SocketClosedError& e) {
+            LOG_ERROR("Socket is closed, fd=" << fd);
         }
     }
 
-    LOG_WARN("Received I/O event for unknown fd: " << fd);
+    // Handle writable: flush pending write buffers
+    if (mask & EPOLLOUT) {
+        connection.flush(m_completedCallbacks);
+        runCompletedCallbacks();
+        // a replay waiting on the socket to drain can send its next chunk
+        markForUpdate(connection);
+    }
 }
 
-void ReaderThread::accept(int fd, const std::shared_ptr<Acceptor>& acceptor)
+int ReaderThread::nextTimeout(long maxTimeout) const
 {
-    std::lock_guard lock(m_mutex);
-    m_unknownConnections[fd] = acceptor;
+    const int64_t next = m_timers.nextDeadline();
+    if (next == TimerWheel<int>::NONE)
+        return static_cast<int>(maxTimeout);
+
+    // EpollTimeout still bounds the wait, for updates requested without a wakeup
+    int64_t wait = std::max<int64_t>(0, next - Utils::getEpochMillis());
+    if (maxTimeout >= 0)
+        wait = std::min<int64_t>(wait, maxTimeout);
+    return static_cast<int>(wait);
 }
 
-void ReaderThread::stop()
+void ReaderThread::markForUpdate(ConnectionHandle& connection)
 {
-    m_running.store(false, std::memory_order_release);
+    if (connection.m_updateDue || !connection.getHandler())
+        return;
+    connection.m_updateDue = true;
+    m_updateDue.push_back(connection.shared_from_this());
+}
 
-    // Wake the reader from epoll_wait via eventfd
-    uint64_t val = 1;
-    ::write(m_eventFD, &val, sizeof(val));
+void ReaderThread::requestUpdate(std::shared_ptr<ConnectionHandle> handle)
+{
+    m_updateRequests.push(std::move(handle));
+}
 
-    // close open connections
+void ReaderThread::updateSessions()
+{
+    std::shared_ptr<ConnectionHandle> handle;
+    uint64_t position;
+    while (m_updateRequests.pop(handle, position)) {
+        // cleared first, so a send from here on asks again
+        handle->m_updateRequested.store(false, std::memory_order_release);
+        // asked of us just as the connection moved on: passed along to its reader
+        if (!owns(*handle))
+            handle->requestUpdate();
+        else
+            markForUpdate(*handle);
+    }
+    handle.reset();
+
+    const long now = Utils::getEpochMillis();
+    m_timers.advance(now, [&](std::shared_ptr<PollEntry> entry) {
+        if (entry->m_type == PollEntry::Type::ACCEPTOR) {
+            std::lock_guard lock(m_mutex);
+            auto& acceptor = static_cast<Acceptor&>(*entry);
+            if (!acceptor.m_closed)
+                armAccept(acceptor, entry);
+            return;
+        }
+
+        // a connection handed on keeps its deadlines on its new reader's wheel,
+        // and one since superseded by an earlier deadline has nothing left to do
+        auto& connection = static_cast<ConnectionHandle&>(*entry);
+        if (!owns(connection) || connection.m_nextUpdate > now)
+            return;
+        connection.m_nextUpdate = TimerWheel<int>::NONE;
+        markForUpdate(connection);
+    });
+
+    // update() can send, disconnect and re-enter network code, but never
+    // marks anything itself; whatever it requests waits for the next batch
+    m_updating.swap(m_updateDue);
+    if (m_measureLoad && !m_updating.empty())
+        m_loadMark = Utils::getEpochMicros();
+    for (const auto& connection : m_updating) {
+        connection->m_updateDue = false;
+
+        // disconnected sessions are the update thread's to reconnect
+        NetworkHandler* handler = connection->getHandler();
+        if (!handler || !handler->isConnected())
+            continue;
+
+        const long next = handler->shared_from_this()->update();
+        chargeLoad(*connection);
+        // a later deadline leaves the earlier entry to fire and find it early
+        if (next > 0 && next < connection->m_nextUpdate) {
+            connection->m_nextUpdate = next;
+            m_timers.schedule(next, connection);
+        }
+    }
+    m_updating.clear();
+}
+
+void ReaderThread::processRead(ConnectionHandle& connection)
+{
+    // No lock needed: the connection's read buffer is only touched here, and
+    // it outlives this event even if another thread disconnects it meanwhile;
+    // its fd stays open (if shut down) until we reclaim it.
+    //
+    // Raw pointer is safe here: the Session holds a shared_ptr to the NetworkHandler,
+    // so it stays alive for the duration of message processing on the reader thread.
+    auto& msgs = m_buffer.read(connection, m_readBudgetBytes, m_readBudgetMessages);
+    if (m_buffer.exhausted() && !connection.m_readReady) {
+        connection.m_readReady = true;
+        m_ready.push_back(connection.shared_from_this());
+    }
+    processMessages(connection, msgs);
+}
+
+void ReaderThread::processReady()
+{
+    if (m_ready.empty())
+        return;
+
+    // those running out again wait for the next iteration
+    m_readying.swap(m_ready);
+    for (const auto& connection : m_readying) {
+        // handed on (its new reader finds the socket readable as it registers
+        // it) or released since it was listed
+        if (!owns(*connection) || !connection->m_readReady)
+            continue;
+        connection->m_readReady = false;
+        // io_uring backend: the poll armed on its new reader picks it up
+        if (connection->m_migrateTo)
+            continue;
+
+        try {
+            processRead(*connection);
+        } catch (const SocketClosedError& e) {
+            LOG_ERROR("Socket is closed, fd=" << connection->getFD());
+        }
+        chargeLoad(*connection);
+    }
+    m_readying.clear();
+}
+
+void ReaderThread::processMessages(ConnectionHandle& connection, std::vector<std::string>& msgs)
+{
+    // Known connection: process outside the lock (msgs points to m_readResult,
+    // which is stable until the next read() call — only happens on this thread)
+    if (NetworkHandler* handler = connection.getHandler()) {
+        LOG_TRACE("Handling data for known connection on fd=" << connection.getFD());
+
+        if (msgs.empty())
+            return;
+
+        size_t bytes = 0;
+        for (auto& msg : msgs) {
+            bytes += msg.size();
+            handler->processMessage(std::move(msg));
+        }
+
+        countRead(connection, msgs.size(), bytes);
+        markForUpdate(connection);
+        return;
+    }
+
+    if (msgs.empty())
+        return;
+
+    // Cold path (connection setup): associate the connection with the session
+    // its first message is for
+    std::shared_ptr<NetworkHandler> associated;
     {
         std::lock_guard lock(m_mutex);
-        for (const auto& [k, conn] : m_connections) {
-            ::close(k);
-            m_network.removeConnection(k);
-            conn->invalidate();
+
+        const auto acceptor = connection.getAcceptor();
+        if (!acceptor) {
+            LOG_WARN("Received data on disconnected fd: " << connection.getFD());
+            return;
+        }
+
+        LOG_TRACE("Handling data for unknown connection on fd=" << connection.getFD());
+        const auto& msg = msgs.front();
+
+        const auto sender_comp = Utils::getTagValue(msg, SENDER_COMP_ID_PATTERN, SENDER_COMP_ID_PATTERN.size(), 0);
+        if (sender_comp.first.empty()) {
+            LOG_ERROR("Received message without SenderCompID");
+            disconnect(connection);
+            return;
+        }
+
+        const auto target_comp = Utils::getTagValue(msg, TARGET_COMP_ID_PATTERN, TARGET_COMP_ID_PATTERN.size(), sender_comp.second);
+        if (target_comp.first.empty()) {
+            LOG_ERROR("Received message without TargetCompID");
+            disconnect(connection);
+            return;
         }
-        for (const auto& [k, _] : m_unknownConnections) {
-            ::close(k);
-            m_network.removeConnection(k);
+
+        // flip as this is from their perspective
+        const auto cpty = target_comp.first + ':' + sender_comp.first;
+        const auto consumerIt = acceptor->m_sessions.find(cpty);
+        if (consumerIt == acceptor->m_sessions.end()) {
+            LOG_ERROR("Received connection from unknown counterparty: " << cpty);
+            disconnect(connection);
+            return;
         }
-        for (const auto& [k, _] : m_acceptorSockets) {
-            LOG_DEBUG("Closing acceptor socket, fd=" << k);
-            ::close(k);
-            m_network.removeConnection(k);
+
+        // make sure this session isn't already connected
+        if (consumerIt->second->isConnected()) {
+            LOG_ERROR("Received connection from already-connected session: " << cpty);
+            disconnect(connection);
+            return;
         }
 
-        m_connections.clear();
-        m_unknownConnections.clear();
-        m_acceptorSockets.clear();
+        // set socket settings
+        consumerIt->second->setSocketSettings(connection.getFD());
+
+        // assign the connection
+        LOG_DEBUG("Associating fd=" << connection.getFD() << " with session: " << cpty);
+        associated = consumerIt->second;
+        connection.setHandler(associated);
+        associated->setConnection(connection.shared_from_this());
     }
 
-    {
-        std::lock_guard lock(m_writeMutex);
-        m_writeBuffers.clear();
+    // The first messages are handled outside m_mutex like any known connection:
+    // a rejected logon sends and disconnects, which takes the handler's lock and
+    // then ours, the reverse of the order we'd be holding them in here.
+    size_t bytes = 0;
+    for (auto& msg : msgs) {
+        bytes += msg.size();
+        associated->processMessage(std::move(msg));
     }
+    countRead(connection, msgs.size(), bytes);
+    markForUpdate(connection);
+
+    // a session placed elsewhere has its connection follow it there, once
+    // its logon is handled
+    ReaderThread* placed = m_network.getPlacedReader(associated->getSettings().getSessionID());
+    if (placed && placed != this)
+        migrate(connection.shared_from_this(), *placed);
 }
 
-bool ReaderThread::addConnection(const std::shared_ptr<NetworkHandler>& handler, int fd)
+void ReaderThread::processAccept(Acceptor& acceptor)
 {
+    // the acceptor's socket is closed once it's unregistered, under this lock
+    std::lock_guard lock(m_mutex);
+    if (acceptor.m_closed)
+        return;
+
+    LOG_TRACE("Attempting to accept connection on accept socket fd=" << acceptor.m_fd);
+    const auto it = m_acceptorSockets.find(acceptor.m_fd);
+    if (it != m_acceptorSockets.end())
+        m_network.accept(acceptor.m_fd, it->second);
+}
+
+void ReaderThread::processAccepted(Acceptor& acceptor, int fd)
+{
+    std::lock_guard lock(m_mutex);
+    const auto it = m_acceptorSockets.find(acceptor.m_fd);
+    if (acceptor.m_closed || it == m_acceptorSockets.end() || it->second.get() != &acceptor) {
+        ::close(fd);
+        return;
+    }
+
+    LOG_TRACE("Accepted connection fd=" << fd << " on accept socket fd=" << acceptor.m_fd);
+    m_network.adopt(fd, it->second);
+}
+
+void ReaderThread::accept(int fd, const std::shared_ptr<Acceptor>& acceptor, std::shared_ptr<TLSConnection> tls)
+{
+    auto connection = std::make_shared<ConnectionHandle>(*this, fd, std::move(tls));
+    connection->setAcceptor(acceptor);
+
+    std::lock_guard lock(m_mutex);
+    m_connections[fd] = connection;
+    registerFD(fd, connection);
+}
+
+void ReaderThread::stop()
+{
+    m_running.store(false, std::memory_order_release);
+
+    // Wake the reader from epoll_wait via eventfd
+    uint64_t val = 1;
+    ::write(m_eventFD, &val, sizeof(val));
+
+    // close open connections
     std::lock_guard lock(m_mutex);
-    handler->setConnection(std::make_shared<ConnectionHandle>(m_network, *this, fd, m_network.hasTLS(fd)));
-    m_connections[fd] = handler;
 
+    std::vector<std::shared_ptr<ConnectionHandle>> connections;
+    connections.reserve(m_connections.size());
+    for (const auto& [_, connection] : m_connections)
+        connections.push_back(connection);
+    for (const auto& connection : connections)
+        disconnect(*connection);
+
+    for (const auto& [k, acceptor] : m_acceptorSockets) {
+        LOG_DEBUG("Closing acceptor socket, fd=" << k);
+        unregisterAcceptor(k);
+        acceptor->m_closed = true;
+        ::close(k);
+        retire(acceptor);
+    }
+    m_acceptorSockets.clear();
+}
+
+bool ReaderThread::addConnection(const std::shared_ptr<NetworkHandler>& handler, int fd, std::shared_ptr<TLSConnection> tls)
+{
+    auto connection = std::make_shared<ConnectionHandle>(*this, fd, std::move(tls));
+    connection->setHandler(handler);
+    handler->setConnection(connection);
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_connections[fd] = connection;
+        registerFD(fd, connection);
+    }
+
+    // the session's first update (an initiator's logon) is due right away
+    connection->requestUpdate();
+    wake();
     return true;
 }
 
@@ -1006,8 +1317,10 @@ void ReaderThread::addAcceptor(const std::shared_ptr<NetworkHandler>& handler, c
 {
     std::lock_guard lock(m_mutex);
     auto it = m_acceptorSockets.find(fd);
-    if (it == m_acceptorSockets.end())
-        it = m_acceptorSockets.emplace(fd, std::make_shared<Acceptor>()).first;
+    if (it == m_acceptorSockets.end()) {
+        it = m_acceptorSockets.emplace(fd, std::make_shared<Acceptor>(fd)).first;
+        registerFD(fd, it->second);
+    }
     it->second->m_sessions[sessionID] = handler;
     LOG_DEBUG("Created acceptor socket for " << sessionID << " with fd=" << fd);
 }
@@ -1020,110 +1333,783 @@ bool ReaderThread::removeAcceptor(const SessionID_T sessionID, int fd)
         return true;
     it->second->m_sessions.erase(sessionID);
     if (it->second->m_sessions.empty()) {
-        m_acceptorSockets.erase(fd);
+        // the caller closes the socket once we've let go of it
+        unregisterAcceptor(fd);
+        it->second->m_closed = true;
+        retire(it->second);
+        m_acceptorSockets.erase(it);
         return true;
     }
     return false;
 }
 
-void ReaderThread::disconnect(int fd)
+void ReaderThread::disconnect(ConnectionHandle& connection)
 {
-    {
+    std::unique_lock lock(m_mutex);
+
+    const int fd = connection.getFD();
+    const auto it = m_connections.find(fd);
+    if (it == m_connections.end() || it->second.get() != &connection) {
+        // handed to another reader since the caller looked it up
+        ReaderThread* owner = connection.m_readerThread.load(std::memory_order_acquire);
+        if (owner != this) {
+            lock.unlock();
+            owner->disconnect(connection);
+        }
+        return;
+    }
+
+    // held past the unlock below
+    const std::shared_ptr<NetworkHandler> handler = connection.m_handler;
+    if (handler) {
+        LOG_DEBUG("Disconnecting known connection, fd=" << fd);
+        handler->invalidate();
+    } else {
+        LOG_DEBUG("Disconnecting unknown connection, fd=" << fd);
+    }
+
+    // Nothing may write to the fd past this point, inline or from a flush. It
+    // isn't closed until it's reclaimed (retire() wakes us for that), so a
+    // read in flight on the reader can't land on another socket given the same fd.
+    connection.shutdownWrites();
+    if (m_backend == Backend::EPOLL)
+        ::epoll_ctl(m_epollFD, EPOLL_CTL_DEL, fd, nullptr);
+
+    retire(std::move(it->second));
+    m_connections.erase(it);
+
+    // the session may send, and so disconnect, in response
+    lock.unlock();
+    if (handler)
+        handler->notifyDisconnected();
+}
+
+void ReaderThread::retire(std::shared_ptr<PollEntry> entry)
+{
+    m_retired.push(std::move(entry));
+
+    uint64_t val = 1;
+    ::write(m_eventFD, &val, sizeof(val));
+}
+
+void ReaderThread::wake()
+{
+    if (m_wakeupPending.exchange(true, std::memory_order_acq_rel))
+        return;
+
+    uint64_t val = 1;
+    ::write(m_eventFD, &val, sizeof(val));
+    m_wakeups.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ReaderThread::reclaim()
+{
+    std::shared_ptr<PollEntry> entry;
+    uint64_t position;
+    while (m_retired.pop(entry, position)) {
+        // its requests hold it until they've completed
+        if (m_backend == Backend::IO_URING)
+            cancelRing(*entry);
+        if (entry->m_type == PollEntry::Type::CONNECTION)
+            static_cast<ConnectionHandle&>(*entry).release();
+    }
+}
+
+void ReaderThread::unregisterAcceptor(int fd)
+{
+    if (m_backend == Backend::EPOLL) {
+        ::epoll_ctl(m_epollFD, EPOLL_CTL_DEL, fd, nullptr);
+        return;
+    }
+
+    // A multishot accept holds its own reference to the socket, which would
+    // keep listening after the fd is closed until the request's cancelled;
+    // shutting it down ends the accept now.
+    ::shutdown(fd, SHUT_RD);
+}
+
+////////////////////////////////////////////
+//            io_uring backend            //
+////////////////////////////////////////////
+
+// user_data is the entry's address with the request type in its low bits;
+// the wake request has no entry, cancels need no completion handling
+constexpr uint64_t RING_WAKE = 0;
+constexpr uint64_t RING_RECV = 1;
+constexpr uint64_t RING_POLL = 2;
+constexpr uint64_t RING_ACCEPT = 3;
+constexpr uint64_t RING_SEND = 4;
+constexpr uint64_t RING_CANCEL = 5;
+constexpr uint64_t RING_OP_MASK = 7;
+
+// a failed accept (EMFILE, ENFILE) would just fail again if re-armed at once
+constexpr int64_t ACCEPT_BACKOFF_MIN_MS = 10;
+constexpr int64_t ACCEPT_BACKOFF_MAX_MS = 1000;
+
+bool ReaderThread::initRing()
+{
+    if (!m_ring.init(RING_ENTRIES))
+        return false;
+
+    const long buffers = std::clamp(PlatformSettings::getLong(PlatformSettings::READER_RING_BUFFERS), 1L, static_cast<long>(RING_MAX_BUFFERS));
+    if (!m_ringBuffers.init(m_ring, 0, std::bit_ceil(static_cast<unsigned>(buffers)), READ_BUF_SIZE)) {
+        m_ring.close();
+        return false;
+    }
+    return true;
+}
+
+void ReaderThread::processRing()
+{
+    const long maxTimeout = PlatformSettings::getLong(PlatformSettings::EPOLL_TIMEOUT);
+    const bool busyPoll = m_busyPoll;
+    const int64_t busyPollIdleUs = PlatformSettings::getLong(PlatformSettings::READER_BUSY_POLL_IDLE_US);
+    int64_t lastEventUs = Utils::getEpochMicros();
+
+    const auto handle = [this](const io_uring_cqe& cqe) { handleCompletion(cqe); };
+
+    while (m_running.load(std::memory_order_acquire)) {
+        if (!m_wakeArmed)
+            armWake();
+        armPending();
+
+        // everything armed or sent since the last iteration goes in with the wait
+        const bool spinning = busyPoll && (busyPollIdleUs <= 0 || Utils::getEpochMicros() - lastEventUs < busyPollIdleUs);
+        const bool ready = !m_ready.empty();
+        if (spinning || ready) {
+            m_ring.submit();
+        } else {
+            const int timeout = nextTimeout(maxTimeout);
+            m_ring.wait(std::chrono::milliseconds(timeout < 0 ? 3600 * 1000 : timeout));
+        }
+
+        // completions are handled as they're reaped
+        const int64_t reapFrom = Utils::getEpochMicros();
+        m_loadMark = reapFrom;
+        processReady();
+        const bool reaped = m_ring.reap(handle) > 0;
+        const int64_t busyFrom = reaped || ready ? reapFrom : 0;
+        if (reaped) {
+            if (busyPoll)
+                lastEventUs = reapFrom;
+        } else if (spinning && !ready) {
+            m_spins.fetch_add(1, std::memory_order_relaxed);
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+
+        runCompletedCallbacks();
+
+        // nothing from this batch is in hand any more
+        reclaim();
+
+        updateSessions();
+        processMigrations();
+
+        if (busyFrom)
+            m_busyMicros.fetch_add(Utils::getEpochMicros() - busyFrom, std::memory_order_relaxed);
+    }
+
+    drainRing();
+}
+
+void ReaderThread::armPending()
+{
+    std::shared_ptr<PollEntry> entry;
+    uint64_t position;
+    while (m_arming.pop(entry, position))
+        arm(entry);
+}
+
+void ReaderThread::arm(const std::shared_ptr<PollEntry>& entry)
+{
+    // anything unregistered before we got to it stays off the ring
+    std::lock_guard lock(m_mutex);
+    if (entry->m_type == PollEntry::Type::ACCEPTOR) {
+        auto& acceptor = static_cast<Acceptor&>(*entry);
+        if (!acceptor.m_closed)
+            armAccept(acceptor, entry);
+        return;
+    }
+
+    auto& connection = static_cast<ConnectionHandle&>(*entry);
+    const auto it = m_connections.find(connection.getFD());
+    if (it == m_connections.end() || it->second.get() != &connection)
+        return;
+
+    if (connection.m_tls)
+        armPoll(connection, entry);
+    else
+        armRecv(connection, entry);
+}
+
+void ReaderThread::armWake()
+{
+    io_uring_sqe* sqe = ringSqe(RING_WAKE);
+    if (!sqe)
+        return;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = m_eventFD;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    m_wakeArmed = true;
+}
+
+void ReaderThread::armRecv(ConnectionHandle& connection, std::shared_ptr<PollEntry> owner)
+{
+    io_uring_sqe* sqe = ringSqe(reinterpret_cast<uint64_t>(&connection) | RING_RECV);
+    if (!sqe)
+        return;
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = connection.m_fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = m_ringBuffers.getGroup();
+    holdRing(connection, std::move(owner));
+}
+
+void ReaderThread::armPoll(ConnectionHandle& connection, std::shared_ptr<PollEntry> owner)
+{
+    io_uring_sqe* sqe = ringSqe(reinterpret_cast<uint64_t>(&connection) | RING_POLL);
+    if (!sqe)
+        return;
+
+    // edge-triggered, like the epoll registration
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = connection.m_fd;
+    sqe->poll32_events = EPOLLIN | EPOLLOUT | EPOLLHUP | EPOLLRDHUP | EPOLLERR;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    holdRing(connection, std::move(owner));
+}
+
+void ReaderThread::armAccept(Acceptor& acceptor, std::shared_ptr<PollEntry> owner)
+{
+    io_uring_sqe* sqe = ringSqe(reinterpret_cast<uint64_t>(&acceptor) | RING_ACCEPT);
+    if (!sqe)
+        return;
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = acceptor.m_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    holdRing(acceptor, std::move(owner));
+}
+
+void ReaderThread::rearm(PollEntry& entry, uint64_t op)
+{
+    if (isCancelled(entry))
+        return;
+
+    std::lock_guard lock(m_mutex);
+    if (entry.m_type == PollEntry::Type::ACCEPTOR) {
+        auto& acceptor = static_cast<Acceptor&>(entry);
+        if (!acceptor.m_closed)
+            armAccept(acceptor, nullptr);
+        return;
+    }
+
+    // a migrating connection is re-armed on its new reader's ring instead
+    auto& connection = static_cast<ConnectionHandle&>(entry);
+    const auto it = m_connections.find(connection.getFD());
+    if (it == m_connections.end() || it->second.get() != &connection || connection.m_migrateTo)
+        return;
+
+    if (op == RING_POLL)
+        armPoll(connection, nullptr);
+    else
+        armRecv(connection, nullptr);
+}
+
+io_uring_sqe* ReaderThread::ringSqe(uint64_t userData)
+{
+    io_uring_sqe* sqe = m_ring.getSqe();
+    if (!sqe) {
+        // full: hand the kernel what's queued to make room
+        m_ring.submit();
+        sqe = m_ring.getSqe();
+    }
+
+    if (!sqe) {
+        LOG_ERROR("io_uring submission queue full, dropping request");
+        return nullptr;
+    }
+    sqe->user_data = userData;
+    return sqe;
+}
+
+void ReaderThread::holdRing(PollEntry& entry, std::shared_ptr<PollEntry> owner)
+{
+    auto& ring = m_ringEntries[&entry];
+    if (!ring.m_entry)
+        ring.m_entry = std::move(owner);
+    ++ring.m_requests;
+}
+
+void ReaderThread::releaseRing(PollEntry& entry)
+{
+    const auto it = m_ringEntries.find(&entry);
+    if (it == m_ringEntries.end() || --it->second.m_requests != 0)
+        return;
+
+    auto held = std::move(it->second.m_entry);
+    m_ringEntries.erase(it);
+
+    // nothing of a migrating connection's is left on our ring: it can move
+    if (entry.m_type == PollEntry::Type::CONNECTION && static_cast<ConnectionHandle&>(entry).m_migrateTo)
+        m_handOffs.push_back(std::static_pointer_cast<ConnectionHandle>(std::move(held)));
+}
+
+bool ReaderThread::isCancelled(PollEntry& entry) const
+{
+    const auto it = m_ringEntries.find(&entry);
+    return it == m_ringEntries.end() || it->second.m_cancelled;
+}
+
+void ReaderThread::cancelRing(PollEntry& entry)
+{
+    const auto it = m_ringEntries.find(&entry);
+    if (it == m_ringEntries.end() || it->second.m_cancelled)
+        return;
+    it->second.m_cancelled = true;
+
+    // at most one request of each type is in flight per entry
+    const uint64_t base = reinterpret_cast<uint64_t>(&entry);
+    for (const uint64_t op : {RING_RECV, RING_POLL, RING_ACCEPT, RING_SEND}) {
+        if ((entry.m_type == PollEntry::Type::ACCEPTOR) != (op == RING_ACCEPT))
+            continue;
+
+        io_uring_sqe* sqe = ringSqe(RING_CANCEL);
+        if (!sqe)
+            return;
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = base | op;
+    }
+}
+
+void ReaderThread::drainRing()
+{
+    // Cancels everything still armed and waits for it to complete, so the
+    // kernel is done with every entry and send buffer before they're freed.
+    std::vector<PollEntry*> entries;
+    entries.reserve(m_ringEntries.size());
+    for (const auto& [entry, _] : m_ringEntries)
+        entries.push_back(entry);
+    for (PollEntry* entry : entries)
+        cancelRing(*entry);
+
+    if (m_wakeArmed) {
+        if (io_uring_sqe* sqe = ringSqe(RING_CANCEL)) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = RING_WAKE;
+        }
+    }
+
+    const auto handle = [this](const io_uring_cqe& cqe) { handleCompletion(cqe); };
+    const int64_t deadline = Utils::getEpochMillis() + 1000;
+    while ((!m_ringEntries.empty() || m_wakeArmed) && Utils::getEpochMillis() < deadline) {
+        m_ring.wait(std::chrono::milliseconds(10));
+        m_ring.reap(handle);
+    }
+
+    if (!m_ringEntries.empty())
+        LOG_WARN(m_ringEntries.size() << " io_uring requests still in flight at shutdown");
+    runCompletedCallbacks();
+}
+
+void ReaderThread::handleCompletion(const io_uring_cqe& cqe)
+{
+    const uint64_t op = cqe.user_data & RING_OP_MASK;
+    PollEntry* entry = reinterpret_cast<PollEntry*>(cqe.user_data & ~RING_OP_MASK);
+    const bool more = cqe.flags & IORING_CQE_F_MORE;
+
+    switch (op) {
+        case RING_WAKE:
+            if (!more)
+                m_wakeArmed = false;
+            if (cqe.res > 0) {
+                // cleared before the dirty list is drained, so anything
+                // scheduled from here on wakes us again
+                m_wakeupPending.exchange(false, std::memory_order_acq_rel);
+                uint64_t val;
+                ::read(m_eventFD, &val, sizeof(val));
+                flushWrites();
+            }
+            return;
+
+        case RING_CANCEL:
+            return;
+
+        case RING_SEND:
+            handleSend(static_cast<ConnectionHandle&>(*entry), cqe.res);
+            chargeLoad(static_cast<ConnectionHandle&>(*entry));
+            releaseRing(*entry);
+            return;
+
+        case RING_RECV:
+            handleRecv(static_cast<ConnectionHandle&>(*entry), cqe);
+            chargeLoad(static_cast<ConnectionHandle&>(*entry));
+            break;
+
+        case RING_POLL:
+            if (cqe.res > 0 && !isCancelled(*entry))
+                processEvents(static_cast<ConnectionHandle&>(*entry), static_cast<uint32_t>(cqe.res));
+            chargeLoad(static_cast<ConnectionHandle&>(*entry));
+            break;
+
+        case RING_ACCEPT: {
+            auto& acceptor = static_cast<Acceptor&>(*entry);
+            handleAccept(acceptor, cqe.res);
+            if (cqe.res >= 0) {
+                acceptor.m_acceptBackoffMs = 0;
+            } else if (!more && cqe.res != -ECANCELED && !isCancelled(acceptor)) {
+                // re-armed from the wheel once the backoff is up, which holds it meanwhile
+                acceptor.m_acceptBackoffMs = std::clamp(acceptor.m_acceptBackoffMs * 2, ACCEPT_BACKOFF_MIN_MS, ACCEPT_BACKOFF_MAX_MS);
+                m_timers.schedule(Utils::getEpochMillis() + acceptor.m_acceptBackoffMs, m_ringEntries[&acceptor].m_entry);
+                releaseRing(acceptor);
+                return;
+            }
+            break;
+        }
+    }
+
+    // A multishot request ends on errors (or running out of buffers) as well
+    // as on cancellation; re-armed before it lets go, so the entry stays held
+    if (!more) {
+        rearm(*entry, op);
+        releaseRing(*entry);
+    }
+}
+
+void ReaderThread::handleRecv(ConnectionHandle& connection, const io_uring_cqe& cqe)
+{
+    if (cqe.flags & IORING_CQE_F_BUFFER) {
+        const auto id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        // parsing copies the messages out, so the buffer goes straight back
+        if (cqe.res > 0 && !isCancelled(connection))
+            processMessages(connection, m_buffer.parse(connection, std::string_view(m_ringBuffers.get(id), cqe.res)));
+        m_ringBuffers.recycle(id);
+        return;
+    }
+
+    if (cqe.res == 0) {
+        LOG_INFO("disconnect callback for fd=" << connection.getFD());
+        disconnect(connection);
+    } else if (cqe.res == -ENOBUFS) {
+        LOG_DEBUG("Out of receive buffers on fd=" << connection.getFD() << ", re-arming");
+    } else if (cqe.res < 0 && cqe.res != -ECANCELED) {
+        LOG_ERROR("Error reading from socket fd=" << connection.getFD() << ": " << strerror(-cqe.res));
+        disconnect(connection);
+    }
+}
+
+void ReaderThread::handleAccept(Acceptor& acceptor, int res)
+{
+    if (res >= 0) {
+        LOG_INFO("Accepted new connection fd=" << res << " on server fd=" << acceptor.m_fd);
+        if (isCancelled(acceptor))
+            ::close(res);
+        else
+            processAccepted(acceptor, res);
+    } else if (res != -ECANCELED && !isCancelled(acceptor)) {
+        // a socket shut down as it's unregistered fails its accept too
         std::lock_guard lock(m_mutex);
-        ::close(fd);
-        m_network.removeConnection(fd);
-        m_buffer.clear(fd);
-        const auto it = m_connections.find(fd);
-        if (m_connections.find(fd) != m_connections.end()) {
-            LOG_DEBUG("Disconnecting known connection, fd=" << fd);
-            it->second->invalidate();
-            m_connections.erase(fd);
-        } else if (m_unknownConnections.find(fd) != m_unknownConnections.end()) {
-            LOG_DEBUG("Disconnecting unknown connection, fd=" << fd);
-            m_unknownConnections.erase(fd);
+        if (!acceptor.m_closed)
+            LOG_WARN("Failed to accept new socket: " << strerror(-res));
+    }
+}
+
+void ReaderThread::submitSend(ConnectionHandle& connection)
+{
+    // one sendmsg in flight per connection; its completion sends the rest,
+    // unless the connection is migrating, when its new reader does
+    auto& send = connection.m_ringSend;
+    if ((send && send->m_inFlight) || connection.m_migrateTo)
+        return;
+    if (!connection.hasPendingWrites() || !connection.acquireWrites())
+        return;
+
+    if (!send)
+        send = std::make_unique<ConnectionHandle::RingSend>();
+
+    // The token only guards taking writes off the queue: the batch stays
+    // counted in m_pending, so inline sends keep queueing behind it.
+    WriteEntry next;
+    uint64_t position;
+    while (send->m_entries.size() < MAX_WRITE_IOVECS && !connection.m_drain.empty()) {
+        send->m_entries.push_back(std::move(connection.m_drain.front()));
+        connection.m_drain.pop_front();
+    }
+    while (send->m_entries.size() < MAX_WRITE_IOVECS && connection.m_queue.pop(next, position))
+        send->m_entries.push_back(std::move(next));
+    connection.releaseWrites();
+
+    if (send->m_entries.empty())
+        return;
+
+    io_uring_sqe* sqe = ringSqe(reinterpret_cast<uint64_t>(&connection) | RING_SEND);
+    if (!sqe) {
+        // tried again on the next flush
+        connection.schedule();
+        return;
+    }
+
+    const size_t count = send->m_entries.size();
+    for (size_t i = 0; i < count; ++i) {
+        auto& entry = send->m_entries[i];
+        const size_t offset = i == 0 ? send->m_offset : 0;
+        send->m_iovs[i].iov_base = const_cast<char*>(entry.m_msg.data()) + offset;
+        send->m_iovs[i].iov_len = entry.m_msg.size() - offset;
+    }
+    memset(&send->m_msg, 0, sizeof(send->m_msg));
+    send->m_msg.msg_iov = send->m_iovs;
+    send->m_msg.msg_iovlen = count;
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = connection.m_fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&send->m_msg);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    send->m_inFlight = true;
+    holdRing(connection, connection.shared_from_this());
+}
+
+void ReaderThread::handleSend(ConnectionHandle& connection, int res)
+{
+    auto& send = *connection.m_ringSend;
+    send.m_inFlight = false;
+
+    if (res < 0 || isCancelled(connection)) {
+        if (res < 0 && res != -ECANCELED)
+            LOG_ERROR("sendmsg failed on fd=" << connection.getFD() << ": " << strerror(-res));
+        connection.m_pending.fetch_sub(send.m_entries.size(), std::memory_order_acq_rel);
+        send.m_entries.clear();
+        send.m_offset = 0;
+        return;
+    }
+
+    // account for sent bytes, collecting callbacks for completed messages
+    size_t sent = static_cast<size_t>(res);
+    size_t completed = 0;
+    for (; completed < send.m_entries.size(); ++completed) {
+        auto& entry = send.m_entries[completed];
+        const size_t remaining = entry.m_msg.size() - send.m_offset;
+        if (sent < remaining) {
+            send.m_offset += sent;
+            break;
         }
+        sent -= remaining;
+        send.m_offset = 0;
+        if (entry.m_callback)
+            m_completedCallbacks.push_back(std::move(entry.m_callback));
     }
+    send.m_entries.erase(send.m_entries.begin(), send.m_entries.begin() + completed);
+    connection.m_pending.fetch_sub(completed, std::memory_order_acq_rel);
+
+    // a partial send resumes where it stopped, ahead of anything queued since
+    submitSend(connection);
+    // a replay waiting on the socket to drain can send its next chunk
+    markForUpdate(connection);
+}
+
+////////////////////////////////////////////
+//               Migration                //
+////////////////////////////////////////////
+
+void ReaderThread::migrate(std::shared_ptr<ConnectionHandle> connection, ReaderThread& target)
+{
+    m_migrations.push({std::move(connection), &target});
+    wake();
+}
+
+void ReaderThread::processMigrations()
+{
+    // Only ever called once the batch's updates are done, so no migrating
+    // connection is left on m_updateDue; requests and timers for it that
+    // reach us later are passed along to its new reader.
+    Migration migration;
+    uint64_t position;
+    while (m_migrations.pop(migration, position)) {
+        auto& connection = *migration.m_connection;
+        if (migration.m_target == this || !owns(connection))
+            continue;
+
+        if (m_backend == Backend::IO_URING) {
+            if (!connection.m_migrateTo) {
+                connection.m_migrateTo = migration.m_target;
+                startMigration(connection);
+            }
+        } else {
+            handOff(connection, *migration.m_target);
+        }
+    }
+    migration = {};
+
+    if (m_handOffs.empty())
+        return;
+
+    std::vector<std::shared_ptr<ConnectionHandle>> handOffs;
+    handOffs.swap(m_handOffs);
+    for (const auto& connection : handOffs) {
+        ReaderThread* target = std::exchange(connection->m_migrateTo, nullptr);
+        handOff(*connection, *target);
+    }
+}
+
+void ReaderThread::startMigration(ConnectionHandle& connection)
+{
+    const auto it = m_ringEntries.find(&connection);
+    if (it == m_ringEntries.end()) {
+        // not armed yet, or already ended
+        m_handOffs.push_back(connection.shared_from_this());
+        return;
+    }
+
+    // A send in flight completes on its own, and nothing more is submitted or
+    // re-armed here; once its last request completes, releaseRing() queues
+    // the hand-off. What it hasn't received waits in the socket for its new reader.
+    const uint64_t base = reinterpret_cast<uint64_t>(&connection);
+    for (const uint64_t op : {RING_RECV, RING_POLL}) {
+        io_uring_sqe* sqe = ringSqe(RING_CANCEL);
+        if (!sqe)
+            return;
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = base | op;
+    }
+}
+
+void ReaderThread::handOff(ConnectionHandle& connection, ReaderThread& target)
+{
+    const int fd = connection.getFD();
+    std::shared_ptr<ConnectionHandle> handle;
+    {
+        std::scoped_lock lock(m_mutex, target.m_mutex);
+
+        // disconnected meanwhile, or the target is shutting down
+        const auto it = m_connections.find(fd);
+        if (it == m_connections.end() || it->second.get() != &connection || !target.m_running.load(std::memory_order_acquire))
+            return;
+
+        if (m_backend == Backend::EPOLL)
+            ::epoll_ctl(m_epollFD, EPOLL_CTL_DEL, fd, nullptr);
+        handle = std::move(it->second);
+        m_connections.erase(it);
+
+        // its deadlines go on the new reader's wheel with its next update, and
+        // anything left to read is reported as the target registers the socket
+        handle->m_nextUpdate = TimerWheel<int>::NONE;
+        handle->m_readReady = false;
+        handle->m_readerThread.store(&target, std::memory_order_release);
+        target.m_connections[fd] = handle;
+        target.registerFD(fd, handle);
+    }
+
+    m_movedOut.fetch_add(1, std::memory_order_relaxed);
+    target.m_movedIn.fetch_add(1, std::memory_order_relaxed);
+    LOG_INFO("Moved fd=" << fd << " to reader " << target.getName());
+
+    // Whatever was asked of us is now the target's to do. Each of these does
+    // nothing if it's still pending here, as we pass it along once we get to it.
+    handle->requestUpdate();
+    if (handle->hasPendingWrites())
+        handle->schedule();
+    target.wake();
+}
+
+ReaderStats ReaderThread::getStats()
+{
+    ReaderStats stats;
+    stats.m_name = m_name;
+    stats.m_pool = m_pool;
+    stats.m_busyPoll = m_busyPoll;
+    stats.m_messages = m_messages.load(std::memory_order_relaxed);
+    stats.m_bytes = m_bytes.load(std::memory_order_relaxed);
+    stats.m_load = m_load.load(std::memory_order_relaxed);
+    stats.m_movedIn = m_movedIn.load(std::memory_order_relaxed);
+    stats.m_movedOut = m_movedOut.load(std::memory_order_relaxed);
+    stats.m_wakeups = m_wakeups.load(std::memory_order_relaxed);
+    stats.m_flushes = m_flushes.load(std::memory_order_relaxed);
+    stats.m_spins = m_spins.load(std::memory_order_relaxed);
+
+    const int64_t elapsed = Utils::getEpochMicros() - m_startedMicros;
+    if (elapsed > 0)
+        stats.m_busy = std::min(1.0, static_cast<double>(m_busyMicros.load(std::memory_order_relaxed)) / elapsed);
+
+    std::lock_guard lock(m_mutex);
+    stats.m_connections = m_connections.size();
+    for (const auto& [_, connection] : m_connections) {
+        if (NetworkHandler* handler = connection->getHandler())
+            stats.m_sessions.push_back(handler->getSettings().getSessionID());
+    }
+    return stats;
+}
+
+ReaderLoad ReaderThread::sampleLoad(int64_t windowMicros)
+{
+    ReaderLoad load;
+    load.m_reader = this;
 
-    // Clean up write buffers
-    {
-        std::lock_guard lock(m_writeMutex);
-        m_writeBuffers.erase(fd);
+    const double window = static_cast<double>(std::max<int64_t>(windowMicros, 1));
+    const int64_t busyMicros = m_busyMicros.load(std::memory_order_relaxed);
+    load.m_load = (busyMicros - m_sampledBusyMicros) / window;
+    m_sampledBusyMicros = busyMicros;
+    m_load.store(load.m_load, std::memory_order_relaxed);
+
+    std::lock_guard lock(m_mutex);
+    for (const auto& [_, connection] : m_connections) {
+        const int64_t micros = connection->m_loadMicros.exchange(0, std::memory_order_relaxed);
+        const uint64_t messages = connection->m_loadMessages.exchange(0, std::memory_order_relaxed);
+
+        // connections not yet associated with a session stay where they are
+        NetworkHandler* handler = connection->getHandler();
+        if (!handler)
+            continue;
+
+        const auto& settings = handler->getSettings();
+        auto& sample = load.m_connections.emplace_back();
+        sample.m_connection = connection;
+        sample.m_sessionID = settings.getSessionID();
+        sample.m_load = micros / window;
+        sample.m_messageRate = messages * 1e6 / window;
+        sample.m_pinned = !settings.getString(SessionSettings::READER_THREAD).empty() || parse_reader_priority(settings.getString(SessionSettings::READER_PRIORITY)) == ReaderPriority::CRITICAL;
     }
+    return load;
 }
 
 ////////////////////////////////////////////
 //               ReadBuffer               //
 ////////////////////////////////////////////
 
-std::vector<std::string>& ReadBuffer::read(int fd)
+std::vector<std::string>& ReadBuffer::read(ConnectionHandle& connection, size_t maxBytes, size_t maxMessages)
 {
     m_readResult.clear();
+    m_exhausted = false;
 
-    auto it = m_bufferMap.find(fd);
-    if (it == m_bufferMap.end())
-        it = m_bufferMap.insert({fd, ""}).first;
-    std::string& buffer = it->second;
+    std::string& buffer = connection.getReadBuffer();
 
     char read_buffer[READ_BUF_SIZE];
 
+    // messages an earlier turn's budget left in the buffer come first
+    if (!buffer.empty() && extract(buffer, maxMessages)) {
+        m_exhausted = true;
+        return m_readResult;
+    }
+
     int bytes = 0;
-    while ((bytes = m_network.readConnection(fd, read_buffer, sizeof(read_buffer))) > 0) {
+    size_t total = 0;
+    while ((bytes = connection.read(read_buffer, sizeof(read_buffer))) > 0) {
         buffer.append(read_buffer, bytes);
 
-        // parse all the messages we can, tracking consumed bytes via offset
-        size_t consumed = 0;
-        while (true) {
-            // find beginning of message
-            const size_t ptr_start = buffer.find(BEGIN_STRING_TAG, consumed);
-            if (ptr_start == std::string::npos)
-                break;
-
-            if (ptr_start > consumed) {
-                LOG_WARN("Discarding text received in buffer: " << buffer.substr(consumed, ptr_start - consumed));
-                consumed = ptr_start;
-            }
-
-            size_t ptr = ptr_start;
-
-            // find start of bodylength tag (zero-copy)
-            auto tag_it = Utils::getTagValueView(buffer, BODY_LENGTH_PATTERN, BODY_LENGTH_PATTERN.size(), ptr);
-            if (tag_it.first.empty())
-                break;
-            ptr = tag_it.second;
-
-            {
-                int bodyLength = 0;
-                const auto [p, ec] = std::from_chars(tag_it.first.data(), tag_it.first.data() + tag_it.first.size(), bodyLength);
-                if (ec != std::errc{} || bodyLength < 0) {
-                    LOG_WARN("Unable to parse message, bad body length: " << buffer.substr(consumed, ptr + 1 - consumed));
-                    consumed = ptr + 1;
-                    continue;
-                }
-                ptr += bodyLength;
-            }
-
-            // find the checksum (zero-copy, we only need the position)
-            tag_it = Utils::getTagValueView(buffer, CHECKSUM_PATTERN, CHECKSUM_PATTERN.size(), ptr);
-            if (tag_it.first.empty())
-                break;
-            ptr = tag_it.second;
-
-            // completed message!
-            const size_t msgEnd = ptr + 1;
-            if (consumed == 0 && msgEnd == buffer.size()) {
-                // Fast path: single message consumed the entire buffer — move instead of copy.
-                m_readResult.push_back(std::move(buffer));
-                buffer.clear();
-                consumed = 0; // buffer is now empty, skip erase below
-                break;
-            }
-            m_readResult.push_back(buffer.substr(consumed, msgEnd - consumed));
-            consumed = msgEnd;
+        // Out of budget: the rest stays in the buffer or on the socket for
+        // the connection's next turn. Never only in TLS's own buffer, which
+        // nothing would report; leftover messages in ours keep it listed.
+        total += bytes;
+        if (extract(buffer, maxMessages) || (maxBytes && total >= maxBytes && !connection.hasBufferedReads())) {
+            m_exhausted = true;
+            return m_readResult;
         }
-
-        // compact buffer once after extracting all messages
-        if (consumed > 0)
-            buffer.erase(0, consumed);
     }
 
     if (bytes <= 0) {
@@ -1143,158 +2129,269 @@ std::vector<std::string>& ReadBuffer::read(int fd)
     return m_readResult;
 }
 
+std::vector<std::string>& ReadBuffer::parse(ConnectionHandle& connection, std::string_view data)
+{
+    m_readResult.clear();
+
+    std::string& buffer = connection.getReadBuffer();
+    buffer.append(data);
+    extract(buffer);
+
+    return m_readResult;
+}
+
+bool ReadBuffer::extract(std::string& buffer, size_t maxMessages)
+{
+    // parse all the messages we can, tracking consumed bytes via offset
+    size_t consumed = 0;
+    while (!maxMessages || m_readResult.size() < maxMessages) {
+        // find beginning of message
+        const size_t ptr_start = buffer.find(BEGIN_STRING_TAG, consumed);
+        if (ptr_start == std::string::npos)
+            break;
+
+        if (ptr_start > consumed) {
+            LOG_WARN("Discarding text received in buffer: " << buffer.substr(consumed, ptr_start - consumed));
+            consumed = ptr_start;
+        }
+
+        size_t ptr = ptr_start;
+
+        // find start of bodylength tag (zero-copy)
+        auto tag_it = Utils::getTagValueView(buffer, BODY_LENGTH_PATTERN, BODY_LENGTH_PATTERN.size(), ptr);
+        if (tag_it.first.empty())
+            break;
+        ptr = tag_it.second;
+
+        {
+            int bodyLength = 0;
+            const auto [p, ec] = std::from_chars(tag_it.first.data(), tag_it.first.data() + tag_it.first.size(), bodyLength);
+            if (ec != std::errc{} || bodyLength < 0) {
+                LOG_WARN("Unable to parse message, bad body length: " << buffer.substr(consumed, ptr + 1 - consumed));
+                consumed = ptr + 1;
+                continue;
+            }
+            ptr += bodyLength;
+        }
+
+        // find the checksum (zero-copy, we only need the position)
+        tag_it = Utils::getTagValueView(buffer, CHECKSUM_PATTERN, CHECKSUM_PATTERN.size(), ptr);
+        if (tag_it.first.empty())
+            break;
+        ptr = tag_it.second;
+
+        // completed message!
+        const size_t msgEnd = ptr + 1;
+        if (consumed == 0 && msgEnd == buffer.size()) {
+            // Fast path: single message consumed the entire buffer — move instead of copy.
+            m_readResult.push_back(std::move(buffer));
+            buffer.clear();
+            consumed = 0; // buffer is now empty, skip erase below
+            break;
+        }
+        m_readResult.push_back(buffer.substr(consumed, msgEnd - consumed));
+        consumed = msgEnd;
+    }
+
+    // compact buffer once after extracting all messages
+    if (consumed > 0)
+        buffer.erase(0, consumed);
+
+    return maxMessages && m_readResult.size() >= maxMessages;
+}
+
 ////////////////////////////////////////////
 //            Write path                  //
 ////////////////////////////////////////////
 
-bool ReaderThread::trySend(int fd, MsgPacket& msg)
+void ReaderThread::scheduleFlush(std::shared_ptr<ConnectionHandle> handle)
 {
-    std::unique_lock lock(m_writeMutex, std::try_to_lock);
-    if (!lock.owns_lock())
-        return false;
+    m_dirty.push(std::move(handle));
+    wake();
+}
 
-    // only inline send when there's no pending data — preserves message ordering
-    const auto it = m_writeBuffers.find(fd);
-    if (it != m_writeBuffers.end()) {
-        if (!it->second.m_valid.load(std::memory_order_acquire))
-            return false;
-        if (!it->second.m_queue.empty() || !it->second.m_drain.empty())
-            return false;
+void ReaderThread::flushWrites()
+{
+    // only connections with something queued; idle ones are never visited
+    std::shared_ptr<ConnectionHandle> handle;
+    uint64_t position;
+    while (m_dirty.pop(handle, position)) {
+        // off the list before flushing, so a write queued mid-flush puts it back
+        handle->unschedule();
+        if (!owns(*handle)) {
+            // scheduled just as it moved on: its new reader flushes it
+            handle->schedule();
+            continue;
+        }
+        m_flushes.fetch_add(1, std::memory_order_relaxed);
+        if (m_backend == Backend::IO_URING && !handle->m_tls)
+            submitSend(*handle);
+        else
+            handle->flush(m_completedCallbacks);
+        chargeLoad(*handle);
+        markForUpdate(*handle);
     }
+    handle.reset();
 
-    const ssize_t ret = m_network.writeConnection(fd, msg.m_msg.c_str(), msg.m_msg.size());
+    runCompletedCallbacks();
+}
 
-    if (ret == static_cast<ssize_t>(msg.m_msg.size()))
-        return true;
+void ReaderThread::runCompletedCallbacks()
+{
+    // callbacks may disconnect (e.g. terminal logout), which waits for the
+    // connection's write token, so they only ever run once the flush is done
+    if (m_completedCallbacks.empty())
+        return;
 
-    // partial send — trim what was sent so the caller queues only the remainder
-    if (ret > 0)
-        msg.m_msg.erase(0, ret);
+    std::vector<SendCallback_T> callbacks;
+    callbacks.swap(m_completedCallbacks);
+    for (auto& callback : callbacks)
+        callback();
+}
 
-    return false;
+////////////////////////////////////////////
+//            ConnectionHandle            //
+////////////////////////////////////////////
+
+void ConnectionHandle::disconnect()
+{
+    m_readerThread.load(std::memory_order_acquire)->disconnect(*this);
 }
 
-void ReaderThread::queueWrite(int fd, MsgPacket&& msg)
+bool ConnectionHandle::isReady() const
 {
-    {
-        std::lock_guard lock(m_writeMutex);
-        m_writeBuffers[fd].m_queue.push_back({std::move(msg.m_msg), std::move(msg.m_callback)});
-    }
+    return !m_tls || m_tls->m_ready.load(std::memory_order_acquire);
+}
 
-    // wake reader to flush
-    uint64_t val = 1;
-    ::write(m_eventFD, &val, sizeof(val));
+bool ConnectionHandle::requiresProgress() const
+{
+    return !isReady();
 }
 
-void ReaderThread::flushWrites()
+bool ConnectionHandle::progress()
 {
-    std::lock_guard lock(m_writeMutex);
-    for (auto it = m_writeBuffers.begin(); it != m_writeBuffers.end(); ) {
-        if (!it->second.m_valid.load(std::memory_order_acquire)) {
-            it = m_writeBuffers.erase(it);
-            continue;
-        }
-        flushWrite(it->first, it->second);
-        ++it;
+    if (isReady())
+        return true;
+
+    std::lock_guard connLock(m_tls->m_mutex);
+    if (m_tls->m_ready.load(std::memory_order_acquire))
+        return true;
+
+    const int ret = m_tls->m_serverMode ? SSL_accept(m_tls->m_ssl) : SSL_connect(m_tls->m_ssl);
+    if (ret == 1) {
+        m_tls->m_ready.store(true, std::memory_order_release);
+        LOG_INFO("TLS handshake complete for fd=" << m_fd << ", version=" << SSL_get_version(m_tls->m_ssl) << ", cipher=" << SSL_get_cipher(m_tls->m_ssl));
+        return true;
     }
+
+    const int sslErr = SSL_get_error(m_tls->m_ssl, ret);
+    if (sslErr == SSL_ERROR_WANT_READ || sslErr == SSL_ERROR_WANT_WRITE)
+        return true;
+
+    LOG_ERROR("TLS handshake failed on fd=" << m_fd << ": " << get_ssl_error());
+    return false;
 }
 
-void ReaderThread::flushWrite(int fd, WriteBuffer& wb)
+ssize_t ConnectionHandle::read(void* buf, size_t len)
 {
-    // Swap incoming queue into drain buffer if drain is empty
-    if (wb.m_drain.empty() && !wb.m_queue.empty()) {
-        wb.m_drain.swap(wb.m_queue);
-        wb.m_offset = 0;
+    if (!m_tls)
+        return ::recv(m_fd, buf, len, 0);
+
+    if (!m_tls->m_ready.load(std::memory_order_acquire)) {
+        errno = EAGAIN;
+        return -1;
     }
 
-    if (wb.m_drain.empty())
-        return;
+    std::lock_guard connLock(m_tls->m_mutex);
 
-    if (m_network.hasTLS(fd)) {
-        // TLS: write each message individually via SSL_write
-        while (!wb.m_drain.empty()) {
-            auto& entry = wb.m_drain.front();
-            const ssize_t ret = m_network.writeConnection(fd, entry.m_msg.data() + wb.m_offset, entry.m_msg.size() - wb.m_offset);
-            if (ret <= 0) {
-                if (errno == EAGAIN || errno == EWOULDBLOCK)
-                    return;
-                LOG_ERROR("TLS write failed during flush on fd=" << fd << ": " << strerror(errno));
-                wb.m_drain.clear();
-                wb.m_queue.clear();
-                return;
-            }
-            wb.m_offset += ret;
-            if (wb.m_offset >= entry.m_msg.size()) {
-                if (entry.m_callback)
-                    entry.m_callback();
-                wb.m_drain.pop_front();
-                wb.m_offset = 0;
-            } else {
-                return;  // partial write, wait for next EPOLLOUT
-            }
-        }
-    } else {
-        // Non-TLS: vectorized send with writev()
-        const int count = static_cast<int>(std::min(wb.m_drain.size(), static_cast<size_t>(MAX_WRITE_IOVECS)));
-        struct iovec iovs[MAX_WRITE_IOVECS];
+    const int ret = SSL_read(m_tls->m_ssl, buf, static_cast<int>(len));
+    if (ret > 0)
+        return ret;
 
-        for (int i = 0; i < count; ++i) {
-            auto& entry = wb.m_drain[i];
-            if (i == 0) {
-                iovs[i].iov_base = const_cast<char*>(entry.m_msg.data()) + wb.m_offset;
-                iovs[i].iov_len = entry.m_msg.size() - wb.m_offset;
-            } else {
-                iovs[i].iov_base = const_cast<char*>(entry.m_msg.data());
-                iovs[i].iov_len = entry.m_msg.size();
-            }
-        }
+    const int sslErr = SSL_get_error(m_tls->m_ssl, ret);
+    if (sslErr == SSL_ERROR_WANT_READ || sslErr == SSL_ERROR_WANT_WRITE) {
+        errno = EAGAIN;
+        return -1;
+    }
+    if (sslErr == SSL_ERROR_ZERO_RETURN)
+        return 0;
 
-        const ssize_t ret = ::writev(fd, iovs, count);
-        if (ret <= 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK)
-                return;
-            LOG_ERROR("writev failed on fd=" << fd << ": " << strerror(errno));
-            wb.m_drain.clear();
-            wb.m_queue.clear();
-            return;
-        }
+    LOG_ERROR("TLS read failed on fd=" << m_fd << ": " << get_ssl_error());
+    return 0;
+}
 
-        // Account for sent bytes, fire callbacks for completed messages
-        size_t sent = static_cast<size_t>(ret);
-        while (!wb.m_drain.empty() && sent > 0) {
-            auto& entry = wb.m_drain.front();
-            const size_t remaining = entry.m_msg.size() - wb.m_offset;
-            if (sent >= remaining) {
-                sent -= remaining;
-                if (entry.m_callback)
-                    entry.m_callback();
-                wb.m_drain.pop_front();
-                wb.m_offset = 0;
-            } else {
-                wb.m_offset += sent;
-                sent = 0;
-            }
-        }
+ssize_t ConnectionHandle::write(const void* buf, size_t len)
+{
+    if (!m_tls)
+        return ::send(m_fd, buf, len, MSG_NOSIGNAL);
+
+    if (!m_tls->m_ready.load(std::memory_order_acquire)) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    std::lock_guard connLock(m_tls->m_mutex);
+
+    const int ret = SSL_write(m_tls->m_ssl, buf, static_cast<int>(len));
+    if (ret > 0)
+        return ret;
+
+    const int sslErr = SSL_get_error(m_tls->m_ssl, ret);
+    if (sslErr == SSL_ERROR_WANT_READ || sslErr == SSL_ERROR_WANT_WRITE) {
+        errno = EAGAIN;
+        return -1;
     }
+
+    LOG_ERROR("TLS write failed on fd=" << m_fd << ": " << get_ssl_error());
+    errno = ECONNRESET;
+    return -1;
 }
 
-////////////////////////////////////////////
-//            ConnectionHandle            //
-////////////////////////////////////////////
+bool ConnectionHandle::hasBufferedReads()
+{
+    if (!m_tls)
+        return false;
 
-void ConnectionHandle::disconnect()
+    std::lock_guard connLock(m_tls->m_mutex);
+    return SSL_has_pending(m_tls->m_ssl);
+}
+
+void ConnectionHandle::release()
 {
-    m_readerThread.disconnect(m_fd);
+    // off the ready list, as the fd may be reused once it's closed
+    m_readReady = false;
+    ::close(m_fd);
+    m_handler.reset();
+    m_acceptor.reset();
 }
 
 bool ConnectionHandle::trySendInline(MsgPacket& msg)
 {
     // For non-TLS: try non-blocking inline send from the caller's thread.
     // For TLS: always queue to reader (SSL objects aren't safe for concurrent read+write).
-    if (!m_tls) {
-        if (m_readerThread.trySend(m_fd, msg))
-            return true;
+    // Only inline send when nothing is queued — preserves message ordering.
+    if (m_tls || m_pending.load(std::memory_order_acquire) != 0 || !acquireWrites())
+        return false;
+
+    if (m_pending.load(std::memory_order_acquire) != 0) {
+        releaseWrites();
+        return false;
     }
+
+    const ssize_t ret = write(msg.m_msg.c_str(), msg.m_msg.size());
+    releaseWrites();
+
+    // a flush skipped while we held the token is ours to hand back to the reader
+    if (m_pending.load(std::memory_order_acquire) != 0)
+        schedule();
+
+    if (ret == static_cast<ssize_t>(msg.m_msg.size()))
+        return true;
+
+    // partial send — trim what was sent so the caller queues only the remainder
+    if (ret > 0)
+        msg.m_msg.erase(0, ret);
+
     return false;
 }
 
@@ -1307,19 +2404,195 @@ void ConnectionHandle::send(MsgPacket&& msg)
     }
 
     // fall back to reader's write queue
-    m_readerThread.queueWrite(m_fd, std::move(msg));
+    queueWrite(std::move(msg));
 }
 
 void ConnectionHandle::queueWrite(MsgPacket&& msg)
 {
-    m_readerThread.queueWrite(m_fd, std::move(msg));
+    // counted before it's queued, so an inline send can't overtake it
+    m_pending.fetch_add(1, std::memory_order_acq_rel);
+    m_queue.push({std::move(msg.m_msg), std::move(msg.m_callback)});
+
+    // wake reader to flush
+    schedule();
 }
 
-bool ConnectionHandle::isReady() const
+void ConnectionHandle::queueWrites(std::vector<MsgPacket>&& msgs)
+{
+    m_pending.fetch_add(msgs.size(), std::memory_order_acq_rel);
+    for (auto& msg : msgs)
+        m_queue.push({std::move(msg.m_msg), std::move(msg.m_callback)});
+
+    // one wakeup for the whole batch
+    schedule();
+}
+
+void ConnectionHandle::requestUpdate()
+{
+    // a plain load first: the rest of a burst of sends finds it set and moves on
+    if (m_updateRequested.load(std::memory_order_acquire) || m_updateRequested.exchange(true, std::memory_order_acq_rel))
+        return;
+    m_readerThread.load(std::memory_order_acquire)->requestUpdate(shared_from_this());
+}
+
+void ConnectionHandle::schedule()
+{
+    if (!m_scheduled.exchange(true, std::memory_order_acq_rel))
+        m_readerThread.load(std::memory_order_acquire)->scheduleFlush(shared_from_this());
+}
+
+bool ConnectionHandle::hasPendingWrites() const
+{
+    return m_pending.load(std::memory_order_acquire) != 0;
+}
+
+void ConnectionHandle::shutdownWrites()
+{
+    for (int spins = 0; !acquireWrites(); ++spins) {
+        if (spins >= 64)
+            std::this_thread::yield();
+    }
+
+    // the token is never given back, so the queue is ours from here on
+    dropWrites();
+}
+
+void ConnectionHandle::flush(std::vector<SendCallback_T>& completed)
+{
+    if (!hasPendingWrites() || !acquireWrites())
+        return;
+
+    if (m_tls)
+        flushTLS(completed);
+    else
+        flushPlain(completed);
+
+    releaseWrites();
+}
+
+void ConnectionHandle::completeEntry(std::vector<SendCallback_T>& completed)
+{
+    auto& entry = m_drain.front();
+    if (entry.m_callback)
+        completed.push_back(std::move(entry.m_callback));
+    m_drain.pop_front();
+    m_offset = 0;
+    m_pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void ConnectionHandle::dropWrites()
+{
+    WriteEntry entry;
+    uint64_t position;
+    while (m_queue.pop(entry, position))
+        m_drain.push_back(std::move(entry));
+
+    m_pending.fetch_sub(m_drain.size(), std::memory_order_acq_rel);
+    m_drain.clear();
+    m_offset = 0;
+    m_staging.clear();
+    m_stagedOffset = 0;
+}
+
+void ConnectionHandle::completeSent(size_t sent, std::vector<SendCallback_T>& completed)
+{
+    while (!m_drain.empty() && sent > 0) {
+        const size_t remaining = m_drain.front().m_msg.size() - m_offset;
+        if (sent >= remaining) {
+            sent -= remaining;
+            completeEntry(completed);
+        } else {
+            m_offset += sent;
+            sent = 0;
+        }
+    }
+}
+
+void ConnectionHandle::flushTLS(std::vector<SendCallback_T>& completed)
+{
+    // TLS: queued messages are copied into one buffer of up to a record's
+    // worth, so a burst costs an SSL_write, record and AEAD seal per 16 KiB
+    // rather than per message. Loops until drained or the socket would block,
+    // like writev() below.
+    WriteEntry next;
+    uint64_t position;
+    while (true) {
+        if (m_staging.empty()) {
+            // what's left of the front entry, then whole messages while they fit
+            for (size_t i = 0;; ++i) {
+                if (i == m_drain.size()) {
+                    if (!m_queue.pop(next, position))
+                        break;
+                    m_drain.push_back(std::move(next));
+                }
+                const auto& msg = m_drain[i].m_msg;
+                const size_t offset = i == 0 ? m_offset : 0;
+                if (!m_staging.empty() && m_staging.size() + msg.size() - offset > MAX_TLS_RECORD_SIZE)
+                    break;
+                m_staging.append(msg, offset);
+                if (m_staging.size() >= MAX_TLS_RECORD_SIZE)
+                    break;
+            }
+            if (m_staging.empty())
+                return;
+        }
+
+        const ssize_t ret = write(m_staging.data() + m_stagedOffset, m_staging.size() - m_stagedOffset);
+        if (ret <= 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+            LOG_ERROR("TLS write failed during flush on fd=" << m_fd << ": " << strerror(errno));
+            dropWrites();
+            return;
+        }
+
+        m_stagedOffset += ret;
+        if (m_stagedOffset == m_staging.size()) {
+            m_staging.clear();
+            m_stagedOffset = 0;
+        }
+        completeSent(static_cast<size_t>(ret), completed);
+    }
+}
+
+void ConnectionHandle::flushPlain(std::vector<SendCallback_T>& completed)
 {
-    return m_network.isConnectionReady(m_fd);
+    // Non-TLS: vectorized send with writev(), looping until drained or the socket
+    // would block. EPOLLOUT is edge-triggered, so stopping early while the socket
+    // is still writable would strand the rest of a large batch.
+    WriteEntry next;
+    uint64_t position;
+    while (true) {
+        while (m_drain.size() < MAX_WRITE_IOVECS && m_queue.pop(next, position))
+            m_drain.push_back(std::move(next));
+        if (m_drain.empty())
+            return;
+
+        const int count = static_cast<int>(std::min(m_drain.size(), static_cast<size_t>(MAX_WRITE_IOVECS)));
+        struct iovec iovs[MAX_WRITE_IOVECS];
+
+        for (int i = 0; i < count; ++i) {
+            auto& entry = m_drain[i];
+            const size_t offset = i == 0 ? m_offset : 0;
+            iovs[i].iov_base = const_cast<char*>(entry.m_msg.data()) + offset;
+            iovs[i].iov_len = entry.m_msg.size() - offset;
+        }
+
+        const ssize_t ret = ::writev(m_fd, iovs, count);
+        if (ret <= 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+            LOG_ERROR("writev failed on fd=" << m_fd << ": " << strerror(errno));
+            dropWrites();
+            return;
+        }
+
+        // Account for sent bytes, fire callbacks for completed messages
+        completeSent(static_cast<size_t>(ret), completed);
+    }
 }
 
+
 ////////////////////////////////////////////
 //             NetworkHandler             //
 ////////////////////////////////////////////
@@ -1364,6 +2637,16 @@ void NetworkHandler::setSocketSettings(int fd)
 {
     set_sock_opt(fd, IPPROTO_TCP, TCP_NODELAY, m_settings.getBool(SessionSettings::ENABLE_TCP_NODELAY));
     set_sock_opt(fd, IPPROTO_TCP, TCP_QUICKACK, m_settings.getBool(SessionSettings::ENABLE_TCP_QUICKACK));
+
+    // the kernel polls the device queue on reads instead of waiting for an interrupt
+    const int busyPollUs = static_cast<int>(PlatformSettings::getLong(PlatformSettings::SOCKET_BUSY_POLL_US));
+    if (busyPollUs > 0) {
+        if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &busyPollUs, sizeof(busyPollUs)) < 0)
+            LOG_WARN("Failed to set SO_BUSY_POLL (raising it past net.core.busy_read needs CAP_NET_ADMIN): " << strerror(errno));
+#ifdef SO_PREFER_BUSY_POLL
+        set_sock_opt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL);
+#endif
+    }
 }
 
 void NetworkHandler::processMessage(std::string msg)
@@ -1371,9 +2654,9 @@ void NetworkHandler::processMessage(std::string msg)
     m_delegate->onNetworkMessage(std::move(msg));
 }
 
-void NetworkHandler::update()
+long NetworkHandler::update()
 {
-    m_delegate->onNetworkUpdate();
+    return m_delegate->onNetworkUpdate();
 }
 
 void NetworkHandler::send(MsgPacket&& msg)
@@ -1400,24 +2683,56 @@ void NetworkHandler::send(MsgPacket&& msg)
                 callback = {};
                 m_connection->queueWrite(std::move(msg));
             }
+            // the session's sequence numbers want flushing to the store
+            m_connection->requestUpdate();
         }
     }
     if (callback)
         callback();
 }
 
-void NetworkHandler::disconnect()
+void NetworkHandler::send(std::vector<MsgPacket>&& msgs)
 {
+    // batches always go through the write queue so they reach the socket as
+    // vectored writes rather than one syscall per message
     std::lock_guard lock(m_mutex);
-    m_connected.store(false, std::memory_order_release);
     if (m_connection) {
         if (!m_valid.load(std::memory_order_acquire)) {
             m_connection = nullptr;
             return;
         }
-        m_connection->disconnect();
+        m_connection->queueWrites(std::move(msgs));
+        m_connection->requestUpdate();
+    }
+}
+
+bool NetworkHandler::hasPendingWrites()
+{
+    std::lock_guard lock(m_mutex);
+    return m_connection && m_valid.load(std::memory_order_acquire) && m_connection->hasPendingWrites();
+}
+
+void NetworkHandler::disconnect()
+{
+    std::shared_ptr<ConnectionHandle> connection;
+    {
+        std::lock_guard lock(m_mutex);
+        m_connected.store(false, std::memory_order_release);
+        if (m_connection && m_valid.load(std::memory_order_acquire))
+            connection = std::move(m_connection);
         m_connection = nullptr;
     }
+
+    // Outside m_mutex: the reader calls back into notifyDisconnected(), and
+    // the delegate may send (and so disconnect) again from there
+    if (connection)
+        connection->disconnect();
+    notifyDisconnected();
+}
+
+void NetworkHandler::notifyDisconnected()
+{
+    m_delegate->onNetworkDisconnect();
 }
 
 void NetworkHandler::setConnection(std::shared_ptr<ConnectionHandle> connection)
@@ -1,25 +1,35 @@
 #pragma once
 
+#include <openfix/IoUring.h>
 #include <openfix/Log.h>
+#include <openfix/MpscQueue.h>
+#include <openfix/TimerWheel.h>
 #include <openfix/Types.h>
+#include <openfix/Utils.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <deque>
 #include <memory>
 #include <mutex>
-#include <shared_mutex>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
+#include <sys/socket.h>
 #include <sys/types.h>
 
 #include "Config.h"
 
 #define READ_BUF_SIZE 8192
 #define MAX_WRITE_IOVECS 64
+// plaintext in one TLS record (SSL3_RT_MAX_PLAIN_LENGTH)
+#define MAX_TLS_RECORD_SIZE 16384
 
 class Network;
+class NetworkHandler;
 class ReaderThread;
+struct Acceptor;
 typedef struct ssl_ctx_st SSL_CTX;
 typedef struct ssl_st SSL;
 
@@ -34,36 +44,232 @@ struct NetworkDelegate
 {
     virtual ~NetworkDelegate() = default;
     virtual void onNetworkMessage(std::string text) = 0;
-    virtual void onNetworkUpdate() = 0;
+    // Returns when (epoch ms) the delegate next needs an update with no
+    // traffic to prompt one, or 0 if it has no deadline pending
+    virtual long onNetworkUpdate() = 0;
+    // The session's connection is gone, called from whichever thread dropped it
+    virtual void onNetworkDisconnect() = 0;
 };
 
-class ConnectionHandle
+struct WriteEntry
+{
+    std::string m_msg;
+    SendCallback_T m_callback;
+};
+
+// What an epoll registration's data.ptr (or an io_uring request's user_data)
+// points at, so events go straight to their socket's state without a lookup.
+// An entry unregistered by any thread is retired to its reader, which frees
+// it only between batches, once no event it's handling can still point at it
+// (and, on io_uring, once its requests have been cancelled).
+struct PollEntry
+{
+    enum class Type : uint8_t
+    {
+        ACCEPTOR,
+        CONNECTION
+    };
+
+    explicit PollEntry(Type type)
+        : m_type(type)
+    {}
+
+    virtual ~PollEntry() = default;
+
+    const Type m_type;
+};
+
+// TLS state of one connection; m_mutex serializes SSL calls between the
+// reader reading and whichever thread is writing
+struct TLSConnection
+{
+    ~TLSConnection();
+
+    std::shared_ptr<SSL_CTX> m_ctx;
+    SSL* m_ssl = nullptr;
+    bool m_serverMode = false;
+    std::atomic<bool> m_ready = false;
+    std::mutex m_mutex;
+};
+
+// Everything about one socket: the session it belongs to (or the acceptor it
+// came in on, until its first message says which session that is), its TLS
+// state, inbound bytes not yet parsed and outbound messages not yet written.
+//
+// Any thread may queue writes; whoever holds the write token (m_writing) is
+// the only one writing to the socket, so inline sends and the reader's
+// flushes on different connections share no lock.
+class ConnectionHandle : public PollEntry, public std::enable_shared_from_this<ConnectionHandle>
 {
 public:
-    ConnectionHandle(Network& network, ReaderThread& readerThread, int fd, bool tls)
-        : m_fd(fd)
-        , m_tls(tls)
-        , m_network(network)
-        , m_readerThread(readerThread)
+    ConnectionHandle(ReaderThread& readerThread, int fd, std::shared_ptr<TLSConnection> tls)
+        : PollEntry(Type::CONNECTION)
+        , m_fd(fd)
+        , m_tls(std::move(tls))
+        , m_readerThread(&readerThread)
     {}
 
     void send(MsgPacket&& msg);
     bool trySendInline(MsgPacket& msg);
     void queueWrite(MsgPacket&& msg);
+    void queueWrites(std::vector<MsgPacket>&& msgs);
+    bool hasPendingWrites() const;
     void disconnect();
+
+    // false until the TLS handshake, if any, is done
     bool isReady() const;
+    bool requiresProgress() const;
+    // moves the TLS handshake along; false if it failed
+    bool progress();
+
+    // recv/send, through TLS if enabled; EAGAIN while the handshake is underway
+    ssize_t read(void* buf, size_t len);
+    ssize_t write(const void* buf, size_t len);
+    // bytes TLS has taken off the socket and not yet handed to read(), which
+    // no readiness event would report
+    bool hasBufferedReads();
+
+    // Reader thread only: writes what's queued until it's all out or the
+    // socket would block, collecting callbacks of messages fully written.
+    // Does nothing while another thread is sending inline.
+    void flush(std::vector<SendCallback_T>& completed);
+
+    // Reader thread only: takes the connection off the reader's dirty list,
+    // so the next write queued puts it back on
+    void unschedule()
+    {
+        // an exchange, to see everything queued by whoever found it still set
+        m_scheduled.exchange(false, std::memory_order_acq_rel);
+    }
+
+    // Has the reader update the connection's session the next time it wakes,
+    // without waking it: sends made off the reader leave state to flush
+    void requestUpdate();
+
+    // Takes the write token for good, waiting out a write in flight, so nothing
+    // writes to the fd once it's closed (and possibly reused). Queued writes are dropped.
+    void shutdownWrites();
 
     size_t getFD()
     {
         return m_fd;
     }
 
+    // Reader thread (or under its m_mutex) only, bar the handler set before
+    // the fd is registered
+    NetworkHandler* getHandler() const
+    {
+        return m_handler.get();
+    }
+
+    void setHandler(std::shared_ptr<NetworkHandler> handler)
+    {
+        m_handler = std::move(handler);
+        m_acceptor.reset();
+    }
+
+    const std::shared_ptr<Acceptor>& getAcceptor() const
+    {
+        return m_acceptor;
+    }
+
+    void setAcceptor(std::shared_ptr<Acceptor> acceptor)
+    {
+        m_acceptor = std::move(acceptor);
+    }
+
+    // Reader thread only: bytes read and not yet parsed into messages
+    std::string& getReadBuffer()
+    {
+        return m_readBuffer;
+    }
+
+    // Reader thread only, once retired: closes the fd and lets go of the
+    // handler, which holds this in turn
+    void release();
+
 private:
+    bool acquireWrites()
+    {
+        return !m_writing.exchange(true, std::memory_order_acquire);
+    }
+
+    void releaseWrites()
+    {
+        m_writing.store(false, std::memory_order_release);
+    }
+
+    // puts the connection on the reader's dirty list unless it's there already
+    void schedule();
+
+    void flushTLS(std::vector<SendCallback_T>& completed);
+    void flushPlain(std::vector<SendCallback_T>& completed);
+    void completeEntry(std::vector<SendCallback_T>& completed);
+    // completes the entries sent bytes from the front of m_drain cover
+    void completeSent(size_t sent, std::vector<SendCallback_T>& completed);
+    void dropWrites();
+
     int m_fd;
-    bool m_tls;
+    std::shared_ptr<TLSConnection> m_tls;
+
+    // the reader the connection is registered with; changes only as that
+    // reader hands it to another, under both their m_mutexes
+    std::atomic<ReaderThread*> m_readerThread;
+    // Reader thread only, io_uring backend: where the connection goes once its
+    // requests on this reader's ring have completed
+    ReaderThread* m_migrateTo = nullptr;
+
+    // added to by its reader while it's measuring load, taken by the
+    // rebalancer each window: time spent on the connection, messages read
+    std::atomic<int64_t> m_loadMicros{0};
+    std::atomic<uint64_t> m_loadMessages{0};
+
+    std::shared_ptr<NetworkHandler> m_handler;
+    std::shared_ptr<Acceptor> m_acceptor;
+    std::string m_readBuffer;
+
+    // queued by any thread, drained in order by the token holder
+    MpscQueue<WriteEntry> m_queue;
+    // messages taken off m_queue and not yet fully written; token holder only
+    std::deque<WriteEntry> m_drain;
+    size_t m_offset = 0;  // byte offset into first entry for partial sends
+    // TLS: the front of m_drain copied out for one SSL_write, up to a record's
+    // worth, and how much of it is written. Left as is until it's all out, as
+    // a write SSL couldn't finish must be retried with the same bytes.
+    std::string m_staging;
+    size_t m_stagedOffset = 0;
+
+    // messages queued and not yet fully written
+    std::atomic<size_t> m_pending{0};
+    alignas(64) std::atomic<bool> m_writing{false};
+    // on the reader's dirty list, waiting for a flush
+    std::atomic<bool> m_scheduled{false};
+
+    // on the reader's update requests, waiting for it to wake
+    std::atomic<bool> m_updateRequested{false};
+    // reader thread only: listed for an update at the end of the batch, and
+    // the earliest deadline it has on the reader's timer wheel
+    bool m_updateDue = false;
+    int64_t m_nextUpdate = TimerWheel<int>::NONE;
+    // reader thread only: out of read budget and listed for another turn
+    bool m_readReady = false;
+
+    // Reader thread only, io_uring backend: writes taken off the queue and
+    // handed to the kernel in one sendmsg. They stay counted in m_pending, so
+    // inline sends queue behind them, and are the kernel's until it completes.
+    struct RingSend
+    {
+        std::vector<WriteEntry> m_entries;
+        size_t m_offset = 0;
+        struct iovec m_iovs[MAX_WRITE_IOVECS];
+        struct msghdr m_msg;
+        bool m_inFlight = false;
+    };
+    std::unique_ptr<RingSend> m_ringSend;
 
-    Network& m_network;
-    ReaderThread& m_readerThread;
+    CREATE_LOGGER("ConnectionHandle");
+
+    friend class ReaderThread;
 };
 
 class NetworkHandler : public std::enable_shared_from_this<NetworkHandler>
@@ -85,10 +291,17 @@ public:
     void setSocketSettings(int fd);
 
     void processMessage(std::string msg);
-    void update();
+    // returns the delegate's next deadline (epoch ms), or 0 if it has none
+    long update();
     void send(MsgPacket&& msg);
+    void send(std::vector<MsgPacket>&& msgs);
+
+    // true while queued data is still waiting on the socket to become writable
+    bool hasPendingWrites();
 
     void disconnect();
+    // tells the delegate its connection is gone; called with no network locks held
+    void notifyDisconnected();
     void setConnection(std::shared_ptr<ConnectionHandle> connection);
 
     bool isConnected()
@@ -118,92 +331,143 @@ private:
     CREATE_LOGGER("Network");
 };
 
-struct Acceptor
+struct Acceptor : PollEntry
 {
+    explicit Acceptor(int fd)
+        : PollEntry(Type::ACCEPTOR)
+        , m_fd(fd)
+    {}
+
+    const int m_fd;
     // sessionID -> session network handler
     HashMapT<SessionID_T, std::shared_ptr<NetworkHandler>> m_sessions;
+    // set under the reader's m_mutex once the listening socket is unregistered,
+    // before it's closed
+    bool m_closed = false;
+    // io_uring backend: how long a failed accept waits to be re-armed, doubled
+    // for each failure in a row; reader thread only
+    int64_t m_acceptBackoffMs = 0;
 };
 
 class ReadBuffer
 {
 public:
-    ReadBuffer(Network& network)
-        : m_network(network)
-    {}
-
-    // Returns a reference to parsed messages. The returned reference is valid
-    // until the next call to read(). Avoids per-call vector allocation.
-    std::vector<std::string>& read(int fd);
-
-    void clear(int fd)
+    // Reads what the connection has, or until maxBytes or maxMessages (0 = no
+    // limit) have been read, and returns a reference to the messages parsed.
+    // Never more than maxMessages: complete messages past it wait in the
+    // connection's buffer for the next call.
+    // The returned reference is valid until the next call to read().
+    // Avoids per-call vector allocation.
+    std::vector<std::string>& read(ConnectionHandle& connection, size_t maxBytes = 0, size_t maxMessages = 0);
+
+    // whether the last read() stopped at its budget, maybe leaving data on the socket or in the buffer
+    bool exhausted() const
     {
-        m_bufferMap.erase(fd);
+        return m_exhausted;
     }
 
-    void clear()
-    {
-        m_bufferMap.clear();
-    }
+    // Same, for bytes already received for the connection (by io_uring)
+    std::vector<std::string>& parse(ConnectionHandle& connection, std::string_view data);
 
 private:
-    HashMapT<int, std::string> m_bufferMap;
+    // moves every complete message at the front of buffer to m_readResult, up
+    // to maxMessages in all (0 = no limit); returns whether it reached them
+    bool extract(std::string& buffer, size_t maxMessages = 0);
+
     std::vector<std::string> m_readResult;
-    Network& m_network;
+    bool m_exhausted = false;
 
     CREATE_LOGGER("ReadBuffer");
 };
 
-struct WriteEntry
+// A reader's place and load, for the admin site
+struct ReaderStats
 {
-    std::string m_msg;
-    SendCallback_T m_callback;
+    std::string m_name;
+    std::string m_pool;
+    bool m_busyPoll = false;
+    // sessions placed on the reader, and those connected through it
+    size_t m_placed = 0;
+    std::vector<SessionID_T> m_sessions;
+    size_t m_connections = 0;
+    uint64_t m_messages = 0;
+    uint64_t m_bytes = 0;
+    // share of its time since it started spent handling events, and of the
+    // last rebalancing window
+    double m_busy = 0;
+    double m_load = 0;
+    // connections handed to it and away from it
+    uint64_t m_movedIn = 0;
+    uint64_t m_movedOut = 0;
+    // eventfd writes made to wake it, and connections its flushes visited
+    uint64_t m_wakeups = 0;
+    uint64_t m_flushes = 0;
+    // polls that found nothing while busy polling, rather than sleeping
+    uint64_t m_spins = 0;
 };
 
-struct WriteBuffer
+// One connection's share of a rebalancing window
+struct ConnectionLoad
 {
-    WriteBuffer() = default;
-
-    WriteBuffer(WriteBuffer&& other) noexcept
-        : m_queue(std::move(other.m_queue))
-        , m_drain(std::move(other.m_drain))
-        , m_offset(other.m_offset)
-        , m_valid(other.m_valid.load(std::memory_order_relaxed))
-    {}
-
-    WriteBuffer& operator=(WriteBuffer&& other) noexcept
-    {
-        m_queue = std::move(other.m_queue);
-        m_drain = std::move(other.m_drain);
-        m_offset = other.m_offset;
-        m_valid.store(other.m_valid.load(std::memory_order_relaxed), std::memory_order_relaxed);
-        return *this;
-    }
-
-    std::deque<WriteEntry> m_queue;
-    std::deque<WriteEntry> m_drain;
-    size_t m_offset = 0;  // byte offset into first entry for partial sends
+    std::shared_ptr<ConnectionHandle> m_connection;
+    SessionID_T m_sessionID;
+    double m_load = 0;
+    double m_messageRate = 0;  // messages read per second
+    // placed by name or as critical, so never moved
+    bool m_pinned = false;
+};
 
-    std::atomic<bool> m_valid{true};
+struct ReaderLoad
+{
+    ReaderThread* m_reader = nullptr;
+    double m_load = 0;
+    std::vector<ConnectionLoad> m_connections;
 };
 
 class ReaderThread
 {
 public:
-    ReaderThread(Network& network);
+    ReaderThread(Network& network, std::string name, std::string pool, bool busyPoll);
     ~ReaderThread();
 
     void process();
-    void processRead(int fd);
 
-    void registerFD(int fd);
+    const std::string& getName() const
+    {
+        return m_name;
+    }
 
-    void queueWrite(int fd, MsgPacket&& msg);
-    bool trySend(int fd, MsgPacket& msg);
+    const std::string& getPool() const
+    {
+        return m_pool;
+    }
 
-    void disconnect(int fd);
+    // Hands the connection, with its registration, read buffer and write
+    // queue, to target once this reader is between batches. Does nothing if
+    // the connection is gone or isn't this reader's by then.
+    void migrate(std::shared_ptr<ConnectionHandle> connection, ReaderThread& target);
 
-    bool addConnection(const std::shared_ptr<NetworkHandler>& handler, int fd);
-    void accept(int fd, const std::shared_ptr<Acceptor>& acceptor);
+    ReaderStats getStats();
+
+    // Each session's and the reader's own load since the last call, which
+    // only the rebalancer makes
+    ReaderLoad sampleLoad(int64_t windowMicros);
+
+    // Queues the connection for the next flush. Wakes the reader unless a
+    // wakeup is already pending, so a burst of sends costs one eventfd write.
+    void scheduleFlush(std::shared_ptr<ConnectionHandle> handle);
+
+    // Has the connection's session updated the next time the reader wakes
+    void requestUpdate(std::shared_ptr<ConnectionHandle> handle);
+
+    // Unregisters the connection and stops its writes; the fd itself is closed
+    // once the connection is reclaimed. Does nothing if it's gone already.
+    void disconnect(ConnectionHandle& connection);
+
+    // register a connected socket, owned by handler or waiting to be associated
+    // with one of acceptor's sessions by its first message
+    bool addConnection(const std::shared_ptr<NetworkHandler>& handler, int fd, std::shared_ptr<TLSConnection> tls);
+    void accept(int fd, const std::shared_ptr<Acceptor>& acceptor, std::shared_ptr<TLSConnection> tls);
 
     bool hasAcceptor(const SessionID_T sessionID, int fd);
     void addAcceptor(const std::shared_ptr<NetworkHandler>& handler, const SessionID_T sessionID, int fd);
@@ -217,8 +481,102 @@ public:
     }
 
 private:
+    void registerFD(int fd, const std::shared_ptr<PollEntry>& entry);
+    // stops an acceptor's socket listening, if it's on the ring
+    void unregisterAcceptor(int fd);
+
+    void processEpoll();
+    void processEvents(ConnectionHandle& connection, uint32_t mask);
+    void processRead(ConnectionHandle& connection);
+    // gives each connection left out of read budget its next turn
+    void processReady();
+    void processMessages(ConnectionHandle& connection, std::vector<std::string>& msgs);
+    void processAccept(Acceptor& acceptor);
+    void processAccepted(Acceptor& acceptor, int fd);
+
+    // io_uring backend: multishot accept and recv (poll, for TLS, whose reads
+    // go through SSL) armed per socket, and writes submitted as sendmsg
+    // requests, all reaching the kernel in one io_uring_enter per iteration
+    bool initRing();
+    void processRing();
+    void armPending();
+    void arm(const std::shared_ptr<PollEntry>& entry);
+    void armWake();
+    // owner may be null when re-arming an entry with a request in flight
+    void armRecv(ConnectionHandle& connection, std::shared_ptr<PollEntry> owner);
+    void armPoll(ConnectionHandle& connection, std::shared_ptr<PollEntry> owner);
+    void armAccept(Acceptor& acceptor, std::shared_ptr<PollEntry> owner);
+    // re-arms a multishot request the kernel ended, if its socket is still registered
+    void rearm(PollEntry& entry, uint64_t op);
+    void submitSend(ConnectionHandle& connection);
+    void cancelRing(PollEntry& entry);
+    void drainRing();
+    void handleCompletion(const io_uring_cqe& cqe);
+    void handleRecv(ConnectionHandle& connection, const io_uring_cqe& cqe);
+    void handleAccept(Acceptor& acceptor, int res);
+    void handleSend(ConnectionHandle& connection, int res);
+    io_uring_sqe* ringSqe(uint64_t userData);
+    // counts a request in flight for entry, which is kept alive until the last completes
+    void holdRing(PollEntry& entry, std::shared_ptr<PollEntry> owner);
+    void releaseRing(PollEntry& entry);
+    bool isCancelled(PollEntry& entry) const;
+
     void flushWrites();
-    void flushWrite(int fd, WriteBuffer& wb);
+    void runCompletedCallbacks();
+    void wake();
+
+    void countRead(ConnectionHandle& connection, size_t messages, size_t bytes)
+    {
+        m_messages.fetch_add(messages, std::memory_order_relaxed);
+        m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        if (m_measureLoad)
+            connection.m_loadMessages.fetch_add(messages, std::memory_order_relaxed);
+    }
+
+    // charges the connection with the time since the last charge, when measuring load
+    void chargeLoad(ConnectionHandle& connection)
+    {
+        if (!m_measureLoad)
+            return;
+        const int64_t now = Utils::getEpochMicros();
+        connection.m_loadMicros.fetch_add(now - m_loadMark, std::memory_order_relaxed);
+        m_loadMark = now;
+    }
+
+    // Reader thread only: updates the connection's session at the end of
+    // this batch, after it read messages or drained writes
+    void markForUpdate(ConnectionHandle& connection);
+    // updates sessions with activity, requests or deadlines due, and puts
+    // each one's next deadline on the timer wheel
+    void updateSessions();
+    // how long epoll_wait may sleep before the nearest deadline
+    int nextTimeout(long maxTimeout) const;
+
+    // hands an unregistered entry to reclaim() and wakes the reader to get to it
+    void retire(std::shared_ptr<PollEntry> entry);
+    void reclaim();
+
+    bool owns(const ConnectionHandle& connection) const
+    {
+        return connection.m_readerThread.load(std::memory_order_acquire) == this;
+    }
+
+    // runs the migrations asked for, between batches, once nothing about
+    // their connections is left on this reader's update list
+    void processMigrations();
+    // io_uring backend: cancels the connection's receive ahead of its hand-off
+    void startMigration(ConnectionHandle& connection);
+    void handOff(ConnectionHandle& connection, ReaderThread& target);
+
+    const std::string m_name;
+    const std::string m_pool;
+    const bool m_busyPoll;
+    // per-connection load is only measured for the rebalancer
+    const bool m_measureLoad;
+    int64_t m_loadMark = 0;
+    // most read from one connection per turn (0 = no limit)
+    const size_t m_readBudgetBytes;
+    const size_t m_readBudgetMessages;
 
     std::atomic<bool> m_running;
     std::recursive_mutex m_mutex;
@@ -227,18 +585,82 @@ private:
     int m_epollFD;
     int m_eventFD;
 
-    // write buffers: fd -> buffer (m_writeMutex protects m_queue insertion)
-    std::mutex m_writeMutex;
-    HashMapT<int, WriteBuffer> m_writeBuffers;
+    // connections with writes queued since their last flush, each listed once
+    MpscQueue<std::shared_ptr<ConnectionHandle>> m_dirty;
+    // set from the first eventfd write until the reader picks it up
+    std::atomic<bool> m_wakeupPending{false};
+
+    // sessions waiting for an update, asked for from any thread, due this batch
+    // and being updated; only those due or active are ever visited
+    MpscQueue<std::shared_ptr<ConnectionHandle>> m_updateRequests;
+    std::vector<std::shared_ptr<ConnectionHandle>> m_updateDue;
+    std::vector<std::shared_ptr<ConnectionHandle>> m_updating;
+    // session deadlines (heartbeats, test requests, logon and logout timeouts),
+    // and on io_uring, failed accepts waiting out their backoff
+    TimerWheel<std::shared_ptr<PollEntry>> m_timers;
+
+    // send callbacks for fully written messages, deferred until the flush is done
+    std::vector<SendCallback_T> m_completedCallbacks;
 
     ReadBuffer m_buffer;
+    // connections that ran out of read budget with data maybe left on the
+    // socket: edge-triggered epoll won't report it again, so each is read
+    // again next iteration, once the others have had their turn
+    std::vector<std::shared_ptr<ConnectionHandle>> m_ready;
+    std::vector<std::shared_ptr<ConnectionHandle>> m_readying;
+
+    enum class Backend : uint8_t
+    {
+        EPOLL,
+        IO_URING
+    };
+    Backend m_backend = Backend::EPOLL;
+
+    IoUring m_ring;
+    IoUringBufferRing m_ringBuffers;
+    // entries registered off the reader, armed on its ring once it wakes
+    MpscQueue<std::shared_ptr<PollEntry>> m_arming;
+    struct RingEntry
+    {
+        std::shared_ptr<PollEntry> m_entry;
+        int m_requests = 0;
+        bool m_cancelled = false;
+    };
+    // entries with requests in flight on the ring
+    HashMapT<PollEntry*, RingEntry> m_ringEntries;
+    bool m_wakeArmed = false;
+
+    struct Migration
+    {
+        std::shared_ptr<ConnectionHandle> m_connection;
+        ReaderThread* m_target = nullptr;
+    };
+    MpscQueue<Migration> m_migrations;
+    // io_uring backend: migrating connections with nothing left on the ring
+    std::vector<std::shared_ptr<ConnectionHandle>> m_handOffs;
+
+    // written by the reader only, bar m_wakeups which whoever wakes it counts;
+    // read by anyone for its stats
+    std::atomic<uint64_t> m_messages{0};
+    std::atomic<uint64_t> m_bytes{0};
+    std::atomic<int64_t> m_busyMicros{0};
+    const int64_t m_startedMicros;
+    std::atomic<uint64_t> m_movedIn{0};
+    std::atomic<uint64_t> m_movedOut{0};
+    std::atomic<uint64_t> m_wakeups{0};
+    std::atomic<uint64_t> m_flushes{0};
+    std::atomic<uint64_t> m_spins{0};
+    // rebalancer only, bar m_load: its busy time at the last sample, and its
+    // share of the window up to it
+    int64_t m_sampledBusyMicros = 0;
+    std::atomic<double> m_load{0};
 
     // fd -> acceptor
     HashMapT<int, std::shared_ptr<Acceptor>> m_acceptorSockets;
-    // fd -> unassigned connection from acceptor socket
-    HashMapT<int, std::shared_ptr<Acceptor>> m_unknownConnections;
-    // fd -> assigned connection
-    HashMapT<int, std::shared_ptr<NetworkHandler>> m_connections;
+    // fd -> connection, assigned to a session or not yet
+    HashMapT<int, std::shared_ptr<ConnectionHandle>> m_connections;
+    // entries unregistered since the last reclaim()
+    MpscQueue<std::shared_ptr<PollEntry>> m_retired;
 
     Network& m_network;
 
@@ -253,32 +675,36 @@ public:
     void start();
     void stop();
 
+    // Takes note of where the session's connections go. Critical sessions
+    // registered once the network is running get no reader of their own.
+    void registerSession(const SessionSettings& settings);
+
     bool connect(const SessionSettings& settings, const std::shared_ptr<NetworkHandler>& handler);
 
     bool hasAcceptor(const SessionSettings& settings);
     bool addAcceptor(const SessionSettings& settings, const std::shared_ptr<NetworkHandler>& handler);
     bool removeAcceptor(const SessionSettings& settings);
 
-    bool progressConnection(int fd);
-    bool isConnectionReady(int fd) const;
-    bool requiresConnectionProgress(int fd) const;
-    bool hasTLS(int fd) const;
-    ssize_t readConnection(int fd, void* buf, size_t len);
-    ssize_t writeConnection(int fd, const void* buf, size_t len);
-    void removeConnection(int fd);
-
-private:
-    struct TLSConnection
+    std::vector<ReaderStats> getReaderStats();
+    // connections moved by rebalancing
+    uint64_t getRebalanceCount() const
     {
-        std::shared_ptr<SSL_CTX> m_ctx;
-        SSL* m_ssl = nullptr;
-        bool m_serverMode = false;
-        std::atomic<bool> m_ready = false;
-        std::mutex m_mutex;
-    };
+        return m_rebalances.load(std::memory_order_relaxed);
+    }
+    // name of the reader the session is placed on, empty if it isn't placed
+    std::string getPlacement(const SessionID_T& sessionID);
 
+private:
+    // the session's reader, or null to spread it over the default pool
+    ReaderThread* getPlacedReader(const SessionID_T& sessionID);
+    ReaderThread* place(const SessionSettings& settings);
+    void createPools();
+    // moves a connection off the busiest reader of each pool that's out of balance
+    void rebalance(int64_t windowMicros);
     bool accept(int server_fd, const std::shared_ptr<Acceptor>& acceptor);
-    bool createTLSConnection(int fd, const SessionSettings& settings, bool serverMode, const std::string& serverName);
+    // sets up a socket accepted on acceptor and hands it to its reader
+    bool adopt(int fd, const std::shared_ptr<Acceptor>& acceptor);
+    std::shared_ptr<TLSConnection> createTLSConnection(int fd, const SessionSettings& settings, bool serverMode, const std::string& serverName);
     std::shared_ptr<SSL_CTX> getTLSContext(const SessionSettings& settings, bool serverMode);
     std::shared_ptr<SSL_CTX> createTLSContext(const SessionSettings& settings, bool serverMode) const;
     std::string getTLSContextKey(const SessionSettings& settings, bool serverMode) const;
@@ -286,19 +712,27 @@ private:
     // acceptor port -> fd
     std::mutex m_mutex;
     HashMapT<int, int> m_acceptors;
-    mutable std::shared_mutex m_tlsMutex;
-    HashMapT<int, std::shared_ptr<TLSConnection>> m_tlsConnections;
     std::mutex m_tlsContextsMutex;
     HashMapT<std::string, std::shared_ptr<SSL_CTX>> m_tlsContexts;
-    std::atomic<bool> m_hasTLSConnections = false;
 
+    // the default pool's readers come first, indexed by fd for acceptors and
+    // unplaced sessions, then those of ReaderPools and critical sessions
     size_t m_readerThreadCount;
     std::vector<std::unique_ptr<ReaderThread>> m_readerThreads;
 
+    std::mutex m_placementsMutex;
+    std::vector<SessionSettings> m_sessions;
+    HashMapT<std::string, std::vector<ReaderThread*>> m_pools;
+    HashMapT<SessionID_T, ReaderThread*> m_placements;
+
+    std::thread m_rebalanceThread;
+    std::mutex m_rebalanceMutex;
+    std::condition_variable m_rebalanceCV;
+    std::atomic<uint64_t> m_rebalances{0};
+
     std::atomic<bool> m_running;
 
     CREATE_LOGGER("Network");
 
     friend class ReaderThread;
-    friend class ConnectionHandle;
 };
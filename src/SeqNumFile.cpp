@@ -0,0 +1,194 @@
+#include "SeqNumFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+
+#include "Exception.h"
+
+namespace {
+
+constexpr uint32_t SEQNUM_FILE_MAGIC = 0x5153464F;  // "OFSQ"
+constexpr uint32_t SEQNUM_FILE_VERSION = 1;
+constexpr size_t SEQNUM_FILE_SIZE = 4096;
+constexpr size_t COMP_ID_SIZE = 64;
+
+uint32_t slotChecksum(const SeqNumFile::Slot& slot)
+{
+    // FNV-1a over everything before the checksum field
+    const auto* data = reinterpret_cast<const unsigned char*>(&slot);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(SeqNumFile::Slot, m_checksum); ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool slotValid(const SeqNumFile::Slot& slot)
+{
+    return slot.m_generation != 0 && slot.m_checksum == slotChecksum(slot);
+}
+
+std::string_view compID(const char* field)
+{
+    return std::string_view(field, strnlen(field, COMP_ID_SIZE));
+}
+
+}  // namespace
+
+struct SeqNumFile::Page
+{
+    uint32_t m_magic;
+    uint32_t m_version;
+    char m_senderCompID[COMP_ID_SIZE];
+    char m_targetCompID[COMP_ID_SIZE];
+
+    // both slots share one cache line, away from the identity; a torn write is
+    // caught by the slot's checksum rather than kept off the other slot
+    alignas(64) Slot m_slots[2];
+};
+
+SeqNumFile::SeqNumFile(std::string path, std::string senderCompID, std::string targetCompID)
+    : m_path(std::move(path))
+    , m_senderCompID(std::move(senderCompID))
+    , m_targetCompID(std::move(targetCompID))
+{
+    // the page only holds the first 63 characters of each CompID
+    if (m_senderCompID.size() >= COMP_ID_SIZE)
+        m_senderCompID.resize(COMP_ID_SIZE - 1);
+    if (m_targetCompID.size() >= COMP_ID_SIZE)
+        m_targetCompID.resize(COMP_ID_SIZE - 1);
+
+    static_assert(sizeof(Page) <= SEQNUM_FILE_SIZE);
+    try {
+        map();
+    } catch (...) {
+        unmap();
+        throw;
+    }
+}
+
+SeqNumFile::~SeqNumFile()
+{
+    unmap();
+}
+
+void SeqNumFile::unmap()
+{
+    if (m_page)
+        munmap(m_page, SEQNUM_FILE_SIZE);
+    m_page = nullptr;
+
+    if (m_fd >= 0)
+        close(m_fd);
+    m_fd = -1;
+}
+
+void SeqNumFile::map()
+{
+    const auto parent = std::filesystem::path(m_path).parent_path();
+    if (!parent.empty())
+        std::filesystem::create_directories(parent);
+
+    m_fd = open(m_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (m_fd < 0)
+        throw FileStoreLoadError("Unable to open seqnum file " + m_path + ": " + std::strerror(errno));
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0)
+        throw FileStoreLoadError("Unable to stat seqnum file " + m_path + ": " + std::strerror(errno));
+
+    if (static_cast<size_t>(st.st_size) < SEQNUM_FILE_SIZE && ftruncate(m_fd, SEQNUM_FILE_SIZE) != 0)
+        throw FileStoreLoadError("Unable to size seqnum file " + m_path + ": " + std::strerror(errno));
+
+    void* addr = mmap(nullptr, SEQNUM_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (addr == MAP_FAILED)
+        throw FileStoreLoadError("Unable to map seqnum file " + m_path + ": " + std::strerror(errno));
+    m_page = static_cast<Page*>(addr);
+
+    if (m_page->m_magic == 0) {
+        // new file: stamp the identity, magic last
+        std::memcpy(m_page->m_senderCompID, m_senderCompID.data(), m_senderCompID.size());
+        std::memcpy(m_page->m_targetCompID, m_targetCompID.data(), m_targetCompID.size());
+        m_page->m_version = SEQNUM_FILE_VERSION;
+        m_page->m_magic = SEQNUM_FILE_MAGIC;
+        return;
+    }
+
+    if (m_page->m_magic != SEQNUM_FILE_MAGIC || m_page->m_version != SEQNUM_FILE_VERSION)
+        throw FileStoreLoadError("Seqnum file " + m_path + " has an unrecognized format");
+
+    if (compID(m_page->m_senderCompID) != m_senderCompID || compID(m_page->m_targetCompID) != m_targetCompID) {
+        throw FileStoreLoadError("Seqnum file " + m_path + " belongs to session " + std::string(compID(m_page->m_senderCompID)) + "-" +
+                                 std::string(compID(m_page->m_targetCompID)));
+    }
+
+    if (const Slot* slot = current()) {
+        m_generation = slot->m_generation;
+        m_incarnation = slot->m_incarnation;
+    }
+}
+
+const SeqNumFile::Slot* SeqNumFile::current() const
+{
+    const Slot& a = m_page->m_slots[0];
+    const Slot& b = m_page->m_slots[1];
+    const bool aValid = slotValid(a);
+    const bool bValid = slotValid(b);
+
+    if (aValid && bValid)
+        return a.m_generation > b.m_generation ? &a : &b;
+    if (aValid)
+        return &a;
+    if (bValid)
+        return &b;
+    return nullptr;
+}
+
+bool SeqNumFile::read(int& senderSeqNum, int& targetSeqNum) const
+{
+    const Slot* slot = current();
+    if (!slot)
+        return false;
+
+    senderSeqNum = slot->m_senderSeqNum;
+    targetSeqNum = slot->m_targetSeqNum;
+    return true;
+}
+
+void SeqNumFile::write(int senderSeqNum, int targetSeqNum)
+{
+    commit(senderSeqNum, targetSeqNum);
+}
+
+void SeqNumFile::sync() const
+{
+    if (m_page && ::msync(m_page, sizeof(Page), MS_SYNC) != 0)
+        LOG_ERROR("Failed to sync " << m_path << ": " << std::strerror(errno));
+}
+
+void SeqNumFile::reset()
+{
+    ++m_incarnation;
+    commit(1, 1);
+}
+
+void SeqNumFile::commit(int senderSeqNum, int targetSeqNum)
+{
+    Slot next{};
+    next.m_generation = ++m_generation;
+    next.m_incarnation = m_incarnation;
+    next.m_senderSeqNum = senderSeqNum;
+    next.m_targetSeqNum = targetSeqNum;
+    next.m_checksum = slotChecksum(next);
+
+    // generation parity picks the slot, so the current one is never overwritten
+    std::memcpy(&m_page->m_slots[next.m_generation & 1], &next, sizeof(next));
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <openfix/Log.h>
+
+#include <cstdint>
+#include <string>
+
+// Memory-mapped sequence number page for one session. The page holds the
+// session identity and two slots of {sender, target, incarnation}; a write
+// always goes to the slot that isn't current and carries its own checksum, so
+// a torn write leaves the previous slot intact. Persisting seqnums is a store
+// into the mapping and recovery reads a single page.
+class SeqNumFile
+{
+public:
+    struct Slot
+    {
+        uint64_t m_generation;
+        uint64_t m_incarnation;
+        int32_t m_senderSeqNum;
+        int32_t m_targetSeqNum;
+        uint32_t m_reserved;
+        uint32_t m_checksum;
+    };
+
+    SeqNumFile(std::string path, std::string senderCompID, std::string targetCompID);
+    ~SeqNumFile();
+
+    SeqNumFile(const SeqNumFile&) = delete;
+    SeqNumFile& operator=(const SeqNumFile&) = delete;
+
+    // false if no slot has ever been written (or both are damaged)
+    bool read(int& senderSeqNum, int& targetSeqNum) const;
+
+    void write(int senderSeqNum, int targetSeqNum);
+
+    // blocks until the page is on disk; writes otherwise reach it whenever the kernel flushes
+    void sync() const;
+
+    // starts a new incarnation with both seqnums back at 1
+    void reset();
+
+    uint64_t getIncarnation() const
+    {
+        return m_incarnation;
+    }
+
+    const std::string& getPath() const
+    {
+        return m_path;
+    }
+
+private:
+    struct Page;
+
+    void map();
+    void unmap();
+    const Slot* current() const;
+    void commit(int senderSeqNum, int targetSeqNum);
+
+    std::string m_path;
+    std::string m_senderCompID;
+    std::string m_targetCompID;
+
+    int m_fd = -1;
+    Page* m_page = nullptr;
+
+    // mirrors the current slot so a write never reads the page back
+    uint64_t m_generation = 0;
+    uint64_t m_incarnation = 0;
+
+    CREATE_LOGGER("SeqNumFile");
+};
@@ -64,12 +64,12 @@ void Session::onNetworkMessage(std::string text)
 
         processMessage(msg, time);
 
-        // handle inbound queue
+        // handle inbound queue; queued messages are kept as raw text and only parsed
+        // once their turn comes
         auto& queue = m_cache->getInboundQueue();
-        while (!queue.empty() && getTargetSeqNum() == queue.begin()->first) {
-            processMessage(queue.begin()->second, time);
-            queue.erase(queue.begin());
-        }
+        std::string queued;
+        while (!queue.empty() && queue.pop(getTargetSeqNum(), queued))
+            processMessage(m_dictionary->parse(m_settings, std::move(queued)), time);
 
         m_cachedEpochUs = 0;
     } catch (const MessageParsingError& e) {
@@ -154,6 +154,19 @@ void Session::send(Message& msg, SendCallback_T callback)
     auto wire = msg.toString(true);
     m_cache->cache(seqnum, wire);
     m_cache->nextSenderSeqNum();
+
+    if (callback && m_settings.getBool(SessionSettings::STORE_SYNCED_CALLBACKS))
+        callback = m_cache->syncedCallback(seqnum, std::move(callback));
+
+    // new messages queue up behind an in-progress replay to keep the wire in seqnum order
+    if (m_resending.load(std::memory_order_acquire)) {
+        std::lock_guard lock(m_deferredMutex);
+        if (m_resending.load(std::memory_order_relaxed)) {
+            m_deferred.push_back({std::move(wire), std::move(callback)});
+            return;
+        }
+    }
+
     internal_send(std::move(wire), std::move(callback), epoch_us);
 }
 
@@ -179,14 +192,38 @@ void Session::internal_send(std::string msg, SendCallback_T callback, int64_t ep
     }
 }
 
-void Session::onNetworkUpdate()
+void Session::internal_send(std::vector<MsgPacket> batch, int64_t epoch_us)
 {
-    if (!m_enabled.load(std::memory_order_acquire))
+    if (batch.empty() || !m_network->isConnected())
         return;
 
+    LOG_DEBUG("Sending batch of " << batch.size() << " outbound FIX messages");
+
+    for (const auto& packet : batch)
+        m_logger.logMessage(epoch_us, packet.m_msg, Direction::OUTBOUND);
+    m_network->send(std::move(batch));
+
+    m_lastSentHeartbeat = static_cast<long>(epoch_us / 1000);
+}
+
+long Session::onNetworkUpdate()
+{
+    if (!m_enabled.load(std::memory_order_acquire))
+        return 0;
+
+    // the next chunk is due as soon as the last one drains; the update thread
+    // also lands here for disconnected sessions, and leaves the replay alone
+    if (m_network->isConnected()) {
+        try {
+            continueMessageRecovery();
+        } catch (...) {
+            LOG_ERROR("Error during message recovery!");
+        }
+    }
+
     const long now = Utils::getEpochMillis();
     if ((now - m_lastUpdate) < 1)
-        return;
+        return now + 1;
     m_lastUpdate = now;
 
     try {
@@ -195,6 +232,8 @@ void Session::onNetworkUpdate()
     } catch (...) {
         LOG_ERROR("Error during update loop!");
     }
+
+    return nextUpdateTime(now);
 }
 
 void Session::internal_update()
@@ -255,6 +294,42 @@ void Session::internal_update()
     }
 }
 
+long Session::nextUpdateTime(long time) const
+{
+    // reconnects are left to the application's update thread
+    if (!m_network->isConnected())
+        return 0;
+
+    // a replay comes back every ms, in case its rate limit held a chunk back
+    if (m_resending.load(std::memory_order_acquire))
+        return time + 1;
+
+    long next = 0;
+    const auto until = [&](long deadline) {
+        if (next == 0 || deadline < next)
+            next = deadline;
+    };
+
+    if (m_settings.getSessionType() == SessionType::INITIATOR && m_state == SessionState::LOGON)
+        until(m_lastLogon + m_logonInterval);
+
+    if (m_heartbeatInterval <= 0)
+        return next;
+
+    const long heartbeatTimeout = static_cast<long>(m_settings.getDouble(SessionSettings::TEST_REQUEST_THRESHOLD) * m_heartbeatInterval);
+    if (m_state == SessionState::TEST_REQUEST)
+        until(m_lastSentTestRequest + heartbeatTimeout);
+    if (m_state == SessionState::LOGOUT)
+        until(m_logoutTime + 2 * m_heartbeatInterval);
+
+    if (m_state != SessionState::LOGON && m_state != SessionState::LOGOUT && m_state != SessionState::KILLING) {
+        until(m_lastSentHeartbeat + m_heartbeatInterval);
+        if (m_state != SessionState::TEST_REQUEST)
+            until(m_lastRecvHeartbeat + heartbeatTimeout);
+    }
+    return next;
+}
+
 void Session::handleLogon(const Message& msg)
 {
     const bool isTest = msg.getBody().tryGetBool(FIELD::TestMessageIndicator);
@@ -330,35 +405,185 @@ void Session::handleLogon(const Message& msg)
 
 void Session::runMessageRecovery(int beginSeqNo, int endSeqNo)
 {
-    endSeqNo = std::min(endSeqNo, getSenderSeqNum());
+    // last seqnum we've actually sent; EndSeqNo=0 (or past it) means "everything"
+    const int lastSeqNo = getSenderSeqNum() - 1;
+    const int upperSeqNo = (endSeqNo == 0 || endSeqNo > lastSeqNo) ? lastSeqNo : endSeqNo;
+    if (beginSeqNo > upperSeqNo)
+        return;
+
+    // a newer ResendRequest supersedes whatever is still in flight
+    if (m_resending.load(std::memory_order_acquire))
+        LOG_INFO("Replacing in-progress message recovery with " << beginSeqNo << " to " << upperSeqNo);
+
+    {
+        std::lock_guard lock(m_deferredMutex);
+        m_resend.m_scanSeqNo = beginSeqNo;
+        m_resend.m_gapSeqNo = beginSeqNo;
+        m_resend.m_endSeqNo = upperSeqNo;
+        m_resend.m_tokens = m_settings.getLong(SessionSettings::RESEND_MAX_BYTES_PER_SEC);
+        m_resend.m_lastRefillUs = m_cachedEpochUs ? m_cachedEpochUs : Utils::getEpochMicros();
+        m_resend.m_generation = m_resendGeneration;
+        m_resending.store(true, std::memory_order_release);
+    }
+
+    // first chunk goes out immediately, the rest from onNetworkUpdate()
+    continueMessageRecovery();
+}
+
+void Session::continueMessageRecovery()
+{
+    // a disconnect aborts the replay from onNetworkDisconnect()
+    if (!m_resending.load(std::memory_order_acquire) || !m_network->isConnected())
+        return;
 
-    int ptr = beginSeqNo;
-    m_cache->getMessages(beginSeqNo, endSeqNo, [&](int seqno, Message msg) {
-        // skip session-level messages
-        if (MESSAGE::SESSION_MSGS.count(std::string(msg.getHeader().getField(FIELD::MsgType))))
+    // wait for the previous chunk to reach the socket; EPOLLOUT flushes it and
+    // wakes the reader thread, which calls back in here via onNetworkUpdate()
+    if (m_network->hasPendingWrites())
+        return;
+
+    auto& task = m_resend;
+    const int64_t epoch_us = m_cachedEpochUs ? m_cachedEpochUs : Utils::getEpochMicros();
+
+    const long maxMessages = std::max(1L, m_settings.getLong(SessionSettings::RESEND_BATCH_SIZE));
+    int64_t maxBytes = std::max(1L, m_settings.getLong(SessionSettings::RESEND_BATCH_BYTES));
+
+    const long maxRate = m_settings.getLong(SessionSettings::RESEND_MAX_BYTES_PER_SEC);
+    if (maxRate > 0) {
+        // token bucket holding at most one second of bandwidth
+        task.m_tokens = std::min<int64_t>(maxRate, task.m_tokens + (epoch_us - task.m_lastRefillUs) * maxRate / 1000000);
+        task.m_lastRefillUs = epoch_us;
+        if (task.m_tokens <= 0)
             return;
+        maxBytes = std::min(maxBytes, task.m_tokens);
+    }
 
-        // send gapfill if we need to
-        if (seqno != ptr)
-            sendSequenceReset(ptr, seqno);
+    // one SendingTime for the whole chunk, spliced into each cached wire as-is
+    char ts_buf[24];
+    const std::string_view sendingTime(ts_buf, Utils::writeUTCTimestamp(ts_buf, static_cast<long>(epoch_us / 1000)));
 
-        msg.getHeader().setField(FIELD::PossDupFlag, "Y");
-        const std::string sendingTime(msg.getHeader().getField(FIELD::SendingTime));
-        msg.getHeader().setField(FIELD::OrigSendingTime, sendingTime);
-        msg.getHeader().setField(FIELD::SendingTime, Utils::getUTCTimestamp());
+    // any run of session-level or missing messages collapses into one GapFill,
+    // which may span chunk boundaries since m_gapSeqNo carries over
+    std::vector<MsgPacket> batch;
+    int64_t bytes = 0;
+    long scanned = 0;
+
+    const auto add = [&](std::string wire) {
+        bytes += static_cast<int64_t>(wire.size());
+        batch.push_back({std::move(wire), {}});
+    };
+
+    m_cache->getMessages(task.m_scanSeqNo, task.m_endSeqNo, [&](int seqno, std::string_view wire, const WireOffsets& offsets) {
+        if (scanned >= maxMessages || bytes >= maxBytes)
+            return false;
+        ++scanned;
+        task.m_scanSeqNo = seqno + 1;
+
+        if (offsets.valid()) {
+            // skip session-level messages
+            if (MESSAGE::isSessionMessage(offsets.msgType(wire)))
+                return true;
+
+            if (seqno != task.m_gapSeqNo)
+                add(createSequenceReset(task.m_gapSeqNo, seqno).toString(true));
+
+            std::string out;
+            patchForResend(wire, offsets, sendingTime, out);
+            add(std::move(out));
+        } else {
+            // couldn't index this one when cached, fall back to a full parse
+            auto msg = m_dictionary->parse(m_settings, std::string(wire));
+            if (MESSAGE::isSessionMessage(msg.getHeader().getField(FIELD::MsgType)))
+                return true;
+
+            if (seqno != task.m_gapSeqNo)
+                add(createSequenceReset(task.m_gapSeqNo, seqno).toString(true));
+
+            msg.getHeader().setField(FIELD::PossDupFlag, "Y");
+            const std::string origSendingTime(msg.getHeader().getField(FIELD::SendingTime));
+            msg.getHeader().setField(FIELD::OrigSendingTime, origSendingTime);
+            msg.getHeader().setField(FIELD::SendingTime, sendingTime);
+            add(msg.toString(true));
+        }
 
-        internal_send(msg, {});
         // expect to send the next message
-        ptr = seqno + 1;
+        task.m_gapSeqNo = seqno + 1;
+        return true;
     });
 
-    if (ptr != beginSeqNo)
-        --ptr;
+    // budget left over means the cache has nothing more in range
+    if (scanned < maxMessages && bytes < maxBytes)
+        task.m_scanSeqNo = task.m_endSeqNo + 1;
 
-    endSeqNo = endSeqNo != 0 ? endSeqNo : getSenderSeqNum();
-    // send final gapfill if we need to
-    if (ptr < endSeqNo)
-        sendSequenceReset(ptr, endSeqNo);
+    const bool done = task.m_scanSeqNo > task.m_endSeqNo;
+
+    // trailing gap through the end of the requested range
+    if (done && task.m_gapSeqNo <= task.m_endSeqNo) {
+        add(createSequenceReset(task.m_gapSeqNo, task.m_endSeqNo + 1).toString(true));
+        task.m_gapSeqNo = task.m_endSeqNo + 1;
+    }
+
+    if (maxRate > 0)
+        task.m_tokens -= bytes;
+
+    std::lock_guard lock(m_deferredMutex);
+
+    // aborted by a disconnect meanwhile; none of it may reach a new connection
+    if (task.m_generation != m_resendGeneration) {
+        m_resend = {};
+        return;
+    }
+
+    internal_send(std::move(batch), epoch_us);
+
+    if (done)
+        finishMessageRecovery();
+}
+
+void Session::finishMessageRecovery()
+{
+    // flush held-back sends before clearing the flag so nothing new can overtake them
+    std::vector<MsgPacket> deferred;
+    deferred.swap(m_deferred);
+
+    LOG_INFO("Message recovery complete through " << m_resend.m_endSeqNo);
+    internal_send(std::move(deferred), m_cachedEpochUs ? m_cachedEpochUs : Utils::getEpochMicros());
+
+    // a held-back terminal logout terminates from its own callback now
+    m_deferredTerminate.reset();
+    m_resend = {};
+    m_resending.store(false, std::memory_order_release);
+}
+
+void Session::abortMessageRecovery()
+{
+    size_t dropped = 0;
+    std::optional<std::string> terminateReason;
+    {
+        std::lock_guard lock(m_deferredMutex);
+        if (!m_resending.load(std::memory_order_acquire))
+            return;
+
+        // m_resend itself belongs to the reader, which sees the new generation and clears it
+        ++m_resendGeneration;
+        dropped = m_deferred.size();
+        m_deferred.clear();
+        terminateReason.swap(m_deferredTerminate);
+        m_resending.store(false, std::memory_order_release);
+    }
+
+    // never sent, so their send callbacks don't run
+    if (dropped > 0)
+        LOG_WARN("Message recovery aborted, dropping " << dropped << " held messages (still cached for resend)");
+
+    // a terminal logout among them still ends the connection, if there's one left
+    if (terminateReason && m_network->isConnected())
+        terminate(*terminateReason);
+}
+
+void Session::onNetworkDisconnect()
+{
+    // nothing of a replay for the old connection may go out on the next one
+    abortMessageRecovery();
 }
 
 void Session::handleResendRequest(const Message& msg)
@@ -425,10 +650,18 @@ void Session::sendLogout(const std::string& reason, bool terminate)
     if (!reason.empty())
         msg.getBody().setField(FIELD::Text, reason);
 
-    if (terminate)
+    if (terminate) {
+        // held back behind a replay, its callback only runs once that completes;
+        // if the replay's aborted instead, abortMessageRecovery() terminates for it
+        if (m_resending.load(std::memory_order_acquire)) {
+            std::lock_guard lock(m_deferredMutex);
+            if (m_resending.load(std::memory_order_relaxed))
+                m_deferredTerminate = reason;
+        }
         send(msg, [this, reason] { this->terminate(reason); });
-    else
+    } else {
         send(msg);
+    }
 }
 
 void Session::sendResendRequest(int from, int to)
@@ -439,7 +672,7 @@ void Session::sendResendRequest(int from, int to)
     send(msg);
 }
 
-void Session::sendSequenceReset(int seqno, int new_seqno, bool gapfill)
+Message Session::createSequenceReset(int seqno, int new_seqno, bool gapfill)
 {
     auto msg = m_dictionary->create(MESSAGE::SEQUENCE_RESET);
     populateMessage(msg);
@@ -451,7 +684,7 @@ void Session::sendSequenceReset(int seqno, int new_seqno, bool gapfill)
     if (gapfill)
         msg.getBody().setField(FIELD::GapFillFlag, "Y");
 
-    internal_send(msg, {});
+    return msg;
 }
 
 void Session::logout(const std::string& reason, bool terminate)
@@ -514,6 +747,8 @@ bool Session::load()
 
 void Session::reset()
 {
+    // a replay of the old sequence would be meaningless after it
+    abortMessageRecovery();
     m_cache->reset();
 }
 
@@ -608,7 +843,8 @@ bool Session::validateSeqNum(const Message& msg)
         logout("MsgSeqNum too low, expected " + std::to_string(m_cache->getTargetSeqNum()) + ", received " + std::to_string(seqNum), true);
     } else if (seqNum) {
         // queue this message and send resend request for gap
-        m_cache->getInboundQueue()[seqNum] = msg;
+        if (!m_cache->getInboundQueue().push(seqNum, msg.getSourceText(), getTargetSeqNum()))
+            LOG_DEBUG("MsgSeqNum " << seqNum << " too far ahead to queue, leaving it to the resend request");
         sendResendRequest(getTargetSeqNum(), seqNum);
     }
 
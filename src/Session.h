@@ -4,6 +4,10 @@
 
 #include <atomic>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include "Config.h"
 #include "Dictionary.h"
@@ -94,7 +98,8 @@ public:
 
     // NetworkDelegate — called directly by ReaderThread, no dispatch queue
     void onNetworkMessage(std::string text) override;
-    void onNetworkUpdate() override;
+    long onNetworkUpdate() override;
+    void onNetworkDisconnect() override;
 
 private:
     bool load();
@@ -102,11 +107,19 @@ private:
 
     int populateMessage(Message& msg, long epoch_ms = 0);
     void runMessageRecovery(int from, int to);
+    void continueMessageRecovery();
+    // with m_deferredMutex held
+    void finishMessageRecovery();
+    // from any thread, with no network locks held
+    void abortMessageRecovery();
 
     void internal_update();
+    // when the session next has something due without traffic, or 0 for never
+    long nextUpdateTime(long time) const;
 
     void internal_send(const Message& msg, SendCallback_T callback);
     void internal_send(std::string msg, SendCallback_T callback, int64_t epoch_us);
+    void internal_send(std::vector<MsgPacket> batch, int64_t epoch_us);
 
 private:
     void processMessage(const Message& msg, long time);
@@ -125,7 +138,7 @@ private:
     void sendLogon(bool reset);
     void sendLogout(const std::string& reason, bool terminate);
     void sendResendRequest(int from, int to);
-    void sendSequenceReset(int seqno, int new_seqno, bool gapfill = true);
+    Message createSequenceReset(int seqno, int new_seqno, bool gapfill = true);
     void sendTestRequest();
     void sendReject(const Message& msg, SessionRejectReason reason, std::string text = "");
 
@@ -166,5 +179,31 @@ private:
     // hot-path cached timestamp (0 = not cached)
     int64_t m_cachedEpochUs = 0;
 
+    // in-progress message recovery, advanced a chunk at a time from onNetworkUpdate();
+    // only ever touched on the reader thread
+    struct ResendTask
+    {
+        int m_scanSeqNo = 0;  // next cached seqnum to look at
+        int m_gapSeqNo = 0;   // first seqnum not yet covered by a replay or GapFill
+        int m_endSeqNo = 0;   // last seqnum in the requested range
+
+        int64_t m_tokens = 0;  // replay bandwidth budget (bytes)
+        int64_t m_lastRefillUs = 0;
+
+        uint64_t m_generation = 0;  // m_resendGeneration when it started
+    };
+
+    ResendTask m_resend;
+    std::atomic<bool> m_resending{false};
+
+    // sends issued while a replay is in flight, released once it completes
+    std::mutex m_deferredMutex;
+    std::vector<MsgPacket> m_deferred;
+    // bumped under m_deferredMutex when a disconnect aborts the replay, so the
+    // reader drops whatever it was still putting together for the old connection
+    uint64_t m_resendGeneration = 0;
+    // reason of a terminal logout among m_deferred
+    std::optional<std::string> m_deferredTerminate;
+
     CREATE_LOGGER("Session");
 };
@@ -0,0 +1,162 @@
+#include "WirePatch.h"
+
+#include <algorithm>
+#include <charconv>
+
+#include "Checksum.h"
+#include "Fields.h"
+
+namespace {
+
+struct WireEdit
+{
+    uint32_t m_pos;
+    uint32_t m_len;
+    std::string_view m_value;
+};
+
+inline uint32_t byteSum(std::string_view sv)
+{
+    uint32_t sum = 0;
+    for (const char c : sv)
+        sum += static_cast<uint8_t>(c);
+    return sum;
+}
+
+constexpr std::string_view POSS_DUP_FIELD = "43=Y\x01";
+constexpr std::string_view ORIG_SENDING_TIME_TAG = "122=";
+
+}  // namespace
+
+bool scanWireOffsets(std::string_view wire, const GroupSpec& headerSpec, WireOffsets& offsets)
+{
+    offsets = {};
+
+    // trailer is always "<SOH>10=XXX<SOH>"
+    if (wire.size() < 8 || wire.back() != INTERNAL_SOH_CHAR || wire[wire.size() - 8] != INTERNAL_SOH_CHAR
+        || wire.compare(wire.size() - 7, 3, "10=") != 0)
+        return false;
+
+    const size_t checksumField = wire.size() - 7;
+    offsets.m_checksum = static_cast<uint32_t>(checksumField + 3);
+
+    size_t pos = 0;
+    while (pos < checksumField) {
+        const size_t eq = wire.find(TAG_ASSIGNMENT_CHAR, pos);
+        if (eq == std::string_view::npos || eq >= checksumField)
+            return false;
+        const size_t soh = wire.find(INTERNAL_SOH_CHAR, eq + 1);
+        if (soh == std::string_view::npos)
+            return false;
+
+        int tag = 0;
+        const auto [ptr, ec] = std::from_chars(wire.data() + pos, wire.data() + eq, tag);
+        if (ec != std::errc{} || ptr != wire.data() + eq)
+            return false;
+
+        const auto value = static_cast<uint32_t>(eq + 1);
+        const auto len = static_cast<uint32_t>(soh - eq - 1);
+
+        if (tag == FIELD::BodyLength) {
+            offsets.m_bodyLength = value;
+            offsets.m_bodyLengthLen = len;
+        } else if (tag == FIELD::MsgType) {
+            offsets.m_msgType = value;
+            offsets.m_msgTypeLen = len;
+        } else if (tag == FIELD::SendingTime) {
+            offsets.m_sendingTime = value;
+            offsets.m_sendingTimeLen = len;
+        } else if (tag == FIELD::PossDupFlag) {
+            offsets.m_possDupFlag = value;
+            offsets.m_possDupFlagLen = len;
+        } else if (tag == FIELD::OrigSendingTime) {
+            offsets.m_origSendingTime = value;
+            offsets.m_origSendingTimeLen = len;
+        } else if (tag != FIELD::BeginString && !headerSpec.hasField(tag)) {
+            // first body field, nothing left to record
+            break;
+        }
+
+        pos = soh + 1;
+    }
+
+    return offsets.valid();
+}
+
+void patchForResend(std::string_view wire, const WireOffsets& offsets, std::string_view sendingTime, std::string& out)
+{
+    const std::string_view origSendingTime = offsets.sendingTime(wire);
+
+    // OrigSendingTime field text when we have to insert one
+    thread_local std::string origField;
+
+    WireEdit edits[3];
+    size_t count = 0;
+
+    if (offsets.m_possDupFlag)
+        edits[count++] = {offsets.m_possDupFlag, offsets.m_possDupFlagLen, "Y"};
+    else
+        edits[count++] = {offsets.m_sendingTime - 3, 0, POSS_DUP_FIELD};
+
+    edits[count++] = {offsets.m_sendingTime, offsets.m_sendingTimeLen, sendingTime};
+
+    if (offsets.m_origSendingTime) {
+        edits[count++] = {offsets.m_origSendingTime, offsets.m_origSendingTimeLen, origSendingTime};
+    } else {
+        origField.clear();
+        origField.append(ORIG_SENDING_TIME_TAG);
+        origField.append(origSendingTime);
+        origField += INTERNAL_SOH_CHAR;
+        edits[count++] = {offsets.m_sendingTime + offsets.m_sendingTimeLen + 1, 0, origField};
+    }
+
+    std::sort(edits, edits + count, [](const WireEdit& a, const WireEdit& b) { return a.m_pos < b.m_pos; });
+
+    // the checksum is a plain byte sum, so it can be carried forward from the
+    // original value by removing the bytes we drop and adding the ones we splice in
+    int64_t bodyDelta = 0;
+    uint32_t sum = 0;
+    {
+        int checksum = 0;
+        std::from_chars(wire.data() + offsets.m_checksum, wire.data() + offsets.m_checksum + 3, checksum);
+        sum = static_cast<uint32_t>(checksum);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const auto& edit = edits[i];
+        bodyDelta += static_cast<int64_t>(edit.m_value.size()) - edit.m_len;
+        sum += byteSum(edit.m_value);
+        sum -= byteSum(wire.substr(edit.m_pos, edit.m_len));
+    }
+
+    const std::string_view oldBodyLength = wire.substr(offsets.m_bodyLength, offsets.m_bodyLengthLen);
+    int bodyLength = 0;
+    std::from_chars(oldBodyLength.data(), oldBodyLength.data() + oldBodyLength.size(), bodyLength);
+    bodyLength += static_cast<int>(bodyDelta);
+
+    char bodyLengthBuf[12];
+    const auto [blEnd, ec] = std::to_chars(bodyLengthBuf, bodyLengthBuf + sizeof(bodyLengthBuf), bodyLength);
+    const std::string_view newBodyLength(bodyLengthBuf, blEnd - bodyLengthBuf);
+
+    sum += byteSum(newBodyLength);
+    sum -= byteSum(oldBodyLength);
+
+    out.clear();
+    out.reserve(wire.size() + bodyDelta + newBodyLength.size());
+
+    out.append(wire.data(), offsets.m_bodyLength);
+    out.append(newBodyLength);
+
+    size_t cursor = offsets.m_bodyLength + offsets.m_bodyLengthLen;
+    for (size_t i = 0; i < count; ++i) {
+        const auto& edit = edits[i];
+        out.append(wire.data() + cursor, edit.m_pos - cursor);
+        out.append(edit.m_value);
+        cursor = edit.m_pos + edit.m_len;
+    }
+    out.append(wire.data() + cursor, offsets.m_checksum - cursor);
+
+    const auto checksumStr = formatChecksum(static_cast<uint8_t>(sum & 0xFF));
+    out.append(checksumStr.data(), checksumStr.size());
+    out += INTERNAL_SOH_CHAR;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Message.h"
+
+// Byte offsets of the header fields rewritten on resend, recorded once when a
+// message is cached so replay never has to re-parse the wire string.
+// All offsets point at the first byte of the field's value; 0 means absent.
+struct WireOffsets
+{
+    uint32_t m_bodyLength = 0;
+    uint32_t m_bodyLengthLen = 0;
+
+    uint32_t m_msgType = 0;
+    uint32_t m_msgTypeLen = 0;
+
+    uint32_t m_sendingTime = 0;
+    uint32_t m_sendingTimeLen = 0;
+
+    uint32_t m_possDupFlag = 0;
+    uint32_t m_possDupFlagLen = 0;
+
+    uint32_t m_origSendingTime = 0;
+    uint32_t m_origSendingTimeLen = 0;
+
+    // start of the CheckSum(10) value, always 3 digits
+    uint32_t m_checksum = 0;
+
+    bool valid() const
+    {
+        return m_bodyLength && m_msgType && m_sendingTime && m_checksum;
+    }
+
+    std::string_view msgType(std::string_view wire) const
+    {
+        return wire.substr(m_msgType, m_msgTypeLen);
+    }
+
+    std::string_view sendingTime(std::string_view wire) const
+    {
+        return wire.substr(m_sendingTime, m_sendingTimeLen);
+    }
+};
+
+// Scan the header of a serialized (internal SOH) message, stopping at the first
+// field not present in headerSpec. Returns false if the message is malformed.
+bool scanWireOffsets(std::string_view wire, const GroupSpec& headerSpec, WireOffsets& offsets);
+
+// Write a resend copy of wire into out: PossDupFlag(43)=Y, OrigSendingTime(122)
+// set to the original SendingTime(52), and SendingTime replaced by sendingTime.
+// BodyLength and CheckSum are adjusted from the edited bytes only.
+void patchForResend(std::string_view wire, const WireOffsets& offsets, std::string_view sendingTime, std::string& out);
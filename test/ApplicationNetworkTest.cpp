@@ -22,11 +22,20 @@ class ApplicationNetworkTest : public SessionTestFixture
 {
 protected:
     int port2_;
+    // tests load their own PlatformSettings; TearDown puts these back
+    Config<PlatformSettings> platformSettings_;
 
     void SetUp() override
     {
         SessionTestFixture::SetUp();
         port2_ = getAvailablePort();
+        platformSettings_ = PlatformSettings::snapshot();
+    }
+
+    void TearDown() override
+    {
+        PlatformSettings::restore(platformSettings_);
+        SessionTestFixture::TearDown();
     }
 };
 
@@ -228,6 +237,35 @@ TEST_F(ApplicationNetworkTest, MultipleInitiatorSessions)
     acceptorApp.stop();
 }
 
+// sessions sharing a reader thread, sending from their own threads at once,
+// each get every message through in order
+TEST_F(ApplicationNetworkTest, ConcurrentSendsOnSharedReaderArriveInOrder)
+{
+    constexpr int COUNT = 2000;
+
+    Application app;
+    app.createSession("session1", makeAcceptorSettings(port_, "SERVER1", "CLIENT1"));
+    app.createSession("session2", makeAcceptorSettings(port_, "SERVER2", "CLIENT2"));
+    app.start();
+
+    RawFIXClient client1, client2;
+    ASSERT_TRUE(client1.connectWithRetry(port_));
+    ASSERT_TRUE(client1.performLogon("CLIENT1", "SERVER1"));
+    ASSERT_TRUE(client2.connectWithRetry(port_));
+    ASSERT_TRUE(client2.performLogon("CLIENT2", "SERVER2"));
+
+    const auto s1 = app.getSession("session1");
+    const auto s2 = app.getSession("session2");
+    ASSERT_TRUE(waitFor([&] { return s1->getTargetSeqNum() >= 2; }, std::chrono::seconds(3)));
+    ASSERT_TRUE(waitFor([&] { return s2->getTargetSeqNum() >= 2; }, std::chrono::seconds(3)));
+
+    std::thread burst2([&] { sendBurstAndExpectInOrder(s2, client2, COUNT); });
+    sendBurstAndExpectInOrder(s1, client1, COUNT);
+    burst2.join();
+
+    app.stop();
+}
+
 // initiator reconnects automatically after server restarts
 TEST_F(ApplicationNetworkTest, InitiatorReconnectsAfterDisconnect)
 {
@@ -259,6 +297,261 @@ TEST_F(ApplicationNetworkTest, InitiatorReconnectsAfterDisconnect)
     acceptorApp2.stop();
 }
 
+// busy-polling readers log on and exchange heartbeats, spinning and after
+// dropping back to sleeping in epoll_wait
+TEST_F(ApplicationNetworkTest, BusyPollingReadersExchangeMessages)
+{
+    PlatformSettings::load({{"ReaderBusyPoll", "true"}, {"ReaderBusyPollIdleUs", "20000"}});
+
+    Application acceptorApp;
+    acceptorApp.createSession("acc", makeAcceptorSettings(port_, "SERVER", "CLIENT"));
+    acceptorApp.start();
+
+    Application initiatorApp;
+    initiatorApp.createSession("init", makeInitiatorSettings(port_, "CLIENT", "SERVER"));
+    initiatorApp.start();
+
+    const auto acc = acceptorApp.getSession("acc");
+    const auto init = initiatorApp.getSession("init");
+    ASSERT_TRUE(waitFor([&] { return acc->getTargetSeqNum() >= 2; }, std::chrono::seconds(5)));
+    ASSERT_TRUE(waitFor([&] { return init->getTargetSeqNum() >= 2; }, std::chrono::seconds(5)));
+
+    // 1s heartbeats arrive long after the readers stop spinning
+    EXPECT_TRUE(waitFor([&] { return acc->getTargetSeqNum() >= 3 && init->getTargetSeqNum() >= 3; }, std::chrono::seconds(5)));
+
+    // each reader spun on empty polls after its traffic instead of sleeping in epoll_wait
+    for (auto* app : {&acceptorApp, &initiatorApp}) {
+        for (const auto& reader : app->getReaderStats()) {
+            EXPECT_TRUE(reader.m_busyPoll);
+            EXPECT_GT(reader.m_spins, 0u);
+        }
+    }
+
+    initiatorApp.stop();
+    acceptorApp.stop();
+}
+
+// io_uring readers accept, log on an initiator and deliver a burst of sends in
+// order (readers fall back to epoll where io_uring is unavailable)
+TEST_F(ApplicationNetworkTest, IoUringReadersExchangeMessages)
+{
+    constexpr int COUNT = 2000;
+
+    PlatformSettings::load({{"ReaderBackend", "io_uring"}});
+
+    Application acceptorApp;
+    acceptorApp.createSession("acc", makeAcceptorSettings(port_, "SERVER", "CLIENT"));
+    acceptorApp.createSession("raw", makeAcceptorSettings(port_, "SERVER2", "CLIENT2"));
+    acceptorApp.start();
+
+    Application initiatorApp;
+    initiatorApp.createSession("init", makeInitiatorSettings(port_, "CLIENT", "SERVER"));
+    initiatorApp.start();
+
+    const auto acc = acceptorApp.getSession("acc");
+    const auto init = initiatorApp.getSession("init");
+    ASSERT_TRUE(waitFor([&] { return acc->getTargetSeqNum() >= 2; }, std::chrono::seconds(5)));
+    ASSERT_TRUE(waitFor([&] { return init->getTargetSeqNum() >= 2; }, std::chrono::seconds(5)));
+
+    RawFIXClient client;
+    ASSERT_TRUE(client.connectWithRetry(port_));
+    ASSERT_TRUE(client.performLogon("CLIENT2", "SERVER2"));
+    const auto raw = acceptorApp.getSession("raw");
+    ASSERT_TRUE(waitFor([&] { return raw->getTargetSeqNum() >= 2; }, std::chrono::seconds(3)));
+
+    sendBurstAndExpectInOrder(raw, client, COUNT);
+
+    initiatorApp.stop();
+    acceptorApp.stop();
+}
+
+// ---- reader placement ----
+
+// accepted connections move to their sessions' readers: a critical session's
+// own, the least loaded of the bulk pool, or the one a session names
+TEST_F(ApplicationNetworkTest, SessionsMoveToPlacedReaders)
+{
+    constexpr int COUNT = 500;
+
+    PlatformSettings::load({{"ReaderPools", "bulk:2"}});
+
+    auto critical = makeAcceptorSettings(port_, "SERVER1", "CLIENT1");
+    critical.setString(SessionSettings::READER_PRIORITY, "critical");
+    auto bulk1 = makeAcceptorSettings(port_, "SERVER2", "CLIENT2");
+    bulk1.setString(SessionSettings::READER_PRIORITY, "bulk");
+    auto bulk2 = makeAcceptorSettings(port_, "SERVER3", "CLIENT3");
+    bulk2.setString(SessionSettings::READER_PRIORITY, "bulk");
+    auto pinned = makeAcceptorSettings(port_, "SERVER4", "CLIENT4");
+    pinned.setString(SessionSettings::READER_THREAD, "bulk-1");
+
+    Application app;
+    app.createSession("critical", critical);
+    app.createSession("bulk1", bulk1);
+    app.createSession("bulk2", bulk2);
+    app.createSession("pinned", pinned);
+    app.start();
+
+    const auto readerOf = [&](const std::string& sessionID) {
+        for (const auto& reader : app.getReaderStats()) {
+            if (std::find(reader.m_sessions.begin(), reader.m_sessions.end(), sessionID) != reader.m_sessions.end())
+                return reader.m_name;
+        }
+        return std::string();
+    };
+
+    RawFIXClient clients[4];
+    for (int i = 0; i < 4; ++i) {
+        const auto n = std::to_string(i + 1);
+        ASSERT_TRUE(clients[i].connectWithRetry(port_));
+        ASSERT_TRUE(clients[i].performLogon("CLIENT" + n, "SERVER" + n));
+    }
+
+    EXPECT_TRUE(waitFor([&] { return readerOf("SERVER1:CLIENT1") == "critical-SERVER1:CLIENT1"; }, std::chrono::seconds(3)));
+    EXPECT_TRUE(waitFor([&] { return readerOf("SERVER2:CLIENT2") == "bulk-0"; }, std::chrono::seconds(3)));
+    EXPECT_TRUE(waitFor([&] { return readerOf("SERVER3:CLIENT3") == "bulk-1"; }, std::chrono::seconds(3)));
+    EXPECT_TRUE(waitFor([&] { return readerOf("SERVER4:CLIENT4") == "bulk-1"; }, std::chrono::seconds(3)));
+
+    for (const auto& reader : app.getReaderStats()) {
+        if (reader.m_name == "default-0")
+            EXPECT_EQ(reader.m_connections, 0u);
+        else if (reader.m_name == "bulk-1")
+            EXPECT_EQ(reader.m_placed, 2u);
+    }
+
+    // both directions carry on from the new reader
+    const auto session = app.getSession("critical");
+    clients[0].sendMessage("0", 2, {}, "CLIENT1", "SERVER1");
+    ASSERT_TRUE(waitFor([&] { return session->getTargetSeqNum() >= 3; }, std::chrono::seconds(3)));
+
+    sendBurstAndExpectInOrder(session, clients[0], COUNT);
+
+    app.stop();
+}
+
+// two busy sessions sharing a reader are spread over the pool by the
+// rebalancer, and neither loses or reorders a message as it moves
+TEST_F(ApplicationNetworkTest, RebalancingSpreadsBusySessions)
+{
+    PlatformSettings::load({{"InputThreads", "2"}, {"ReaderRebalanceIntervalMs", "100"}, {"ReaderRebalanceThreshold", "0.001"}});
+
+    Application app;
+    for (int i = 1; i <= 3; ++i)
+        app.createSession("session" + std::to_string(i), makeAcceptorSettings(port_, "SERVER" + std::to_string(i), "CLIENT" + std::to_string(i)));
+    app.start();
+
+    const auto readerOf = [&](int i) {
+        const auto sessionID = "SERVER" + std::to_string(i + 1) + ":CLIENT" + std::to_string(i + 1);
+        for (const auto& reader : app.getReaderStats()) {
+            if (std::find(reader.m_sessions.begin(), reader.m_sessions.end(), sessionID) != reader.m_sessions.end())
+                return reader.m_name;
+        }
+        return std::string();
+    };
+
+    RawFIXClient clients[3];
+    for (int i = 0; i < 3; ++i) {
+        const auto n = std::to_string(i + 1);
+        ASSERT_TRUE(clients[i].connectWithRetry(port_));
+        ASSERT_TRUE(clients[i].performLogon("CLIENT" + n, "SERVER" + n));
+    }
+
+    // unplaced, they're spread over the two readers by fd: two of them share one
+    std::vector<int> busy;
+    for (int i = 0; i < 3 && busy.size() < 2; ++i) {
+        for (int j = i + 1; j < 3 && busy.empty(); ++j) {
+            if (readerOf(i) == readerOf(j))
+                busy = {i, j};
+        }
+    }
+    ASSERT_EQ(busy.size(), 2u);
+
+    std::atomic<bool> sending{true};
+    int sent[3] = {0, 0, 0};
+    std::vector<std::thread> senders;
+    for (const int i : busy) {
+        senders.emplace_back([&, i] {
+            const auto n = std::to_string(i + 1);
+            while (sending.load()) {
+                clients[i].sendMessage("0", 2 + sent[i]++, {}, "CLIENT" + n, "SERVER" + n);
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        });
+    }
+
+    const bool spread = waitFor([&] {
+        const auto reader1 = readerOf(busy[0]);
+        const auto reader2 = readerOf(busy[1]);
+        return !reader1.empty() && !reader2.empty() && reader1 != reader2;
+    }, std::chrono::seconds(5));
+
+    sending = false;
+    for (auto& sender : senders)
+        sender.join();
+    EXPECT_TRUE(spread);
+
+    uint64_t moved = 0;
+    for (const auto& reader : app.getReaderStats())
+        moved += reader.m_movedIn;
+    EXPECT_GE(moved, 1u);
+
+    for (const int i : busy) {
+        const auto session = app.getSession("session" + std::to_string(i + 1));
+        EXPECT_TRUE(waitFor([&] { return session->getTargetSeqNum() == sent[i] + 2; }, std::chrono::seconds(3)));
+    }
+
+    app.stop();
+}
+
+// a burst read a message at a time, taking turns with the other connection on
+// the reader, still arrives whole and in order
+TEST_F(ApplicationNetworkTest, ReadBudgetSharesReaderBetweenConnections)
+{
+    PlatformSettings::load({{"ReadBudgetBytes", "1"}, {"ReadBudgetMessages", "1"}});
+
+    Application app;
+    app.createSession("session1", makeAcceptorSettings(port_, "SERVER1", "CLIENT1"));
+    app.createSession("session2", makeAcceptorSettings(port_, "SERVER2", "CLIENT2"));
+    app.start();
+
+    RawFIXClient client1, client2;
+    ASSERT_TRUE(client1.connectWithRetry(port_));
+    ASSERT_TRUE(client1.performLogon("CLIENT1", "SERVER1"));
+    ASSERT_TRUE(client2.connectWithRetry(port_));
+    ASSERT_TRUE(client2.performLogon("CLIENT2", "SERVER2"));
+
+    // well past one read's worth, in a single write
+    constexpr int burst = 2000;
+    std::string data;
+    for (int seq = 2; seq < 2 + burst; ++seq) {
+        data += buildRawMessage("FIX.4.2", {
+            {35, "0"},
+            {49, "CLIENT1"},
+            {56, "SERVER1"},
+            {34, std::to_string(seq)},
+            {52, Utils::getUTCTimestamp()},
+        });
+    }
+    client1.sendRaw(data);
+    client2.sendMessage("0", 2, {}, "CLIENT2", "SERVER2");
+
+    const auto s1 = app.getSession("session1");
+    const auto s2 = app.getSession("session2");
+    EXPECT_TRUE(waitFor([&] { return s2->getTargetSeqNum() == 3; }, std::chrono::seconds(3)));
+    EXPECT_TRUE(waitFor([&] { return s1->getTargetSeqNum() == 2 + burst; }, std::chrono::seconds(5)));
+
+    app.stop();
+}
+
+// an unknown priority class is a misconfigured session
+TEST_F(ApplicationNetworkTest, UnknownReaderPriorityRejected)
+{
+    auto settings = makeAcceptorSettings(port_, "SERVER", "CLIENT");
+    settings.setString(SessionSettings::READER_PRIORITY, "urgent");
+
+    Application app;
+    EXPECT_THROW(app.createSession("session1", settings), MisconfiguredSessionError);
+}
+
 // ---- lifecycle ----
 
 // stopping the application disconnects all active sessions
@@ -0,0 +1,472 @@
+#include <gtest/gtest.h>
+#include <openfix/FIXStore.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+
+namespace {
+
+class FileStoreTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        std::filesystem::remove_all("./data");
+
+        m_settings.setString(SessionSettings::SENDER_COMP_ID, "SENDER");
+        m_settings.setString(SessionSettings::TARGET_COMP_ID, "TARGET");
+        // a few messages per segment
+        m_settings.setLong(SessionSettings::STORE_SEGMENT_BYTES, 256);
+    }
+
+    void TearDown() override
+    {
+        PlatformSettings::load({{"StoreJournalShards", "0"}, {"StoreJournalSegmentBytes", "1073741824"}});
+        std::filesystem::remove_all("./data");
+    }
+
+    static void useJournal()
+    {
+        // a few messages per journal segment
+        PlatformSettings::load({{"StoreJournalShards", "1"}, {"StoreJournalSegmentBytes", "512"}});
+    }
+
+    static std::string payload(int seqnum)
+    {
+        return "8=FIX.4.2\x01" "34=" + std::to_string(seqnum) + "\x01" "58=message " + std::to_string(seqnum) + "\x01";
+    }
+
+    static std::map<int, std::string> read(const StoreHandle& handle, int begin, int end)
+    {
+        std::map<int, std::string> ret;
+        handle.forEachMessage(begin, end, [&](int seqnum, std::string_view wire) {
+            ret.emplace(seqnum, std::string(wire));
+            return true;
+        });
+        return ret;
+    }
+
+    void writeMessages(int first, int last)
+    {
+        FileStore store;
+        store.start();
+        auto handle = store.createStore(m_settings);
+        handle.load();
+        for (int i = first; i <= last; ++i)
+            handle.store(i, payload(i));
+        handle.setSeqNums(last + 1, 1);
+        store.stop();
+    }
+
+    // interleaves messages from m_settings' session and m_other's through one store
+    void writeBothSessions(int first, int last)
+    {
+        FileStore store;
+        store.start();
+        auto handle = store.createStore(m_settings);
+        auto other = store.createStore(m_other);
+        handle.load();
+        other.load();
+        for (int i = first; i <= last; ++i) {
+            handle.store(i, payload(i));
+            other.store(i, payload(i * 100));
+        }
+        handle.setSeqNums(last + 1, 1);
+        other.setSeqNums(last + 1, 1);
+        store.stop();
+    }
+
+    // what a crash leaves behind: no clean marker, index entries lost
+    static void simulateCrash()
+    {
+        std::filesystem::remove("./data/journal-0.clean");
+        std::filesystem::remove("./data/SENDER-TARGET.index");
+        std::filesystem::remove("./data/SENDER-OTHER.index");
+    }
+
+    SessionSettings m_settings;
+    SessionSettings m_other = [] {
+        SessionSettings settings;
+        settings.setString(SessionSettings::SENDER_COMP_ID, "SENDER");
+        settings.setString(SessionSettings::TARGET_COMP_ID, "OTHER");
+        return settings;
+    }();
+};
+
+}  // namespace
+
+TEST_F(FileStoreTest, ReadsBackAcrossSegments)
+{
+    writeMessages(1, 50);
+    EXPECT_TRUE(std::filesystem::exists("./data/SENDER-TARGET.2.data"));
+
+    FileStore store;
+    auto handle = store.createStore(m_settings);
+    const auto data = handle.load();
+    EXPECT_EQ(data.m_senderSeqNum, 51);
+
+    const auto all = read(handle, 1, 0);
+    ASSERT_EQ(all.size(), 50u);
+    for (const auto& [seqnum, wire] : all)
+        EXPECT_EQ(wire, payload(seqnum));
+
+    const auto range = read(handle, 20, 24);
+    ASSERT_EQ(range.size(), 5u);
+    EXPECT_EQ(range.begin()->first, 20);
+    EXPECT_EQ(range.rbegin()->first, 24);
+}
+
+TEST_F(FileStoreTest, AppendsAfterRestart)
+{
+    writeMessages(1, 10);
+    writeMessages(11, 20);
+
+    FileStore store;
+    auto handle = store.createStore(m_settings);
+    handle.load();
+
+    const auto all = read(handle, 1, 0);
+    ASSERT_EQ(all.size(), 20u);
+    for (const auto& [seqnum, wire] : all)
+        EXPECT_EQ(wire, payload(seqnum));
+}
+
+TEST_F(FileStoreTest, RebuildsMissingIndex)
+{
+    writeMessages(1, 30);
+    std::filesystem::remove("./data/SENDER-TARGET.index");
+
+    FileStore store;
+    auto handle = store.createStore(m_settings);
+    handle.load();
+
+    const auto all = read(handle, 1, 0);
+    ASSERT_EQ(all.size(), 30u);
+    EXPECT_EQ(all.at(17), payload(17));
+}
+
+TEST_F(FileStoreTest, SkipsBadIndexEntryInTheMiddle)
+{
+    writeMessages(1, 30);
+
+    // point message 10's entry (offset field at byte 8) far past its segment
+    {
+        std::fstream index("./data/SENDER-TARGET.index", std::ios::in | std::ios::out | std::ios::binary);
+        const uint64_t offset = uint64_t(1) << 40;
+        index.seekp(9 * 24 + 8);
+        index.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    }
+
+    FileStore store;
+    auto handle = store.createStore(m_settings);
+    handle.load();
+
+    const auto all = read(handle, 1, 0);
+    ASSERT_EQ(all.size(), 29u);
+    EXPECT_EQ(all.count(10), 0u);
+    EXPECT_EQ(all.at(11), payload(11));
+    EXPECT_EQ(all.at(30), payload(30));
+}
+
+TEST_F(FileStoreTest, LaterRecordsWin)
+{
+    {
+        FileStore store;
+        store.start();
+        auto handle = store.createStore(m_settings);
+        handle.load();
+        handle.store(1, payload(1));
+        handle.store(2, payload(2));
+        handle.store(2, payload(200));
+        handle.store(3, payload(3));
+        store.stop();
+
+        const auto all = read(handle, 1, 0);
+        ASSERT_EQ(all.size(), 3u);
+        EXPECT_EQ(all.at(2), payload(200));
+    }
+
+    FileStore store;
+    auto handle = store.createStore(m_settings);
+    handle.load();
+    EXPECT_EQ(read(handle, 2, 2).at(2), payload(200));
+}
+
+TEST_F(FileStoreTest, ResetRemovesSegments)
+{
+    writeMessages(1, 50);
+
+    {
+        FileStore store;
+        store.start();
+        auto handle = store.createStore(m_settings);
+        handle.load();
+        handle.reset();
+        handle.store(1, payload(1));
+        store.stop();
+    }
+
+    EXPECT_FALSE(std::filesystem::exists("./data/SENDER-TARGET.2.data"));
+
+    FileStore store;
+    auto handle = store.createStore(m_settings);
+    const auto data = handle.load();
+    EXPECT_EQ(data.m_senderSeqNum, 1);
+
+    const auto all = read(handle, 1, 0);
+    ASSERT_EQ(all.size(), 1u);
+    EXPECT_EQ(all.at(1), payload(1));
+}
+
+TEST_F(FileStoreTest, CompactionKeepsRetainedWindow)
+{
+    m_settings.setLong(SessionSettings::STORE_RETAIN_MESSAGES, 10);
+    m_settings.setLong(SessionSettings::STORE_COMPACT_SEGMENTS, 3);
+
+    {
+        FileStore store;
+        store.start();
+        auto handle = store.createStore(m_settings);
+        handle.load();
+        for (int i = 1; i <= 200; ++i) {
+            handle.store(i, payload(i));
+            // let the writer thread catch up now and then so compactions can finish
+            if (i % 20 == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        store.stop();
+
+        // the newest messages are always readable
+        const auto recent = read(handle, 190, 0);
+        ASSERT_EQ(recent.size(), 11u);
+        EXPECT_EQ(recent.at(200), payload(200));
+    }
+
+    FileStore store;
+    auto handle = store.createStore(m_settings);
+    handle.load();
+
+    // old segments are gone, whether removed after the swap or found unreferenced on load
+    size_t segments = 0;
+    for (const auto& file : std::filesystem::directory_iterator("./data"))
+        segments += file.path().extension() == ".data";
+    EXPECT_LE(segments, 6u);
+
+    const auto all = read(handle, 1, 0);
+    ASSERT_FALSE(all.empty());
+    EXPECT_LT(all.size(), 200u);
+    EXPECT_EQ(all.rbegin()->first, 200);
+    for (const auto& [seqnum, wire] : all)
+        EXPECT_EQ(wire, payload(seqnum));
+
+    // everything from the first retained message on is contiguous
+    int expected = all.begin()->first;
+    for (const auto& [seqnum, _] : all)
+        EXPECT_EQ(seqnum, expected++);
+}
+
+TEST_F(FileStoreTest, CompactionLeavesJournalEntriesInPlace)
+{
+    m_settings.setLong(SessionSettings::STORE_RETAIN_MESSAGES, 10);
+    m_settings.setLong(SessionSettings::STORE_COMPACT_SEGMENTS, 3);
+
+    // own segments, then the journal, then own segments again
+    writeMessages(1, 10);
+    useJournal();
+    writeMessages(11, 20);
+    PlatformSettings::load({{"StoreJournalShards", "0"}, {"StoreJournalSegmentBytes", "1073741824"}});
+    {
+        FileStore store;
+        store.start();
+        auto handle = store.createStore(m_settings);
+        handle.load();
+        for (int i = 21; i <= 200; ++i) {
+            handle.store(i, payload(i));
+            if (i % 20 == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        store.stop();
+    }
+
+    FileStore store;
+    auto handle = store.createStore(m_settings);
+    handle.load();
+
+    // own messages were compacted away, the journal's all survive as they were
+    const auto all = read(handle, 1, 0);
+    EXPECT_LT(all.size(), 190u);
+    EXPECT_EQ(all.count(1), 0u);
+    for (int i = 11; i <= 20; ++i)
+        EXPECT_EQ(all.at(i), payload(i));
+    EXPECT_EQ(all.at(200), payload(200));
+    for (const auto& [seqnum, wire] : all)
+        EXPECT_EQ(wire, payload(seqnum));
+}
+
+TEST_F(FileStoreTest, SyncCallbacksFollowDurability)
+{
+    m_settings.setString(SessionSettings::STORE_DURABILITY, "group");
+
+    FileStore store;
+    store.start();
+    auto handle = store.createStore(m_settings);
+    handle.load();
+    for (int i = 1; i <= 10; ++i)
+        handle.store(i, payload(i));
+
+    std::atomic<bool> synced{false};
+    handle.onSynced(handle.syncTicket(), [&] { synced = true; });
+    for (int i = 0; i < 2000 && !synced; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_TRUE(synced);
+
+    store.stop();
+}
+
+TEST_F(FileStoreTest, EveryMessageDurabilityWaitsForSync)
+{
+    m_settings.setString(SessionSettings::STORE_DURABILITY, "every");
+
+    FileStore store;
+    store.start();
+    auto handle = store.createStore(m_settings);
+    handle.load();
+    handle.store(1, payload(1));
+    handle.waitSynced(handle.syncTicket());
+
+    // the wait only returned once the message was synced, so this runs inline
+    bool synced = false;
+    handle.onSynced(handle.syncTicket(), [&] { synced = true; });
+    EXPECT_TRUE(synced);
+
+    store.stop();
+}
+
+TEST_F(FileStoreTest, DurableStoreNeverReusesSeqNums)
+{
+    m_settings.setString(SessionSettings::STORE_DURABILITY, "group");
+
+    {
+        FileStore store;
+        store.start();
+        auto handle = store.createStore(m_settings);
+        handle.load();
+        for (int i = 1; i <= 10; ++i)
+            handle.store(i, payload(i));
+        // seqnum page lagging behind the synced messages
+        handle.setSeqNums(6, 1);
+        store.stop();
+    }
+
+    FileStore store;
+    auto handle = store.createStore(m_settings);
+    EXPECT_EQ(handle.load().m_senderSeqNum, 11);
+}
+
+TEST_F(FileStoreTest, JournalIsSharedBySessions)
+{
+    useJournal();
+    writeBothSessions(1, 30);
+
+    EXPECT_TRUE(std::filesystem::exists("./data/journal-0.2.data"));
+    EXPECT_TRUE(std::filesystem::exists("./data/journal-0.clean"));
+    EXPECT_FALSE(std::filesystem::exists("./data/SENDER-TARGET.1.data"));
+    EXPECT_FALSE(std::filesystem::exists("./data/SENDER-OTHER.1.data"));
+
+    FileStore store;
+    auto handle = store.createStore(m_settings);
+    auto other = store.createStore(m_other);
+    EXPECT_EQ(handle.load().m_senderSeqNum, 31);
+    EXPECT_EQ(other.load().m_senderSeqNum, 31);
+
+    const auto mine = read(handle, 1, 0);
+    const auto theirs = read(other, 1, 0);
+    ASSERT_EQ(mine.size(), 30u);
+    ASSERT_EQ(theirs.size(), 30u);
+    for (int i = 1; i <= 30; ++i) {
+        EXPECT_EQ(mine.at(i), payload(i));
+        EXPECT_EQ(theirs.at(i), payload(i * 100));
+    }
+}
+
+TEST_F(FileStoreTest, JournalRecoversUnindexedMessages)
+{
+    useJournal();
+    writeBothSessions(1, 20);
+    simulateCrash();
+
+    {
+        FileStore store;
+        store.start();
+        auto handle = store.createStore(m_settings);
+        handle.load();
+        ASSERT_EQ(read(handle, 1, 0).size(), 20u);
+        handle.store(21, payload(21));
+        store.stop();
+    }
+
+    FileStore store;
+    auto handle = store.createStore(m_settings);
+    auto other = store.createStore(m_other);
+    handle.load();
+    other.load();
+    EXPECT_EQ(read(handle, 1, 0).size(), 21u);
+    EXPECT_EQ(read(other, 1, 0).at(20), payload(2000));
+}
+
+TEST_F(FileStoreTest, JournalResetOutlivesRescan)
+{
+    useJournal();
+    writeBothSessions(1, 20);
+
+    {
+        FileStore store;
+        store.start();
+        auto handle = store.createStore(m_settings);
+        handle.load();
+        handle.reset();
+        handle.store(1, payload(1));
+        store.stop();
+    }
+    simulateCrash();
+
+    FileStore store;
+    auto handle = store.createStore(m_settings);
+    auto other = store.createStore(m_other);
+    handle.load();
+    other.load();
+
+    const auto all = read(handle, 1, 0);
+    ASSERT_EQ(all.size(), 1u);
+    EXPECT_EQ(all.at(1), payload(1));
+    EXPECT_EQ(read(other, 1, 0).size(), 20u);
+}
+
+TEST_F(FileStoreTest, JournalKeepsMessagesFromSessionFiles)
+{
+    writeMessages(1, 10);
+
+    useJournal();
+    {
+        FileStore store;
+        store.start();
+        auto handle = store.createStore(m_settings);
+        handle.load();
+        for (int i = 11; i <= 20; ++i)
+            handle.store(i, payload(i));
+        store.stop();
+    }
+
+    FileStore store;
+    auto handle = store.createStore(m_settings);
+    handle.load();
+    const auto all = read(handle, 1, 0);
+    ASSERT_EQ(all.size(), 20u);
+    EXPECT_EQ(all.at(5), payload(5));
+    EXPECT_EQ(all.at(15), payload(15));
+}
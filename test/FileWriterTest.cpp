@@ -0,0 +1,374 @@
+#include <gtest/gtest.h>
+#include <openfix/FileUtils.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const std::string DIR = "./data/FileWriterTest";
+
+class FileWriterTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        std::filesystem::remove_all(DIR);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(DIR);
+    }
+
+    static std::string slurp(const std::string& path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    // writes lines across many writer passes, rotating files part way through
+    static void writeAndRotate(bool ioUring)
+    {
+        FileWriter writer;
+        auto& instance = *writer.createInstance(DIR + "/a.log");
+        writer.start(ioUring);
+
+        for (int i = 0; i < 2000; ++i) {
+            if (i == 1000)
+                instance.reopen(DIR + "/b.log", true);
+            // big enough to skip the registered buffers now and then
+            instance.write(std::to_string(i) + (i % 500 == 0 ? std::string(100 * 1024, 'x') : "") + "\n");
+            if (i % 100 == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        writer.stop();
+    }
+
+    static std::string expected(int first, int last)
+    {
+        std::string ret;
+        for (int i = first; i <= last; ++i)
+            ret += std::to_string(i) + (i % 500 == 0 ? std::string(100 * 1024, 'x') : "") + "\n";
+        return ret;
+    }
+};
+
+}  // namespace
+
+TEST_F(FileWriterTest, WritesInOrder)
+{
+    writeAndRotate(false);
+    EXPECT_EQ(slurp(DIR + "/a.log"), expected(0, 999));
+    EXPECT_EQ(slurp(DIR + "/b.log"), expected(1000, 1999));
+}
+
+TEST_F(FileWriterTest, WritesInOrderThroughIoUring)
+{
+    writeAndRotate(true);
+    EXPECT_EQ(slurp(DIR + "/a.log"), expected(0, 999));
+    EXPECT_EQ(slurp(DIR + "/b.log"), expected(1000, 1999));
+}
+
+TEST_F(FileWriterTest, SyncCallbacksRunOnceSynced)
+{
+    for (const bool ioUring : {false, true}) {
+        FileWriter writer;
+        auto& instance = *writer.createInstance(DIR + "/sync.log");
+        instance.setDurability(Durability::GROUP, std::chrono::milliseconds(0));
+        writer.start(ioUring);
+
+        instance.write("hello\n");
+        const uint64_t ticket = instance.ticket();
+
+        std::atomic<bool> synced{false};
+        instance.onSynced(ticket, [&] { synced = true; });
+        instance.waitSynced(ticket);
+        EXPECT_TRUE(instance.synced(ticket));
+        EXPECT_TRUE(synced);
+
+        writer.stop();
+    }
+}
+
+TEST_F(FileWriterTest, IdleWriterWakesForNewWrites)
+{
+    FileWriter writer;
+    auto& instance = *writer.createInstance(DIR + "/idle.log");
+    writer.start();
+
+    // long enough for the writer to go to sleep
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    instance.write("hello\n");
+    std::atomic<bool> written{false};
+    instance.onSynced(instance.ticket(), [&] { written = true; });
+    for (int i = 0; i < 1000 && !written; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_TRUE(written);
+
+    writer.stop();
+    EXPECT_EQ(slurp(DIR + "/idle.log"), "hello\n");
+}
+
+TEST_F(FileWriterTest, WritesMessageFormats)
+{
+    const std::string msg = "8=FIX.4.2\x01" "35=0\x01" "10=000\x01";
+    const int64_t us = 1700000000123456;
+
+    FileWriter writer;
+    auto& text = *writer.createInstance(DIR + "/m.log", MessageFormat::TEXT);
+    auto& binary = *writer.createInstance(DIR + "/m.bin", MessageFormat::BINARY, "SENDER-TARGET");
+    writer.start();
+    for (int i = 0; i < 3; ++i) {
+        text.writeMessage(us + i, i == 1, msg);
+        binary.writeMessage(us + i, i == 1, msg);
+    }
+    writer.stop();
+
+    std::string expectedText;
+    for (int i = 0; i < 3; ++i)
+        expectedText += Utils::formatTimestampMicros(us + i) + (i == 1 ? " RECV: " : " SENT: ") + "8=FIX.4.2|35=0|10=000|\n";
+    EXPECT_EQ(slurp(DIR + "/m.log"), expectedText);
+
+    const std::string data = slurp(DIR + "/m.bin");
+    std::string_view rest(data);
+    for (int i = 0; i < 3; ++i) {
+        MessageLog::Record record;
+        size_t size;
+        ASSERT_EQ(MessageLog::readBinary(rest, record, size), MessageLog::ReadResult::OK);
+        EXPECT_EQ(record.m_epochUs, us + i);
+        EXPECT_EQ(record.m_inbound, i == 1);
+        EXPECT_EQ(record.m_session, "SENDER-TARGET");
+        EXPECT_EQ(record.m_message, msg);
+        rest.remove_prefix(size);
+    }
+    EXPECT_TRUE(rest.empty());
+}
+
+TEST_F(FileWriterTest, WritesCompressedBlocks)
+{
+    for (const bool ioUring : {false, true}) {
+        const std::string path = DIR + "/c" + std::to_string(ioUring) + ".log.zst";
+
+        FileWriter writer;
+        auto& instance = *writer.createInstance(path);
+        instance.setCompression(4096);
+        writer.start(ioUring);
+
+        std::string expected;
+        for (int i = 0; i < 2000; ++i) {
+            const std::string line = "8=FIX.4.2|9=100|35=D|34=" + std::to_string(i) + "|49=SENDER|56=TARGET|10=000|\n";
+            instance.write(line);
+            expected += line;
+            if (i % 100 == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        writer.stop();
+
+        const std::string data = slurp(path);
+        EXPECT_LT(data.size(), expected.size() / 4);
+
+        std::string whole;
+        BlockDecompressor decompressor;
+        ASSERT_TRUE(decompressor.decompress(data, whole));
+        EXPECT_EQ(whole, expected);
+
+        // every indexed frame decompresses on its own, starting on a line
+        const auto frames = CompressedLog::readIndex(path);
+        ASSERT_GT(frames.size(), 1u);
+        EXPECT_EQ(frames.front(), 0u);
+
+        std::string joined;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            const uint64_t end = i + 1 < frames.size() ? frames[i + 1] : data.size();
+            std::string frame;
+            BlockDecompressor frameDecompressor;
+            ASSERT_TRUE(frameDecompressor.decompress(std::string_view(data).substr(frames[i], end - frames[i]), frame));
+            EXPECT_TRUE(frame.starts_with("8=FIX.4.2|"));
+            joined += frame;
+        }
+        EXPECT_EQ(joined, expected);
+    }
+}
+
+TEST_F(FileWriterTest, CompressedReopenDropsUnfinishedFrame)
+{
+    const std::string path = DIR + "/crash.log.zst";
+    std::filesystem::create_directories(DIR);
+    const auto line = [](int i) { return "line " + std::to_string(i) + " " + std::string(40, 'x') + "\n"; };
+    const auto append = [&](const std::string& data) { std::ofstream(path, std::ios::binary | std::ios::app) << data; };
+
+    // three whole frames of six lines each, then one that's flushed but never
+    // ended, as a crash leaves it
+    {
+        BlockCompressor compressor(256);
+        compressor.open(path, true);
+        std::string out;
+        for (int i = 0; i < 20; ++i)
+            compressor.compress(line(i), out);
+        append(out);
+    }
+    const auto before = CompressedLog::readIndex(path);
+    ASSERT_GT(before.size(), 2u);
+
+    BlockCompressor compressor(256);
+    compressor.open(path, false);
+    std::string out;
+    for (int i = 100; i < 105; ++i)
+        compressor.compress(line(i), out);
+    compressor.finish(out);
+    append(out);
+
+    // the whole file reads back, minus the unfinished frame
+    std::string whole;
+    BlockDecompressor decompressor;
+    ASSERT_TRUE(decompressor.decompress(slurp(path), whole));
+    EXPECT_TRUE(whole.starts_with(line(0)));
+    EXPECT_TRUE(whole.contains(line(17) + line(100)));
+    EXPECT_FALSE(whole.contains(line(18)));
+    EXPECT_TRUE(whole.ends_with(line(104)));
+
+    // the new frame starts where the dropped one did
+    EXPECT_EQ(CompressedLog::readIndex(path), before);
+}
+
+TEST_F(FileWriterTest, RotatesBySizeAndPrunes)
+{
+    const std::string path = DIR + "/r.log";
+
+    RotationPolicy rotation;
+    rotation.m_maxBytes = 4096;
+    rotation.m_retain = 2;
+    rotation.m_compressBlockBytes = 1024;
+
+    FileWriter writer;
+    auto& instance = *writer.createInstance(path);
+    instance.setRotation(rotation);
+    writer.start();
+
+    std::string expected;
+    for (int i = 0; i < 500; ++i) {
+        const std::string line = "line " + std::to_string(i) + " " + std::string(40, 'x') + "\n";
+        instance.write(line);
+        expected += line;
+        if (i % 10 == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // rotated files are compressed and pruned in the background
+    const auto rotated = [&] {
+        std::vector<std::string> ret;
+        for (const auto& entry : std::filesystem::directory_iterator(DIR)) {
+            const std::string name = entry.path().filename().string();
+            if (name.starts_with("r.log.") && name.ends_with(".zst"))
+                ret.push_back(entry.path().string());
+        }
+        std::sort(ret.begin(), ret.end());
+        return ret;
+    };
+    const auto plain = [&] {
+        size_t count = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(DIR)) {
+            const std::string name = entry.path().filename().string();
+            count += name.starts_with("r.log.") && !name.ends_with(".zst") && !name.ends_with(".idx");
+        }
+        return count;
+    };
+    for (int i = 0; i < 2000 && (rotated().size() != 2 || plain() != 0); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    writer.stop();
+
+    const auto files = rotated();
+    ASSERT_EQ(files.size(), 2u);
+    EXPECT_EQ(plain(), 0u);
+
+    // the newest rotated files and the live one pick up where each other left off
+    std::string tail;
+    for (const auto& file : files) {
+        const std::string data = slurp(file);
+        EXPECT_FALSE(CompressedLog::readIndex(file).empty());
+
+        std::string decompressed;
+        BlockDecompressor decompressor;
+        ASSERT_TRUE(decompressor.decompress(data, decompressed));
+        EXPECT_LE(decompressed.size(), rotation.m_maxBytes);
+        tail += decompressed;
+    }
+    const std::string live = slurp(path);
+    EXPECT_LE(live.size(), rotation.m_maxBytes);
+    tail += live;
+    EXPECT_TRUE(expected.ends_with(tail));
+    EXPECT_GT(tail.size(), 2 * rotation.m_maxBytes);
+}
+
+TEST_F(FileWriterTest, RotatesFileWrittenBeforeDailyTime)
+{
+    const std::string path = DIR + "/d.log";
+    std::filesystem::create_directories(DIR);
+    std::ofstream(path) << "yesterday\n";
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now() - std::chrono::hours(48));
+
+    RotationPolicy rotation;
+    rotation.m_dailyAt = 0;
+
+    FileWriter writer;
+    auto& instance = *writer.createInstance(path);
+    instance.setRotation(rotation);
+    writer.start();
+    instance.write("today\n");
+    writer.stop();
+
+    EXPECT_EQ(slurp(path), "today\n");
+    std::vector<std::string> rotated;
+    for (const auto& entry : std::filesystem::directory_iterator(DIR)) {
+        if (entry.path().filename().string().starts_with("d.log."))
+            rotated.push_back(entry.path().string());
+    }
+    ASSERT_EQ(rotated.size(), 1u);
+    EXPECT_EQ(slurp(rotated[0]), "yesterday\n");
+}
+
+TEST_F(FileWriterTest, PreallocatesAndReleasesFiles)
+{
+    constexpr uint64_t RESERVED = 1024 * 1024;
+    const auto allocated = [](const std::string& path) {
+        struct stat st;
+        return ::stat(path.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_blocks) * 512 : 0;
+    };
+
+    FileWriter writer;
+    auto& instance = *writer.createInstance(DIR + "/1.data");
+    instance.setPreallocation(RESERVED);
+    writer.start();
+
+    instance.write("one\n");
+    instance.preallocate(DIR + "/2.data");
+    instance.waitSynced(instance.ticket());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    if (allocated(DIR + "/1.data") < RESERVED)
+        GTEST_SKIP() << "fallocate isn't supported here";
+    EXPECT_GE(allocated(DIR + "/2.data"), RESERVED);
+    EXPECT_EQ(std::filesystem::file_size(DIR + "/2.data"), 0u);
+
+    // the preallocated file keeps its reservation through a truncating reopen,
+    // and the one left behind gives back what it didn't use
+    instance.reopen(DIR + "/2.data", true);
+    instance.write("two\n");
+    writer.stop();
+
+    EXPECT_EQ(slurp(DIR + "/1.data"), "one\n");
+    EXPECT_EQ(slurp(DIR + "/2.data"), "two\n");
+    EXPECT_LT(allocated(DIR + "/1.data"), RESERVED);
+    EXPECT_GE(allocated(DIR + "/2.data"), RESERVED);
+}
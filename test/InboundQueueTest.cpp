@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <openfix/InboundQueue.h>
+
+#include <string>
+
+TEST(InboundQueueTest, PopsInSequence)
+{
+    InboundQueue queue;
+    queue.push(5, "five", 2);
+    queue.push(3, "three", 2);
+    queue.push(4, "four", 2);
+    EXPECT_EQ(queue.size(), 3u);
+
+    std::string wire;
+    EXPECT_FALSE(queue.pop(2, wire));
+
+    ASSERT_TRUE(queue.pop(3, wire));
+    EXPECT_EQ(wire, "three");
+    ASSERT_TRUE(queue.pop(4, wire));
+    EXPECT_EQ(wire, "four");
+    ASSERT_TRUE(queue.pop(5, wire));
+    EXPECT_EQ(wire, "five");
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(InboundQueueTest, DropsStaleEntries)
+{
+    InboundQueue queue;
+    queue.push(10, "ten", 5);
+    queue.push(12, "twelve", 5);
+
+    // a SequenceReset moved us past 10
+    std::string wire;
+    EXPECT_FALSE(queue.pop(11, wire));
+    EXPECT_EQ(queue.size(), 1u);
+    ASSERT_TRUE(queue.pop(12, wire));
+    EXPECT_EQ(wire, "twelve");
+
+    // below the floor is ignored
+    queue.push(3, "three", 20);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(InboundQueueTest, GrowsPastInitialCapacity)
+{
+    InboundQueue queue(64);
+    for (int seqnum = 1000; seqnum > 1; --seqnum)
+        queue.push(seqnum, std::to_string(seqnum), 2);
+    EXPECT_EQ(queue.size(), 999u);
+
+    std::string wire;
+    for (int seqnum = 2; seqnum <= 1000; ++seqnum) {
+        ASSERT_TRUE(queue.pop(seqnum, wire));
+        EXPECT_EQ(wire, std::to_string(seqnum));
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(InboundQueueTest, DuplicateReplacesEntry)
+{
+    InboundQueue queue;
+    queue.push(7, "first", 2);
+    queue.push(7, "second", 2);
+    EXPECT_EQ(queue.size(), 1u);
+
+    std::string wire;
+    ASSERT_TRUE(queue.pop(7, wire));
+    EXPECT_EQ(wire, "second");
+
+    queue.push(9, "nine", 8);
+    queue.clear();
+    EXPECT_FALSE(queue.pop(9, wire));
+}
+
+TEST(InboundQueueTest, IgnoresSeqNumsBeyondWindow)
+{
+    InboundQueue queue(64, 1024);
+    queue.push(5, "five", 2);
+
+    // a hostile or broken counterparty can't make the ring allocate for this
+    EXPECT_FALSE(queue.push(2000000000, "far", 2));
+    EXPECT_FALSE(queue.push(2 + 1024, "edge", 2));
+    EXPECT_LE(queue.capacity(), 1024u);
+    EXPECT_EQ(queue.size(), 1u);
+
+    ASSERT_TRUE(queue.push(2 + 1023, "last", 2));
+    EXPECT_EQ(queue.capacity(), 1024u);
+    ASSERT_TRUE(queue.push(3, "three", 2));
+
+    std::string wire;
+    ASSERT_TRUE(queue.pop(3, wire));
+    EXPECT_EQ(wire, "three");
+    EXPECT_FALSE(queue.pop(4, wire));
+    ASSERT_TRUE(queue.pop(5, wire));
+    EXPECT_EQ(wire, "five");
+    ASSERT_TRUE(queue.pop(1025, wire));
+    EXPECT_EQ(wire, "last");
+    EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <openfix/MessageRing.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string payload(int seqnum, size_t len)
+{
+    std::string ret = std::to_string(seqnum) + ":";
+    ret.resize(len, 'x');
+    return ret;
+}
+
+std::vector<int> seqnums(const MessageRing& ring, int begin = 0, int end = 0)
+{
+    std::vector<int> ret;
+    ring.forEach(begin, end, [&](int seqnum, std::string_view, const WireOffsets&) {
+        ret.push_back(seqnum);
+        return true;
+    });
+    return ret;
+}
+
+}  // namespace
+
+TEST(MessageRingTest, AppendAndLookup)
+{
+    MessageRing ring(8, 1024);
+    for (int i = 1; i <= 5; ++i)
+        ring.append(i, payload(i, 16), {});
+
+    MessageRing::Entry entry;
+    ASSERT_TRUE(ring.get(3, entry));
+    EXPECT_EQ(entry.m_wire, payload(3, 16));
+    EXPECT_FALSE(ring.get(6, entry));
+    EXPECT_FALSE(ring.get(0, entry));
+
+    EXPECT_EQ(seqnums(ring), (std::vector<int>{1, 2, 3, 4, 5}));
+    EXPECT_EQ(seqnums(ring, 2, 4), (std::vector<int>{2, 3, 4}));
+}
+
+TEST(MessageRingTest, SlotWindowEvictsOldest)
+{
+    MessageRing ring(4, 1024);
+    for (int i = 1; i <= 10; ++i)
+        ring.append(i, payload(i, 8), {});
+
+    EXPECT_EQ(ring.firstSeqNum(), 7);
+    EXPECT_EQ(ring.lastSeqNum(), 10);
+    EXPECT_EQ(seqnums(ring), (std::vector<int>{7, 8, 9, 10}));
+}
+
+TEST(MessageRingTest, ByteWindowWrapsAndEvicts)
+{
+    // 100 bytes only holds three 30-byte messages at a time
+    MessageRing ring(64, 100);
+    for (int i = 1; i <= 20; ++i) {
+        ring.append(i, payload(i, 30), {});
+
+        MessageRing::Entry entry;
+        ASSERT_TRUE(ring.get(i, entry));
+        EXPECT_EQ(entry.m_wire, payload(i, 30));
+    }
+
+    const auto held = seqnums(ring);
+    ASSERT_FALSE(held.empty());
+    EXPECT_EQ(held.back(), 20);
+    for (const int seqnum : held) {
+        MessageRing::Entry entry;
+        ASSERT_TRUE(ring.get(seqnum, entry));
+        EXPECT_EQ(entry.m_wire, payload(seqnum, 30));
+    }
+}
+
+TEST(MessageRingTest, RetainedAfterMatchesAppend)
+{
+    MessageRing ring(16, 256);
+    for (int i = 1; i <= 40; ++i) {
+        const size_t len = 10 + (i * 7) % 50;
+        const int predicted = ring.retainedAfter(i, len);
+        ring.append(i, payload(i, len), {});
+        EXPECT_EQ(ring.firstSeqNum(), predicted);
+    }
+}
+
+TEST(MessageRingTest, GapsAndRewind)
+{
+    MessageRing ring(8, 1024);
+    ring.append(1, payload(1, 8), {});
+    ring.append(2, payload(2, 8), {});
+    ring.append(5, payload(5, 8), {});
+    EXPECT_EQ(seqnums(ring), (std::vector<int>{1, 2, 5}));
+
+    // going backwards drops the window
+    ring.append(3, payload(3, 8), {});
+    EXPECT_EQ(seqnums(ring), (std::vector<int>{3}));
+
+    // too large for the arena: nothing held
+    ring.append(4, payload(4, 2048), {});
+    EXPECT_TRUE(ring.empty());
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <openfix/MpscQueue.h>
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+TEST(MpscQueueTest, PopsInPushOrder)
+{
+    MpscQueue<int> queue;
+    EXPECT_TRUE(queue.empty());
+
+    EXPECT_EQ(queue.push(10), 1u);
+    EXPECT_EQ(queue.push(20), 2u);
+
+    int value;
+    uint64_t position;
+    ASSERT_TRUE(queue.pop(value, position));
+    EXPECT_EQ(value, 10);
+    EXPECT_EQ(position, 1u);
+    ASSERT_TRUE(queue.pop(value, position));
+    EXPECT_EQ(value, 20);
+    EXPECT_EQ(position, 2u);
+    EXPECT_FALSE(queue.pop(value, position));
+}
+
+TEST(MpscQueueTest, OrdersPushesAcrossProducers)
+{
+    constexpr int PRODUCERS = 4;
+    constexpr int PER_PRODUCER = 20000;
+
+    MpscQueue<std::pair<int, int>> queue;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p] {
+            for (int i = 0; i < PER_PRODUCER; ++i)
+                queue.push({p, i});
+        });
+    }
+
+    // each producer's items come out in its own order, and positions only
+    // move forward, never past what has actually been popped
+    constexpr uint64_t TOTAL = PRODUCERS * PER_PRODUCER;
+    std::vector<int> next(PRODUCERS, 0);
+    uint64_t popped = 0;
+    uint64_t last = 0;
+    std::pair<int, int> item;
+    uint64_t position;
+    while (popped < TOTAL) {
+        if (!queue.pop(item, position)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ++popped;
+        ASSERT_GE(position, last);
+        ASSERT_LE(position, popped);
+        last = position;
+        ASSERT_EQ(item.second, next[item.first]++);
+    }
+    EXPECT_EQ(last, TOTAL);
+
+    for (auto& producer : producers)
+        producer.join();
+    EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <openfix/Exception.h>
+#include <openfix/SeqNumFile.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+const std::string PATH = "./data/SeqNumFileTest.seqnums";
+
+class SeqNumFileTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        std::filesystem::remove_all("./data");
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all("./data");
+    }
+};
+
+}  // namespace
+
+TEST_F(SeqNumFileTest, PersistsAcrossReopen)
+{
+    int sender = 0, target = 0;
+    {
+        SeqNumFile file(PATH, "SENDER", "TARGET");
+        EXPECT_FALSE(file.read(sender, target));
+
+        file.write(5, 6);
+        file.write(7, 8);
+        ASSERT_TRUE(file.read(sender, target));
+        EXPECT_EQ(sender, 7);
+        EXPECT_EQ(target, 8);
+    }
+
+    SeqNumFile file(PATH, "SENDER", "TARGET");
+    ASSERT_TRUE(file.read(sender, target));
+    EXPECT_EQ(sender, 7);
+    EXPECT_EQ(target, 8);
+}
+
+TEST_F(SeqNumFileTest, TornSlotFallsBackToPrevious)
+{
+    {
+        SeqNumFile file(PATH, "SENDER", "TARGET");
+        file.write(5, 6);
+        file.write(7, 8);
+    }
+
+    // generation 2 lives in the first slot (offset 192); damage its sender seqnum
+    {
+        std::fstream stream(PATH, std::ios::in | std::ios::out | std::ios::binary);
+        stream.seekp(192 + 16);
+        stream.put('\x7f');
+    }
+
+    int sender = 0, target = 0;
+    SeqNumFile file(PATH, "SENDER", "TARGET");
+    ASSERT_TRUE(file.read(sender, target));
+    EXPECT_EQ(sender, 5);
+    EXPECT_EQ(target, 6);
+
+    // the damaged slot is the next one written
+    file.write(9, 10);
+    ASSERT_TRUE(file.read(sender, target));
+    EXPECT_EQ(sender, 9);
+    EXPECT_EQ(target, 10);
+}
+
+TEST_F(SeqNumFileTest, ResetStartsNewIncarnation)
+{
+    SeqNumFile file(PATH, "SENDER", "TARGET");
+    file.write(100, 200);
+    EXPECT_EQ(file.getIncarnation(), 0u);
+
+    file.reset();
+    EXPECT_EQ(file.getIncarnation(), 1u);
+
+    int sender = 0, target = 0;
+    ASSERT_TRUE(file.read(sender, target));
+    EXPECT_EQ(sender, 1);
+    EXPECT_EQ(target, 1);
+}
+
+TEST_F(SeqNumFileTest, RejectsOtherSession)
+{
+    {
+        SeqNumFile file(PATH, "SENDER", "TARGET");
+        file.write(3, 4);
+    }
+
+    EXPECT_THROW(SeqNumFile(PATH, "SENDER", "OTHER"), FileStoreLoadError);
+}
@@ -163,3 +163,203 @@ TEST_F(SessionResendTest, SimultaneousResendRequest)
 
     app.stop();
 }
+
+// recovery covers the requested range exactly once: one GapFill per run of session
+// messages, app messages replayed in order, nothing past the last sent seqnum
+TEST_F(SessionResendTest, RecoveryCoversRangeExactlyOnce)
+{
+    Application app;
+    app.createSession("acceptor", makeAcceptorSettings(port_));
+    app.start();
+
+    RawFIXClient client;
+    ASSERT_TRUE(client.connectWithRetry(port_));
+    ASSERT_TRUE(client.performLogon("INITIATOR", "ACCEPTOR", 1, 30));
+
+    const auto session = app.getSession("acceptor");
+    ASSERT_TRUE(waitFor([&] { return session->getTargetSeqNum() >= 2; }, std::chrono::seconds(3)));
+
+    // seqnums 2-4 are app messages
+    for (int i = 0; i < 3; ++i) {
+        auto msg = session->createMessage("B");
+        msg.getBody().setField(148, "headline " + std::to_string(i));
+        session->send(msg);
+    }
+
+    // seqnum 5 is a Heartbeat answering our TestRequest
+    client.sendMessage("1", 2, {{112, "TEST"}});
+    ASSERT_TRUE(waitFor([&] { return session->getSenderSeqNum() >= 6; }, std::chrono::seconds(3)));
+    client.receiveMessages(std::chrono::milliseconds(500));
+
+    client.sendMessage("2", 3, {{7, "1"}, {16, "0"}});
+
+    const auto msgs = client.receiveMessages(std::chrono::seconds(3));
+
+    std::vector<std::pair<int, int>> covered;
+    for (const auto& m : msgs) {
+        auto tags = RawFIXClient::parseTags(m);
+        EXPECT_EQ(tags[43], "Y");
+        const int seqNum = std::stoi(tags[34]);
+        if (tags[35] == "4") {
+            EXPECT_EQ(tags[123], "Y");
+            covered.emplace_back(seqNum, std::stoi(tags[36]));
+        } else {
+            EXPECT_EQ(tags[35], "B");
+            EXPECT_FALSE(tags[122].empty());
+            covered.emplace_back(seqNum, seqNum + 1);
+        }
+    }
+
+    const std::vector<std::pair<int, int>> expected = {{1, 2}, {2, 3}, {3, 4}, {4, 5}, {5, 6}};
+    EXPECT_EQ(covered, expected);
+
+    app.stop();
+}
+
+// recovery split into single-message chunks still covers the range in order, and
+// a message sent mid-replay is held back until the replay completes
+TEST_F(SessionResendTest, ChunkedRecoveryPreservesOrder)
+{
+    auto settings = makeAcceptorSettings(port_);
+    settings.setLong(SessionSettings::RESEND_BATCH_SIZE, 1);
+    settings.setLong(SessionSettings::RESEND_MAX_BYTES_PER_SEC, 1024 * 1024);
+
+    Application app;
+    app.createSession("acceptor", settings);
+    app.start();
+
+    RawFIXClient client;
+    ASSERT_TRUE(client.connectWithRetry(port_));
+    ASSERT_TRUE(client.performLogon("INITIATOR", "ACCEPTOR", 1, 30));
+
+    const auto session = app.getSession("acceptor");
+    ASSERT_TRUE(waitFor([&] { return session->getTargetSeqNum() >= 2; }, std::chrono::seconds(3)));
+
+    // seqnums 2-11 are app messages
+    for (int i = 0; i < 10; ++i) {
+        auto msg = session->createMessage("B");
+        msg.getBody().setField(148, "headline " + std::to_string(i));
+        session->send(msg);
+    }
+    ASSERT_TRUE(waitFor([&] { return session->getSenderSeqNum() >= 12; }, std::chrono::seconds(3)));
+    client.receiveMessages(std::chrono::milliseconds(500));
+
+    client.sendMessage("2", 2, {{7, "1"}, {16, "0"}});
+
+    std::vector<std::string> msgs;
+    msgs.push_back(client.receiveMessage(std::chrono::seconds(3)));
+    ASSERT_FALSE(msgs.front().empty());
+
+    // seqnum 12, sent while the replay is (most likely) still running
+    auto live = session->createMessage("B");
+    live.getBody().setField(148, "live");
+    session->send(live);
+
+    for (auto& m : client.receiveMessages(std::chrono::seconds(3)))
+        msgs.push_back(std::move(m));
+
+    std::vector<int> seqNums;
+    for (const auto& m : msgs) {
+        auto tags = RawFIXClient::parseTags(m);
+        seqNums.push_back(std::stoi(tags[34]));
+        if (tags[35] == "4")
+            EXPECT_EQ(tags[36], "2");
+    }
+
+    std::vector<int> expected;
+    for (int i = 1; i <= 12; ++i)
+        expected.push_back(i);
+    EXPECT_EQ(seqNums, expected);
+
+    app.stop();
+}
+
+// messages that have fallen out of the in-memory window are replayed from the store
+TEST_F(SessionResendTest, RecoveryReadsBeyondCacheWindowFromStore)
+{
+    auto settings = makeAcceptorSettings(port_);
+    settings.setLong(SessionSettings::CACHE_WINDOW, 2);
+
+    Application app;
+    app.createSession("acceptor", settings);
+    app.start();
+
+    RawFIXClient client;
+    ASSERT_TRUE(client.connectWithRetry(port_));
+    ASSERT_TRUE(client.performLogon("INITIATOR", "ACCEPTOR", 1, 30));
+
+    const auto session = app.getSession("acceptor");
+    ASSERT_TRUE(waitFor([&] { return session->getTargetSeqNum() >= 2; }, std::chrono::seconds(3)));
+
+    // seqnums 2-9 are app messages, only the last two stay in memory
+    for (int i = 0; i < 8; ++i) {
+        auto msg = session->createMessage("B");
+        msg.getBody().setField(148, "headline " + std::to_string(i));
+        session->send(msg);
+    }
+    ASSERT_TRUE(waitFor([&] { return session->getSenderSeqNum() >= 10; }, std::chrono::seconds(3)));
+    client.receiveMessages(std::chrono::milliseconds(500));
+
+    client.sendMessage("2", 2, {{7, "1"}, {16, "0"}});
+
+    std::vector<int> seqNums;
+    for (const auto& m : client.receiveMessages(std::chrono::seconds(3))) {
+        auto tags = RawFIXClient::parseTags(m);
+        seqNums.push_back(std::stoi(tags[34]));
+        if (tags[35] == "B")
+            EXPECT_EQ(tags[43], "Y");
+    }
+
+    std::vector<int> expected;
+    for (int i = 1; i <= 9; ++i)
+        expected.push_back(i);
+    EXPECT_EQ(seqNums, expected);
+
+    app.stop();
+}
+
+// a reconnect during a replay drops what's left of it: the new connection's
+// Logon reply isn't held back behind it, and none of it reaches the new connection
+TEST_F(SessionResendTest, ReconnectAbortsInProgressRecovery)
+{
+    auto settings = makeAcceptorSettings(port_);
+    settings.setLong(SessionSettings::RESEND_BATCH_SIZE, 1);
+    settings.setLong(SessionSettings::RESEND_MAX_BYTES_PER_SEC, 200);
+
+    Application app;
+    app.createSession("acceptor", settings);
+    app.start();
+
+    RawFIXClient client;
+    ASSERT_TRUE(client.connectWithRetry(port_));
+    ASSERT_TRUE(client.performLogon("INITIATOR", "ACCEPTOR", 1, 30));
+
+    const auto session = app.getSession("acceptor");
+    ASSERT_TRUE(waitFor([&] { return session->getTargetSeqNum() >= 2; }, std::chrono::seconds(3)));
+
+    // seqnums 2-11 are app messages, replayed at about one per second
+    for (int i = 0; i < 10; ++i) {
+        auto msg = session->createMessage("B");
+        msg.getBody().setField(148, "headline " + std::to_string(i));
+        session->send(msg);
+    }
+    ASSERT_TRUE(waitFor([&] { return session->getSenderSeqNum() >= 12; }, std::chrono::seconds(3)));
+    client.receiveMessages(std::chrono::milliseconds(500));
+
+    client.sendMessage("2", 2, {{7, "2"}, {16, "0"}});
+    ASSERT_FALSE(client.receiveMessage(std::chrono::seconds(3)).empty());
+
+    client.close();
+    ASSERT_TRUE(waitFor([&] { return !session->getNetwork()->isConnected(); }, std::chrono::seconds(3)));
+
+    RawFIXClient reconnected;
+    ASSERT_TRUE(reconnected.connectWithRetry(port_));
+    ASSERT_TRUE(reconnected.performLogon("INITIATOR", "ACCEPTOR", 3, 30));
+
+    for (const auto& m : reconnected.receiveMessages(std::chrono::milliseconds(1500))) {
+        auto tags = RawFIXClient::parseTags(m);
+        EXPECT_NE(tags[43], "Y") << "replay for the old connection leaked onto the new one";
+    }
+
+    app.stop();
+}
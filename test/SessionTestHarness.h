@@ -398,6 +398,52 @@ protected:
         // Ensure store data doesn't leak into the next test.
         std::filesystem::remove_all("./data");
     }
+
+    // Sends count News (35=B) messages from session, the ith headed
+    // headline(i), or "headline <i>" without one.
+    static void sendBurst(const std::shared_ptr<Session>& session, int count, const std::function<std::string(int)>& headline = {})
+    {
+        for (int i = 0; i < count; ++i) {
+            auto msg = session->createMessage("B");
+            msg.getBody().setField(148, headline ? headline(i) : "headline " + std::to_string(i));
+            session->send(msg);
+        }
+    }
+
+    // Sends a burst from session while client reads it, expecting every
+    // message to arrive, in seqnum order.
+    static void sendBurstAndExpectInOrder(const std::shared_ptr<Session>& session, RawFIXClient& client, int count)
+    {
+        const int first = session->getSenderSeqNum();
+        std::thread sender([&] { sendBurst(session, count); });
+
+        std::vector<int> seqNums;
+        while (seqNums.size() < static_cast<size_t>(count)) {
+            const auto msg = client.receiveMessage(std::chrono::seconds(3));
+            if (msg.empty())
+                break;
+            auto tags = RawFIXClient::parseTags(msg);
+            if (tags[35] == "B")
+                seqNums.push_back(std::stoi(tags[34]));
+        }
+        sender.join();
+
+        std::vector<int> expected(count);
+        for (int i = 0; i < count; ++i)
+            expected[i] = first + i;
+        EXPECT_EQ(seqNums, expected);
+    }
+
+    // The same between two sessions: receiver takes in the whole burst
+    // without losing its connection.
+    static void sendBurstAndExpectInOrder(const std::shared_ptr<Session>& sender, const std::shared_ptr<Session>& receiver, int count,
+                                          const std::function<std::string(int)>& headline = {})
+    {
+        const int expected = receiver->getTargetSeqNum() + count;
+        sendBurst(sender, count, headline);
+        EXPECT_TRUE(waitFor([&] { return receiver->getTargetSeqNum() == expected; }, std::chrono::seconds(5)));
+        EXPECT_TRUE(sender->getNetwork()->isConnected());
+    }
 };
 
 }  // namespace fix_test
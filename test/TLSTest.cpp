@@ -1,5 +1,7 @@
 #include "SessionTestHarness.h"
 
+#include <atomic>
+
 using namespace fix_test;
 
 namespace
@@ -121,3 +123,117 @@ TEST_F(TLSTest, ConnectsWithMutualTLSWhenClientCertificateProvided)
 
     app.stop();
 }
+
+// a burst coalesced into full records, including a message larger than one,
+// arrives whole and in order
+TEST_F(TLSTest, BurstOfMessagesArrivesInOrder)
+{
+    constexpr int COUNT = 2000;
+
+    Application app;
+    auto acceptor = makeAcceptorSettings(port_);
+    acceptor.setBool(SessionSettings::TLS_ENABLED, true);
+    acceptor.setBool(SessionSettings::TLS_VERIFY_PEER, false);
+    acceptor.setString(SessionSettings::TLS_CERT_FILE, kServerCertPath);
+    acceptor.setString(SessionSettings::TLS_KEY_FILE, kServerKeyPath);
+
+    auto initiator = makeInitiatorSettings(port_);
+    initiator.setBool(SessionSettings::TLS_ENABLED, true);
+    initiator.setBool(SessionSettings::TLS_VERIFY_PEER, true);
+    initiator.setString(SessionSettings::TLS_CA_FILE, kCAPath);
+
+    app.createSession("acceptor", acceptor);
+    app.createSession("initiator", initiator);
+    app.start();
+
+    const auto acceptorSession = app.getSession("acceptor");
+    const auto initiatorSession = app.getSession("initiator");
+    ASSERT_TRUE(waitFor([&]() { return acceptorSession->getTargetSeqNum() >= 2; }, std::chrono::seconds(3)));
+
+    sendBurstAndExpectInOrder(initiatorSession, acceptorSession, COUNT,
+                              [](int i) { return i == COUNT / 2 ? std::string(20000, 'x') : "headline " + std::to_string(i); });
+
+    app.stop();
+}
+
+// TLS writes always go through the reader's write queue, so a burst of sends
+// across connections sharing a reader costs at most one eventfd write, and
+// the flush it triggers visits only the connections that were written to
+TEST_F(TLSTest, BurstAcrossConnectionsWakesReaderOnce)
+{
+    constexpr int PAIRS = 3;
+    constexpr int COUNT = 100;
+
+    Application app;
+    for (int i = 1; i <= PAIRS; ++i) {
+        const auto n = std::to_string(i);
+        auto acceptor = makeAcceptorSettings(port_);
+        acceptor.setString(SessionSettings::SENDER_COMP_ID, "ACCEPTOR" + n);
+        acceptor.setString(SessionSettings::TARGET_COMP_ID, "INITIATOR" + n);
+        acceptor.setLong(SessionSettings::HEARTBEAT_INTERVAL, 30);
+        acceptor.setBool(SessionSettings::TLS_ENABLED, true);
+        acceptor.setBool(SessionSettings::TLS_VERIFY_PEER, false);
+        acceptor.setString(SessionSettings::TLS_CERT_FILE, kServerCertPath);
+        acceptor.setString(SessionSettings::TLS_KEY_FILE, kServerKeyPath);
+
+        auto initiator = makeInitiatorSettings(port_);
+        initiator.setString(SessionSettings::SENDER_COMP_ID, "INITIATOR" + n);
+        initiator.setString(SessionSettings::TARGET_COMP_ID, "ACCEPTOR" + n);
+        initiator.setLong(SessionSettings::HEARTBEAT_INTERVAL, 30);
+        initiator.setBool(SessionSettings::TLS_ENABLED, true);
+        initiator.setBool(SessionSettings::TLS_VERIFY_PEER, true);
+        initiator.setString(SessionSettings::TLS_CA_FILE, kCAPath);
+
+        app.createSession("acceptor" + n, acceptor);
+        app.createSession("initiator" + n, initiator);
+    }
+    app.start();
+
+    for (int i = 1; i <= PAIRS; ++i) {
+        const auto acceptorSession = app.getSession("acceptor" + std::to_string(i));
+        ASSERT_TRUE(waitFor([&]() { return acceptorSession->getTargetSeqNum() >= 2; }, std::chrono::seconds(3)));
+    }
+
+    // every connection is on the one reader
+    const auto readerStats = [&] {
+        const auto readers = app.getReaderStats();
+        return readers.size() == 1 ? readers.front() : ReaderStats();
+    };
+    ASSERT_EQ(readerStats().m_connections, 2u * PAIRS);
+
+    // hold the reader in the send callback of a message from the first
+    // initiator, so the burst queues up behind it
+    std::atomic<bool> held{false};
+    std::atomic<bool> released{false};
+    auto hold = app.getSession("initiator1")->createMessage("B");
+    hold.getBody().setField(148, "hold");
+    app.getSession("initiator1")->send(hold, [&] {
+        held = true;
+        while (!released)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    });
+    const bool wasHeld = waitFor([&]() { return held.load(); }, std::chrono::seconds(3));
+
+    const auto before = readerStats();
+    for (int i = 2; i <= PAIRS; ++i) {
+        const auto session = app.getSession("initiator" + std::to_string(i));
+        for (int j = 0; j < COUNT; ++j) {
+            auto msg = session->createMessage("B");
+            msg.getBody().setField(148, "headline " + std::to_string(j));
+            session->send(msg);
+        }
+    }
+    const auto queued = readerStats();
+    released = true;
+
+    ASSERT_TRUE(wasHeld);
+    EXPECT_LE(queued.m_wakeups - before.m_wakeups, 1u);
+
+    for (int i = 2; i <= PAIRS; ++i) {
+        const auto acceptorSession = app.getSession("acceptor" + std::to_string(i));
+        EXPECT_TRUE(waitFor([&]() { return acceptorSession->getTargetSeqNum() == COUNT + 2; }, std::chrono::seconds(5)));
+    }
+    EXPECT_EQ(readerStats().m_flushes - before.m_flushes, static_cast<uint64_t>(PAIRS - 1));
+
+    app.stop();
+}
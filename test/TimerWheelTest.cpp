@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <openfix/TimerWheel.h>
+
+#include <random>
+#include <vector>
+
+TEST(TimerWheelTest, FiresAtDeadline)
+{
+    TimerWheel<int> wheel(1000);
+    EXPECT_EQ(wheel.nextDeadline(), TimerWheel<int>::NONE);
+
+    wheel.schedule(1010, 1);
+    wheel.schedule(1005, 2);
+    EXPECT_EQ(wheel.nextDeadline(), 1005);
+
+    std::vector<int> fired;
+    const auto collect = [&](int value) { fired.push_back(value); };
+
+    wheel.advance(1004, collect);
+    EXPECT_TRUE(fired.empty());
+
+    wheel.advance(1005, collect);
+    EXPECT_EQ(fired, std::vector<int>{2});
+    EXPECT_EQ(wheel.nextDeadline(), 1010);
+
+    wheel.advance(2000, collect);
+    EXPECT_EQ(fired, (std::vector<int>{2, 1}));
+    EXPECT_TRUE(wheel.empty());
+
+    // already past: fires on the next advance, even without time moving
+    wheel.schedule(1500, 3);
+    EXPECT_EQ(wheel.nextDeadline(), 2000);
+    wheel.advance(2000, collect);
+    EXPECT_EQ(fired.back(), 3);
+}
+
+TEST(TimerWheelTest, CascadesFromHigherLevels)
+{
+    std::mt19937_64 rng(42);
+    const int64_t start = 123456789;
+    TimerWheel<int64_t> wheel(start);
+
+    // spread over the first three levels
+    std::vector<int64_t> deadlines;
+    for (int i = 0; i < 2000; ++i) {
+        const int64_t deadline = start + 1 + static_cast<int64_t>(rng() % 5000000);
+        deadlines.push_back(deadline);
+        wheel.schedule(deadline, deadline);
+    }
+
+    // never fires late or early, whatever steps time moves in
+    int64_t now = start;
+    size_t fired = 0;
+    while (!wheel.empty()) {
+        const int64_t next = wheel.nextDeadline();
+        ASSERT_GT(next, now);
+        now = (rng() % 2) ? next : now + static_cast<int64_t>(rng() % 3000) + 1;
+        wheel.advance(now, [&](int64_t deadline) {
+            EXPECT_LE(deadline, now);
+            EXPECT_GT(deadline, now - 3001);
+            ++fired;
+        });
+    }
+    EXPECT_EQ(fired, deadlines.size());
+}
+
+TEST(TimerWheelTest, SchedulesFromCallback)
+{
+    TimerWheel<int> wheel(0);
+    wheel.schedule(10, 0);
+
+    // a periodic timer reschedules itself as it fires
+    int64_t now = 0;
+    int ticks = 0;
+    while (ticks < 5) {
+        now = wheel.nextDeadline();
+        wheel.advance(now, [&](int value) {
+            ++ticks;
+            wheel.schedule(now + 300, value);
+        });
+    }
+    EXPECT_EQ(now, 10 + 4 * 300);
+    EXPECT_EQ(wheel.size(), 1u);
+}
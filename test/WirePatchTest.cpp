@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <openfix/Dictionary.h>
+#include <openfix/Fields.h>
+#include <openfix/Message.h>
+#include <openfix/WirePatch.h>
+
+class WirePatchTest : public ::testing::Test
+{
+protected:
+    WirePatchTest()
+    {
+        dict = DictionaryRegistry::instance().load("test/FIXDictionary.xml");
+    }
+
+    std::string buildWire(bool withPossDup = false, bool withOrigSendingTime = false)
+    {
+        auto msg = dict->create("D");
+        auto& header = msg.getHeader();
+        header.setField(FIELD::BeginString, "FIX.4.2", false);
+        header.setField(FIELD::SenderCompID, "SENDER", false);
+        header.setField(FIELD::TargetCompID, "TARGET", false);
+        header.setField(FIELD::SendingTime, "20240101-12:00:00.000", false);
+        header.setField(FIELD::MsgSeqNum, 42, false);
+        if (withPossDup)
+            header.setField(FIELD::PossDupFlag, "N");
+        if (withOrigSendingTime)
+            header.setField(FIELD::OrigSendingTime, "20231231-00:00:00.000");
+        msg.getBody().setField(11, "ORDER1");
+        msg.getBody().setField(55, "AAPL");
+        return msg.toString(true);
+    }
+
+    void verifyPatched(const std::string& wire)
+    {
+        WireOffsets offsets;
+        ASSERT_TRUE(scanWireOffsets(wire, *dict->getHeaderSpec(), offsets));
+
+        std::string out;
+        patchForResend(wire, offsets, "20240102-08:30:00.123", out);
+
+        // parse() validates BodyLength and CheckSum
+        SessionSettings settings;
+        Message parsed;
+        ASSERT_NO_THROW(parsed = dict->parse(settings, out));
+
+        EXPECT_EQ(parsed.getHeader().getField(FIELD::PossDupFlag), "Y");
+        EXPECT_EQ(parsed.getHeader().getField(FIELD::OrigSendingTime), "20240101-12:00:00.000");
+        EXPECT_EQ(parsed.getHeader().getField(FIELD::SendingTime), "20240102-08:30:00.123");
+        EXPECT_EQ(parsed.getHeader().getIntField(FIELD::MsgSeqNum), 42);
+        EXPECT_EQ(parsed.getBody().getField(11), "ORDER1");
+        EXPECT_EQ(parsed.getBody().getField(55), "AAPL");
+    }
+
+    std::shared_ptr<Dictionary> dict;
+};
+
+TEST_F(WirePatchTest, ScanOffsets)
+{
+    const auto wire = buildWire();
+
+    WireOffsets offsets;
+    ASSERT_TRUE(scanWireOffsets(wire, *dict->getHeaderSpec(), offsets));
+    EXPECT_EQ(offsets.msgType(wire), "D");
+    EXPECT_EQ(offsets.sendingTime(wire), "20240101-12:00:00.000");
+    EXPECT_EQ(offsets.m_possDupFlag, 0u);
+    EXPECT_EQ(offsets.m_origSendingTime, 0u);
+    EXPECT_EQ(wire.substr(offsets.m_checksum - 3, 3), "10=");
+}
+
+TEST_F(WirePatchTest, ScanRejectsMalformed)
+{
+    WireOffsets offsets;
+    EXPECT_FALSE(scanWireOffsets("8=FIX.4.2\x01" "9=5\x01" "35=0\x01", *dict->getHeaderSpec(), offsets));
+    EXPECT_FALSE(scanWireOffsets("", *dict->getHeaderSpec(), offsets));
+}
+
+TEST_F(WirePatchTest, InsertsResendFields)
+{
+    verifyPatched(buildWire());
+}
+
+TEST_F(WirePatchTest, ReplacesExistingResendFields)
+{
+    verifyPatched(buildWire(true, true));
+}
+
+TEST_F(WirePatchTest, BodyLengthChangesWidth)
+{
+    // push BodyLength across a digit boundary so the prefix itself changes size
+    auto msg = dict->create("D");
+    auto& header = msg.getHeader();
+    header.setField(FIELD::BeginString, "FIX.4.2", false);
+    header.setField(FIELD::SenderCompID, "S", false);
+    header.setField(FIELD::TargetCompID, "T", false);
+    header.setField(FIELD::SendingTime, "20240101-12:00:00.000", false);
+    header.setField(FIELD::MsgSeqNum, 1, false);
+    msg.getBody().setField(11, std::string(30, 'X'));
+
+    const auto wire = msg.toString(true);
+    WireOffsets offsets;
+    ASSERT_TRUE(scanWireOffsets(wire, *dict->getHeaderSpec(), offsets));
+    ASSERT_EQ(offsets.m_bodyLengthLen, 2u);
+
+    std::string out;
+    patchForResend(wire, offsets, "20240102-08:30:00.123", out);
+
+    SessionSettings settings;
+    Message parsed;
+    ASSERT_NO_THROW(parsed = dict->parse(settings, out));
+    EXPECT_EQ(parsed.getHeader().getField(FIELD::PossDupFlag), "Y");
+    EXPECT_EQ(parsed.getBody().getField(11), std::string(30, 'X'));
+}
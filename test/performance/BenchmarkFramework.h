@@ -243,6 +243,7 @@ inline void printResults(const std::vector<BenchmarkResult>& results,
             << "  - Serialize:  generic message build + setField() + toString(), no network I/O\n"
             << "  - Network:    full-stack ingestion: parse + seq validation + store + dispatch\n"
             << "  - RoundTrip:  TestRequest(35=1) -> Heartbeat(35=0) response, full network path\n"
+            << "  - Store:      store() until durable per StoreDurability mode; bulk waits once at the end\n"
             << "  - Latency in microseconds; '-' = not applicable for this benchmark type\n";
     } else {
         std::cout
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <openfix/FIXStore.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkFixtures.h"
+#include "BenchmarkFramework.h"
+
+namespace perf {
+
+// Cost of each StoreDurability mode as seen by a sender: latency from store()
+// until the message is durable (written out, for none), and bulk throughput
+// with a single wait at the end.
+inline std::vector<BenchmarkResult> runStoreDurabilityBenchmarks()
+{
+    const std::vector<std::string> modes = {"none", "periodic", "group", "every"};
+    const std::string payload(200, 'A');
+
+    bench::resetOpenfixStoreDir();
+
+    std::vector<BenchmarkResult> results;
+    for (const auto& mode : modes) {
+        SessionSettings settings;
+        settings.setString(SessionSettings::SENDER_COMP_ID, "DURABILITY");
+        settings.setString(SessionSettings::TARGET_COMP_ID, mode);
+        settings.setString(SessionSettings::STORE_DURABILITY, mode);
+        settings.setLong(SessionSettings::STORE_SYNC_INTERVAL, 5L);
+
+        FileStore store;
+        store.start();
+        auto handle = store.createStore(settings);
+        handle.load();
+
+        int seqnum = 0;
+        const auto waitSynced = [&] {
+            std::atomic<bool> synced{false};
+            handle.onSynced(handle.syncTicket(), [&] { synced.store(true, std::memory_order_release); });
+            while (!synced.load(std::memory_order_acquire))
+                std::this_thread::yield();
+        };
+
+        results.push_back(run("StoreSync/" + mode, /*warmup=*/50, /*measure=*/1'000, [&] {
+            handle.store(++seqnum, payload);
+            waitSynced();
+        }));
+
+        constexpr int bulk = 20'000;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < bulk; ++i) {
+            handle.store(++seqnum, payload);
+            // as MemoryCache does for every-message durability
+            if (mode == "every")
+                handle.waitSynced(handle.syncTicket());
+        }
+        waitSynced();
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        results.push_back(throughputResult("StoreBulk/" + mode, bulk, elapsed));
+
+        store.stop();
+    }
+
+    bench::resetOpenfixStoreDir();
+    return results;
+}
+
+} // namespace perf
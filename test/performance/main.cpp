@@ -12,6 +12,7 @@
 #include "MultilegRoundTripBenchmark.h"
 #include "RoundTripBenchmark.h"
 #include "SessionTestHarness.h"
+#include "StoreDurabilityBenchmark.h"
 
 int main(int argc, char** argv)
 {
@@ -50,6 +51,7 @@ int main(int argc, char** argv)
         append(perf::runNetworkThroughputBenchmarks());
         append(perf::runRoundTripBenchmarks());
         append(perf::runMultilegRoundTripBenchmarks());
+        append(perf::runStoreDurabilityBenchmarks());
     }
 
     perf::printResults(results);
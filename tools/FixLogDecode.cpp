@@ -0,0 +1,340 @@
+// Renders binary message logs (LogFormat=binary) in the text log format,
+// compressed (LogCompression=zstd) or not.
+//
+//   bazel run //tools:fixlog-decode -- [options] <file>...
+//
+//   --from <time>     skip messages before time (YYYYMMDD-HH:MM:SS[.fff], UTC);
+//                     compressed logs seek straight to it through their index
+//   --to <time>       skip messages after time
+//   --type <MsgType>  only messages of this MsgType(35); repeatable or comma separated
+//   --session <id>    only messages of this session (<Sender>-<Target>)
+//   -f, --follow      keep printing messages as they're appended, picking up
+//                     files that are replaced or truncated
+//
+// With more than one file, each line starts with the message's session.
+
+#include <openfix/CompressedLog.h>
+#include <openfix/MessageLog.h>
+#include <openfix/Utils.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+struct Options
+{
+    int64_t m_fromUs = 0;
+    int64_t m_toUs = 0;  // 0 = no limit
+    std::unordered_set<std::string> m_types;
+    std::string m_session;
+    bool m_follow = false;
+    std::vector<std::string> m_files;
+};
+
+// one input file, read incrementally so it can be followed
+struct Input
+{
+    std::string m_path;
+    int m_fd = -1;
+    ino_t m_inode = 0;
+    // decoded bytes not yet printed
+    std::string m_buffer;
+    // set once the file turns out to be compressed
+    std::unique_ptr<BlockDecompressor> m_decompressor;
+    bool m_sniffed = false;
+};
+
+[[noreturn]] void usage(const char* error = nullptr)
+{
+    if (error)
+        std::fprintf(stderr, "fixlog-decode: %s\n", error);
+    std::fprintf(stderr,
+                 "usage: fixlog-decode [--from <time>] [--to <time>] [--type <MsgType>]... [--session <id>] [-f|--follow] <file>...\n"
+                 "  times are UTC, YYYYMMDD-HH:MM:SS[.fff]\n");
+    std::exit(2);
+}
+
+int64_t parseTime(const char* value)
+{
+    const std::string_view time(value);
+    const long ms = Utils::parseUTCTimestamp(time);
+    if (ms == 0)
+        usage(("bad time: " + std::string(time)).c_str());
+    return static_cast<int64_t>(ms) * 1000;
+}
+
+Options parseOptions(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+        const auto value = [&]() -> const char* {
+            if (i + 1 >= argc)
+                usage(("missing value for " + std::string(arg)).c_str());
+            return argv[++i];
+        };
+
+        if (arg == "--from") {
+            options.m_fromUs = parseTime(value());
+        } else if (arg == "--to") {
+            options.m_toUs = parseTime(value());
+        } else if (arg == "--type") {
+            std::string_view types(value());
+            while (!types.empty()) {
+                const size_t comma = types.find(',');
+                if (comma != 0)
+                    options.m_types.emplace(types.substr(0, comma));
+                types = comma == std::string_view::npos ? std::string_view() : types.substr(comma + 1);
+            }
+        } else if (arg == "--session") {
+            options.m_session = value();
+        } else if (arg == "-f" || arg == "--follow") {
+            options.m_follow = true;
+        } else if (arg == "-h" || arg == "--help") {
+            usage();
+        } else if (arg.starts_with("-") && arg.size() > 1) {
+            usage(("unknown option " + std::string(arg)).c_str());
+        } else {
+            options.m_files.emplace_back(arg);
+        }
+    }
+
+    if (options.m_files.empty())
+        usage("no files given");
+
+    // bazel run starts us in the runfiles tree; relative paths mean the caller's directory
+    if (const char* cwd = std::getenv("BUILD_WORKING_DIRECTORY")) {
+        for (auto& file : options.m_files) {
+            if (!file.starts_with("/"))
+                file = std::string(cwd) + "/" + file;
+        }
+    }
+    return options;
+}
+
+std::string_view msgType(std::string_view message)
+{
+    size_t pos = message.starts_with("35=") ? 0 : message.find("\x01" "35=");
+    if (pos == std::string_view::npos)
+        return {};
+    pos += message[pos] == '\x01' ? 4 : 3;
+
+    const size_t end = message.find('\x01', pos);
+    return message.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+}
+
+bool matches(const Options& options, const MessageLog::Record& record)
+{
+    if (record.m_epochUs < options.m_fromUs || (options.m_toUs != 0 && record.m_epochUs > options.m_toUs))
+        return false;
+    if (!options.m_session.empty() && record.m_session != options.m_session)
+        return false;
+    if (!options.m_types.empty() && !options.m_types.contains(std::string(msgType(record.m_message))))
+        return false;
+    return true;
+}
+
+void restart(Input& input)
+{
+    input.m_buffer.clear();
+    input.m_decompressor.reset();
+    input.m_sniffed = false;
+}
+
+// Epoch of the first record in the compressed frame at offset; false if it
+// can't be read from the frame's first few KB
+bool firstEpoch(int fd, uint64_t offset, int64_t& epochUs)
+{
+    char chunk[16 * 1024];
+    const ssize_t n = ::pread(fd, chunk, sizeof(chunk), static_cast<off_t>(offset));
+    if (n <= 0 || !CompressedLog::isCompressed({chunk, static_cast<size_t>(n)}))
+        return false;
+
+    // a frame cut short still gives up what was flushed of it
+    std::string raw;
+    BlockDecompressor decompressor;
+    decompressor.decompress({chunk, static_cast<size_t>(n)}, raw);
+
+    MessageLog::Record record;
+    size_t size;
+    if (MessageLog::readBinary(raw, record, size) != MessageLog::ReadResult::OK)
+        return false;
+    epochUs = record.m_epochUs;
+    return true;
+}
+
+// Moves a compressed log to the last indexed frame starting before fromUs.
+// Frames whose first record can't be read count as later, so this errs early.
+void seekFrame(Input& input, int64_t fromUs)
+{
+    const auto frames = CompressedLog::readIndex(input.m_path);
+    size_t lo = 0;
+    size_t hi = frames.size();
+    while (hi - lo > 1) {
+        const size_t mid = lo + (hi - lo) / 2;
+        int64_t epochUs;
+        if (firstEpoch(input.m_fd, frames[mid], epochUs) && epochUs <= fromUs)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    if (lo > 0)
+        ::lseek(input.m_fd, static_cast<off_t>(frames[lo]), SEEK_SET);
+}
+
+// (Re)opens the file if it was rotated or replaced; false if it isn't there
+bool openInput(Input& input)
+{
+    struct stat st;
+    if (::stat(input.m_path.c_str(), &st) != 0)
+        return input.m_fd >= 0;
+    if (input.m_fd >= 0 && st.st_ino == input.m_inode) {
+        // truncated underneath us (a session reset); start over
+        if (st.st_size < ::lseek(input.m_fd, 0, SEEK_CUR)) {
+            ::lseek(input.m_fd, 0, SEEK_SET);
+            restart(input);
+        }
+        return true;
+    }
+
+    const int fd = ::open(input.m_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return input.m_fd >= 0;
+
+    // whatever the old file still held has been read by now
+    if (input.m_fd >= 0)
+        ::close(input.m_fd);
+    input.m_fd = fd;
+    input.m_inode = st.st_ino;
+    restart(input);
+    return true;
+}
+
+// Prints every complete record read from input; returns false on a corrupt record
+bool drain(const Options& options, Input& input, bool showSession, bool& readAny)
+{
+    std::string line;
+    char chunk[64 * 1024];
+    for (;;) {
+        const ssize_t n = ::read(input.m_fd, chunk, sizeof(chunk));
+        if (n <= 0)
+            return true;
+        readAny = true;
+
+        if (input.m_decompressor) {
+            if (!input.m_decompressor->decompress({chunk, static_cast<size_t>(n)}, input.m_buffer)) {
+                std::fprintf(stderr, "fixlog-decode: %s: corrupt compressed data\n", input.m_path.c_str());
+                return false;
+            }
+        } else {
+            input.m_buffer.append(chunk, static_cast<size_t>(n));
+
+            // a compressed file gives itself away in its first four bytes
+            if (!input.m_sniffed) {
+                if (input.m_buffer.size() < sizeof(uint32_t))
+                    continue;
+                input.m_sniffed = true;
+
+                if (CompressedLog::isCompressed(input.m_buffer)) {
+                    const std::string compressed = std::move(input.m_buffer);
+                    input.m_buffer.clear();
+                    input.m_decompressor = std::make_unique<BlockDecompressor>();
+                    if (!input.m_decompressor->decompress(compressed, input.m_buffer)) {
+                        std::fprintf(stderr, "fixlog-decode: %s: corrupt compressed data\n", input.m_path.c_str());
+                        return false;
+                    }
+                }
+            }
+        }
+
+        size_t pos = 0;
+        MessageLog::Record record;
+        size_t size;
+        for (;;) {
+            const auto result = MessageLog::readBinary(std::string_view(input.m_buffer).substr(pos), record, size);
+            if (result == MessageLog::ReadResult::INCOMPLETE)
+                break;
+            if (result == MessageLog::ReadResult::CORRUPT) {
+                std::fprintf(stderr, "fixlog-decode: %s: corrupt record\n", input.m_path.c_str());
+                return false;
+            }
+            pos += size;
+
+            if (!matches(options, record))
+                continue;
+
+            line.clear();
+            if (showSession) {
+                line += record.m_session;
+                line += ' ';
+            }
+            MessageLog::appendText(line, record, true);
+            std::fwrite(line.data(), 1, line.size(), stdout);
+        }
+        input.m_buffer.erase(0, pos);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const Options options = parseOptions(argc, argv);
+
+    std::vector<Input> inputs;
+    for (const auto& file : options.m_files) {
+        Input input;
+        input.m_path = file;
+        if (!openInput(input) && !options.m_follow) {
+            std::fprintf(stderr, "fixlog-decode: %s: %s\n", file.c_str(), std::strerror(errno));
+            return 1;
+        }
+        if (input.m_fd >= 0 && options.m_fromUs != 0)
+            seekFrame(input, options.m_fromUs);
+        inputs.push_back(std::move(input));
+    }
+
+    const bool showSession = inputs.size() > 1;
+    int ret = 0;
+    for (;;) {
+        bool readAny = false;
+        for (auto& input : inputs) {
+            if (!openInput(input))
+                continue;
+            if (!drain(options, input, showSession, readAny)) {
+                ret = 1;
+                if (!options.m_follow)
+                    return ret;
+                // skip past the damage to whatever gets appended next
+                input.m_buffer.clear();
+                if (input.m_decompressor)
+                    input.m_decompressor->reset();
+            }
+        }
+        std::fflush(stdout);
+
+        if (!options.m_follow)
+            break;
+        if (!readAny)
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    for (auto& input : inputs) {
+        if (input.m_fd >= 0)
+            ::close(input.m_fd);
+    }
+    return ret;
+}